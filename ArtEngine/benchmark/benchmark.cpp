@@ -0,0 +1,345 @@
+#include "../include/pch.h"
+#include "benchmark.h"
+
+namespace bench
+{
+
+static std::vector<Case> registry; // registered cases in registration order
+static size_t failed = 0;          // expectations of the cases that did not hold
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// percentile of sorted samples with linear interpolation between ranks
+static double percentile(std::vector<double> const &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    double const rank = p * static_cast<double>(sorted.size() - 1);
+    size_t const low = static_cast<size_t>(rank);
+    size_t const high = std::min(low + 1, sorted.size() - 1);
+    return sorted[low] + (rank - static_cast<double>(low)) * (sorted[high] - sorted[low]);
+}
+
+// numeric field of a result line written by write_json
+static double field(std::string const &line, std::string const &name)
+{
+    std::smatch match;
+    std::regex const pattern("\"" + name + "\":\\s*([-+0-9.eE]+)");
+    if (!std::regex_search(line, match, pattern))
+        return 0.0;
+    return std::stod(match[1]);
+}
+
+// string field of a result line written by write_json
+static std::string text(std::string const &line, std::string const &name)
+{
+    std::smatch match;
+    std::regex const pattern("\"" + name + "\":\\s*\"([^\"]*)\"");
+    if (!std::regex_search(line, match, pattern))
+        return "";
+    return match[1];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// REGISTRATION
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: add
+
+\summary:  register a named case
+
+\args:     name - unique case name, grouped by a prefix (group/case)
+\args:     function - timed function, returns the number of processed items
+\args:     unit - unit of the processed items
+\args:     iterations - timed iterations, zero uses the harness default
+************************************************************************//*F-F*/
+void add(std::string name, std::function<size_t()> function, std::string unit, int iterations)
+{
+    registry.push_back({name, function, unit, iterations});
+}
+
+std::vector<Case> const &cases()
+{
+    return registry;
+}
+
+/*F+F***********************************************************************//*!
+\function: expect
+
+\summary:  check a result of a case, a failed expectation is logged and makes
+           the harness exit with an error like a regression
+
+\args:     condition - expectation that has to hold
+\args:     message - reported when it does not
+************************************************************************//*F-F*/
+void expect(bool condition, std::string const &message)
+{
+    if (condition)
+        return;
+    ++failed;
+    my_log::error(message);
+}
+
+// failed expectations since the start
+size_t failures()
+{
+    return failed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// MEASUREMENT
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: run
+
+\summary:  run the warmup and the timed iterations of a case and reduce the
+           samples, outliers beyond the tukey fences (1.5 iqr) are kept in the
+           order statistics but excluded from mean and standard deviation
+
+\args:     c - case to run
+\args:     options - harness settings
+
+\return:   Result - statistics of the case
+************************************************************************//*F-F*/
+Result run(Case const &c, Options const &options)
+{
+    Result result;
+    result.name = c.name;
+    result.unit = c.unit;
+
+    for (int i = 0; i < options.warmup; ++i)
+        keep(c.run());
+
+    int const iterations = c.iterations > 0 ? c.iterations : options.iterations;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    size_t items = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        items = c.run();
+        auto const stop = std::chrono::steady_clock::now();
+        keep(items);
+        samples.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    if (samples.empty())
+        return result;
+
+    std::sort(samples.begin(), samples.end());
+    result.iterations = samples.size();
+    result.min = samples.front();
+    result.max = samples.back();
+    result.median = percentile(samples, 0.50);
+    result.p95 = percentile(samples, 0.95);
+    result.p99 = percentile(samples, 0.99);
+
+    // tukey fences
+    double const q1 = percentile(samples, 0.25);
+    double const q3 = percentile(samples, 0.75);
+    double const low = q1 - 1.5 * (q3 - q1);
+    double const high = q3 + 1.5 * (q3 - q1);
+
+    std::vector<double> inliers;
+    std::copy_if(samples.begin(), samples.end(), std::back_inserter(inliers),
+                 [&](double s) { return s >= low && s <= high; });
+    result.outliers = samples.size() - inliers.size();
+
+    result.mean = std::accumulate(inliers.begin(), inliers.end(), 0.0) / static_cast<double>(inliers.size());
+    double variance = 0.0;
+    for (double const s : inliers)
+        variance += (s - result.mean) * (s - result.mean);
+    result.stddev = inliers.size() > 1 ? std::sqrt(variance / static_cast<double>(inliers.size() - 1)) : 0.0;
+
+    if (result.median > 0.0)
+        result.throughput = static_cast<double>(items) / (result.median / 1000.0);
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// OUTPUT
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: write_json
+
+\summary:  write the results as json, one result object per line
+
+\args:     results - results to write
+\args:     path - output file path
+
+\return:   True, if the file was written
+\return:   False, otherwise
+************************************************************************//*F-F*/
+bool write_json(std::vector<Result> const &results, std::string path)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        my_log::error("Unable to open result file ", path, ".");
+        return false;
+    }
+
+    out << std::setprecision(9) << "{\"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        Result const &r = results[i];
+        out << "{\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\", \"iterations\": " << r.iterations
+            << ", \"outliers\": " << r.outliers << ", \"min\": " << r.min << ", \"median\": " << r.median
+            << ", \"p95\": " << r.p95 << ", \"p99\": " << r.p99 << ", \"max\": " << r.max << ", \"mean\": " << r.mean
+            << ", \"stddev\": " << r.stddev << ", \"throughput\": " << r.throughput << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+
+    return out.good();
+}
+
+/*F+F***********************************************************************//*!
+\function: write_csv
+
+\summary:  write the results as csv with a header row
+
+\args:     results - results to write
+\args:     path - output file path
+
+\return:   True, if the file was written
+\return:   False, otherwise
+************************************************************************//*F-F*/
+bool write_csv(std::vector<Result> const &results, std::string path)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        my_log::error("Unable to open result file ", path, ".");
+        return false;
+    }
+
+    out << std::setprecision(9);
+    out << "name,unit,iterations,outliers,min,median,p95,p99,max,mean,stddev,throughput\n";
+    for (auto const &r : results)
+        out << r.name << "," << r.unit << "," << r.iterations << "," << r.outliers << "," << r.min << "," << r.median
+            << "," << r.p95 << "," << r.p99 << "," << r.max << "," << r.mean << "," << r.stddev << "," << r.throughput
+            << "\n";
+
+    return out.good();
+}
+
+/*F+F***********************************************************************//*!
+\function: read
+
+\summary:  read results written by write_json or write_csv, e.g. a baseline
+
+\args:     path - result file path, csv when it ends in .csv
+
+\return:   std::vector<Result> - stored results, empty if unreadable
+************************************************************************//*F-F*/
+std::vector<Result> read(std::string path)
+{
+    std::vector<Result> results;
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        my_log::error("Unable to open baseline ", path, ".");
+        return results;
+    }
+
+    bool const csv = path.ends_with(".csv");
+    std::string line;
+    if (csv)
+        std::getline(in, line); // header
+
+    while (std::getline(in, line))
+    {
+        Result r;
+        if (csv)
+        {
+            std::vector<std::string> columns;
+            std::stringstream ss(line);
+            std::string column;
+            while (std::getline(ss, column, ','))
+                columns.push_back(column);
+            if (columns.size() < 12)
+                continue;
+            r.name = columns[0];
+            r.unit = columns[1];
+            r.iterations = std::stoul(columns[2]);
+            r.outliers = std::stoul(columns[3]);
+            r.min = std::stod(columns[4]);
+            r.median = std::stod(columns[5]);
+            r.p95 = std::stod(columns[6]);
+            r.p99 = std::stod(columns[7]);
+            r.max = std::stod(columns[8]);
+            r.mean = std::stod(columns[9]);
+            r.stddev = std::stod(columns[10]);
+            r.throughput = std::stod(columns[11]);
+        }
+        else
+        {
+            r.name = text(line, "name");
+            if (r.name.empty())
+                continue;
+            r.unit = text(line, "unit");
+            r.iterations = static_cast<size_t>(field(line, "iterations"));
+            r.outliers = static_cast<size_t>(field(line, "outliers"));
+            r.min = field(line, "min");
+            r.median = field(line, "median");
+            r.p95 = field(line, "p95");
+            r.p99 = field(line, "p99");
+            r.max = field(line, "max");
+            r.mean = field(line, "mean");
+            r.stddev = field(line, "stddev");
+            r.throughput = field(line, "throughput");
+        }
+        results.push_back(r);
+    }
+
+    return results;
+}
+
+/*F+F***********************************************************************//*!
+\function: compare
+
+\summary:  compare the medians of the results against a baseline and print the
+           relative change of every case found in both
+
+\args:     results - current results
+\args:     baseline - stored results
+\args:     threshold - relative median slowdown flagged as regression
+
+\return:   int - number of regressions
+************************************************************************//*F-F*/
+int compare(std::vector<Result> const &results, std::vector<Result> const &baseline, double threshold)
+{
+    std::unordered_map<std::string, Result const *> stored;
+    for (auto const &b : baseline)
+        stored[b.name] = &b;
+
+    int regressions = 0;
+    std::cout << "\nBaseline comparison (median, threshold " << threshold * 100.0 << "%)" << std::endl;
+    for (auto const &r : results)
+    {
+        auto it = stored.find(r.name);
+        if (it == stored.end() || it->second->median <= 0.0)
+        {
+            std::cout << "  " << std::left << std::setw(32) << r.name << " no baseline" << std::endl;
+            continue;
+        }
+
+        double const change = r.median / it->second->median - 1.0;
+        bool const regression = change > threshold;
+        regressions += regression;
+        std::cout << "  " << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << it->second->median << " ms -> " << std::setw(10) << r.median << " ms "
+                  << std::showpos << std::setprecision(1) << std::setw(7) << change * 100.0 << "%" << std::noshowpos
+                  << (regression ? "  REGRESSION" : "") << std::endl;
+    }
+
+    return regressions;
+}
+
+} // namespace bench
@@ -0,0 +1,106 @@
+/*+*************************************************************************//*!
+\file:      benchmark.h
+
+\summary:   statistical benchmark harness, named cases run a warmup and a
+            number of timed iterations, the samples are reduced to order
+            statistics and throughput, written as json or csv and compared
+            against a stored baseline to flag regressions
+
+\structs:   Case
+            Result
+            Options
+
+\functions: add\n
+            cases\n
+            keep\n
+            expect\n
+            failures\n
+            run\n
+            write_json\n
+            write_csv\n
+            read\n
+            compare\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_BENCHMARK_H
+#define ARTENGINE_BENCHMARK_H
+
+namespace bench
+{
+
+// named benchmark, the function returns the number of items it processed
+struct Case
+{
+    std::string name;            //!< unique case name (group/case)
+    std::function<size_t()> run; //!< timed function, returns processed items
+    std::string unit = "items";  //!< unit of the processed items
+    int iterations = 0;          //!< timed iterations, zero uses the default
+};
+
+// statistics of a case, durations in milliseconds
+struct Result
+{
+    std::string name;        //!< case name
+    std::string unit;        //!< unit of the throughput
+    size_t iterations = 0;   //!< timed iterations
+    size_t outliers = 0;     //!< samples outside the tukey fences
+    double min = 0.0;        //!< fastest iteration
+    double median = 0.0;     //!< 50th percentile
+    double p95 = 0.0;        //!< 95th percentile
+    double p99 = 0.0;        //!< 99th percentile
+    double max = 0.0;        //!< slowest iteration
+    double mean = 0.0;       //!< mean without outliers
+    double stddev = 0.0;     //!< standard deviation without outliers
+    double throughput = 0.0; //!< processed items per second at the median
+};
+
+// harness settings, filled from the command line
+struct Options
+{
+    int warmup = 3;          //!< untimed iterations before sampling
+    int iterations = 30;     //!< default timed iterations
+    std::string filter;      //!< run cases whose name contains the filter
+    std::string output;      //!< result file, json unless it ends in .csv
+    std::string baseline;    //!< baseline result file to compare against
+    double threshold = 0.10; //!< relative median slowdown flagged as regression
+};
+
+void add(std::string name, std::function<size_t()> function, std::string unit = "items", int iterations = 0);
+std::vector<Case> const &cases();
+
+void expect(bool condition, std::string const &message);
+[[nodiscard]] size_t failures();
+
+Result run(Case const &c, Options const &options);
+
+bool write_json(std::vector<Result> const &results, std::string path);
+bool write_csv(std::vector<Result> const &results, std::string path);
+std::vector<Result> read(std::string path);
+
+int compare(std::vector<Result> const &results, std::vector<Result> const &baseline, double threshold);
+
+/*F+F***********************************************************************//*!
+\function: keep
+
+\summary:  keep the compiler from optimizing away a value computed by a case
+
+\args:     value - value to keep
+************************************************************************//*F-F*/
+template <typename T>
+inline void keep(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char const *sink;
+    sink = reinterpret_cast<char const volatile *>(&value);
+#endif
+}
+
+} // namespace bench
+
+#endif // ARTENGINE_BENCHMARK_H
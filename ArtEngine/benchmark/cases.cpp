@@ -0,0 +1,518 @@
+#include "../include/pch.h"
+#include "../include/ArtEngine.h"
+
+#include "benchmark.h"
+#include "../examples/space_partitioning/octree.h"
+#include "../examples/space_partitioning/bsp_tree.h"
+#include "../examples/cubic_spline/cubic_spline.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+static std::string const scene = "object/Section4"; // obj list shared with the space partitioning example
+
+// release an octree, returns the number of nodes
+static size_t release(OctreeNode *node)
+{
+    if (!node)
+        return 0;
+    size_t nodes = 1;
+    for (auto *child : node->children)
+        nodes += release(child);
+    delete node;
+    return nodes;
+}
+
+// release a bsp tree, returns the number of nodes
+static size_t release(BSPNode *node)
+{
+    if (!node)
+        return 0;
+    size_t const nodes = 1 + release(node->front) + release(node->back);
+    delete node;
+    return nodes;
+}
+
+// number of vertices of a set of models
+static size_t vertices(std::vector<Model *> const &models)
+{
+    size_t count = 0;
+    for (auto const *model : models)
+        count += model->size;
+    return count;
+}
+
+// log lines go to a file, errors stay on the console
+class SplitSink : public my_log::Sink
+{
+  public:
+    SplitSink()
+        : m_file("benchmark_log.txt")
+    {
+    }
+
+    void write(my_log::Level level, double time, std::string_view line) override
+    {
+        if (level == my_log::Level::error)
+            m_console.write(level, time, line);
+        else
+            m_file.write(level, time, line);
+    }
+
+    void flush() override
+    {
+        m_console.flush();
+        m_file.flush();
+    }
+
+  private:
+    my_log::Console m_console; //!< error lines
+    my_log::File m_file;       //!< every other line
+
+}; // class SplitSink
+
+////////////////////////////////////////////////////////////////////////////////
+//// CASES
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: register_cases
+
+\summary:  register the engine cases, the scene models are loaded once and
+           shared by the bounding volume and space partitioning cases
+
+\args:     models - scene models, owned by the caller
+************************************************************************//*F-F*/
+void register_cases(std::vector<Model *> &models)
+{
+    // obj loading
+    bench::add(
+        "object/load_all",
+        [] {
+            std::vector<Model *> loaded = object::load_all({scene}, color::silver);
+            size_t const count = vertices(loaded);
+            for (auto const *model : loaded)
+                delete model;
+            return count;
+        },
+        "vertices", 10);
+
+    // quantized upload, 16 instead of 40 bytes per vertex
+    bench::add(
+        "object/load_all_compressed",
+        [] {
+            object::compressed = true;
+            std::vector<Model *> loaded = object::load_all({scene}, color::silver);
+            object::compressed = false;
+            size_t const count = vertices(loaded);
+            for (auto const *model : loaded)
+                delete model;
+            return count;
+        },
+        "vertices", 10);
+
+    // packed vertex formats, obj normals and colors shrink from 28 to 8 bytes per vertex
+    bench::add(
+        "vertex/pack_normals_colors",
+        [] {
+            static size_t constexpr n = 1 << 20;
+            static std::vector<float> const normals = [] {
+                std::vector<float> values(n * 3);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    glm::vec3 const v = glm::normalize(glm::vec3(std::sin(i * 0.1f), std::cos(i * 0.3f), 0.5f));
+                    std::memcpy(&values[i * 3], &v, sizeof(v));
+                }
+                return values;
+            }();
+            static std::vector<float> const colors(n * 4, 0.75f);
+
+            std::vector<unsigned char> const packed_normals = vertex::pack<vertex::Snorm10>(normals);
+            std::vector<unsigned char> const packed_colors = vertex::pack<vertex::Unorm8<4>>(colors);
+            bench::keep(packed_normals.data());
+            bench::keep(packed_colors.data());
+            return n;
+        },
+        "vertices");
+
+    // quadric simplification of the full detail scene geometry
+    bench::add(
+        "lod/generate",
+        [&models] {
+            static std::vector<object::Mesh> const meshes = [&models] {
+                std::vector<object::Mesh> result(models.size());
+                for (size_t i = 0; i < models.size(); ++i)
+                {
+                    for (auto const &p : models[i]->positions())
+                        result[i].positions.insert(result[i].positions.end(), {p.x, p.y, p.z});
+                    result[i].normals.resize(result[i].positions.size());
+                    for (size_t v = 0; v < models[i]->size; ++v)
+                        for (int c = 0; c < 4; ++c)
+                            result[i].colors.push_back(models[i]->color[v][c]);
+                }
+                return result;
+            }();
+
+            std::atomic<size_t> triangles = 0;
+            job::parallel_for(
+                meshes.size(),
+                [&](size_t i) {
+                    object::Mesh mesh = meshes[i];
+                    lod::generate(mesh);
+                    triangles.fetch_add(mesh.levels[0].count / 3, std::memory_order_relaxed);
+                },
+                1);
+            return triangles.load();
+        },
+        "triangles", 10);
+
+    // level selection of a zoomed out view, the scene is drawn at a fraction of its triangles
+    bench::add(
+        "lod/select",
+        [&models] {
+            glm::mat4 const view = glm::lookAt(glm::vec3(20.0f), glm::vec3(0.0f, 15.0f, 0.0f), glm::vec3(0, 1, 0));
+            glm::mat4 const projection = glm::ortho(-80000.0f, 80000.0f, -53000.0f, 53000.0f, -100000.0f, 100000.0f);
+            lod::select(models, view, projection, 800.0f);
+            bench::keep(lod::triangles(models));
+            return models.size();
+        },
+        "models");
+
+    // shared-vertex icosphere, no instance outlives a run so every run builds the level
+    bench::add(
+        "model/icosphere",
+        [] {
+            Icosphere sphere(1.0f, 6);
+            return sphere.size / 3;
+        },
+        "triangles", 10);
+
+    // gpu culling against a known frustum, checks exactly which draws survive, runs on llvmpipe in ci with
+    // --headless --software, the scene is built per run so no gl object outlives the context
+    bench::add(
+        "cull/known_frustum",
+        [] {
+            // unit spheres around an orthographic box of half size 10, the one at x 10.5 straddles the right plane
+            static std::vector<glm::vec3> const centers = {{-20.0f, 0.0f, 0.0f}, {-6.0f, 0.0f, 0.0f},
+                                                           {0.0f, 0.0f, 0.0f},   {10.5f, 0.0f, 0.0f},
+                                                           {20.0f, 0.0f, 0.0f},  {0.0f, 0.0f, -30.0f}};
+            static std::vector<GLuint> const expected = {1, 2, 3};
+
+            std::vector<std::unique_ptr<Icosphere>> spheres;
+            Batch batch({"in_Position"});
+            for (auto const &center : centers)
+            {
+                auto sphere = std::make_unique<Icosphere>(1.0f, 1);
+                sphere->model = glm::translate(glm::mat4(1.0f), center);
+                sphere->sphere = Sphere(glm::vec3(0.0f), 1.0f);
+                sphere->aabb = AABB(glm::vec3(-1.0f), glm::vec3(1.0f));
+                batch.add(sphere.get());
+                spheres.push_back(std::move(sphere));
+            }
+            batch.build();
+            batch.update();
+
+            Cull cull(&batch, "shader/cull.cs");
+            cull.dispatch(glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, -10.0f, 10.0f));
+
+            // the counts are [arrays, elements], icospheres are indexed
+            std::vector<GLuint> counts(2);
+            cull.m_count.retrieve(counts);
+            std::vector<DrawElementsCommand> commands(batch.m_element_draws.size());
+            cull.m_elements.retrieve(commands);
+
+            // the compaction order depends on the invocation order, the draw ids are compared sorted
+            std::vector<GLuint> survivors;
+            for (size_t i = 0; i < std::min<size_t>(counts[1], commands.size()); ++i)
+                survivors.push_back(commands[i].base_instance);
+            std::sort(survivors.begin(), survivors.end());
+
+            bench::expect(counts[0] == 0 && survivors == expected,
+                          "cull/known_frustum: " + std::to_string(counts[1]) +
+                              " draws survived, expected the draws 1, 2 and 3.");
+            return centers.size();
+        },
+        "draws", 5);
+
+    // input burst larger than the event ring, the cost stays bounded by the ring capacity
+    bench::add(
+        "event/input_burst",
+        [] {
+            static size_t constexpr n = 4 * Event::capacity;
+            static size_t received = 0;
+            static size_t const id = Art::event.subscribe(SDL_KEYDOWN, [](SDL_Event const &) { ++received; });
+            bench::keep(id);
+
+            SDL_Event key{};
+            key.key.keysym.scancode = SDL_SCANCODE_A;
+            for (size_t i = 0; i < n; ++i)
+            {
+                key.type = i % 2 ? SDL_KEYUP : SDL_KEYDOWN;
+                SDL_PushEvent(&key);
+            }
+            Art::event.input();
+            Art::event.handle(Art::view);
+            bench::keep(received);
+            return n;
+        },
+        "events");
+
+    // bounding volumes
+    std::vector<std::pair<std::string, AABB::bb_type>> const boxes = {{"aabb", AABB::bb_type::aabb},
+                                                                      {"obb", AABB::bb_type::obb}};
+    for (auto const &[name, type] : boxes)
+        bench::add(
+            "bounding_volume/" + name,
+            [&models, type] {
+                for (auto *model : models)
+                    model->aabb.compute(type);
+                return vertices(models);
+            },
+            "vertices");
+
+    std::vector<std::pair<std::string, Sphere::sphere_type>> const spheres = {
+        {"centroid", Sphere::sphere_type::centroid},   {"ritter", Sphere::sphere_type::ritter},
+        {"larsson6", Sphere::sphere_type::larsson6},   {"larsson14", Sphere::sphere_type::larsson14},
+        {"larsson26", Sphere::sphere_type::larsson26}, {"larsson98", Sphere::sphere_type::larsson98},
+        {"pca", Sphere::sphere_type::pca},             {"ellipsoid", Sphere::sphere_type::ellipsoid}};
+    for (auto const &[name, type] : spheres)
+        bench::add(
+            "bounding_volume/sphere_" + name,
+            [&models, type] {
+                for (auto *model : models)
+                    model->sphere.compute(type);
+                return vertices(models);
+            },
+            "vertices");
+
+    // space partitioning
+    bench::add(
+        "space_partitioning/octree",
+        [&models] {
+            OctreeNode *octree = BuildOctTree(models, Center(models), Longest(models), 8);
+            return release(octree);
+        },
+        "nodes", 10);
+
+    bench::add(
+        "space_partitioning/bsp_tree",
+        [&models] {
+            // same triangle soup as the space partitioning example
+            std::vector<triangle> world_triangles;
+            std::vector<int> model_index;
+            std::vector<std::vector<size_t>> model_indices;
+            for (size_t j = 0; j < models.size(); ++j)
+            {
+                std::vector<glm::vec3> points = models[j]->positions();
+                for (size_t i = 0; i + 2 < points.size(); i += 3)
+                {
+                    world_triangles.push_back({{points[i], points[i + 1], points[i + 2]}});
+                    model_index.push_back(static_cast<int>(j));
+                    model_indices.push_back({i, i + 1, i + 2});
+                }
+            }
+            BSPNode *bsp_tree = BuildBSPTree(world_triangles, models, 8, model_index, model_indices);
+            release(bsp_tree);
+            return world_triangles.size();
+        },
+        "triangles", 10);
+
+    // job system scalability, the worker count is changed before the first (warmup) iteration of each case
+    size_t const hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < hardware; n *= 2)
+        counts.push_back(n);
+    counts.push_back(hardware); // always measure every hardware thread
+    for (size_t const n : counts)
+    {
+        bench::add(
+            "job/load_all_threads_" + std::to_string(n),
+            [n] {
+                if (job::threads() != n)
+                    job::init(n);
+                std::vector<Model *> loaded = object::load_all({scene}, color::silver);
+                size_t const count = vertices(loaded);
+                for (auto const *model : loaded)
+                    delete model;
+                return count;
+            },
+            "vertices", 10);
+
+        bench::add(
+            "job/sphere_larsson98_threads_" + std::to_string(n),
+            [&models, n] {
+                if (job::threads() != n)
+                    job::init(n);
+                for (auto *model : models)
+                    model->sphere.compute(Sphere::sphere_type::larsson98);
+                return vertices(models);
+            },
+            "vertices");
+
+        // procedural 8k image, a few transcendental calls per pixel
+        bench::add(
+            "job/image_make_8k_threads_" + std::to_string(n),
+            [n] {
+                if (job::threads() != n)
+                    job::init(n);
+                SDL_Surface *surface = image::make(
+                    [](int x, int y) {
+                        float const u = x / 7680.0f;
+                        float const v = y / 4320.0f;
+                        return glm::vec4(0.5f + 0.5f * std::sin(40.0f * u), 0.5f + 0.5f * std::cos(30.0f * v),
+                                         u * v, 1.0f);
+                    },
+                    glm::vec2(7680, 4320));
+                SDL_FreeSurface(surface);
+                return size_t(7680) * 4320;
+            },
+            "pixels", 5);
+    }
+
+    // logging latency, the previous implementation flushed std::cout with std::endl on every call
+    static size_t constexpr lines = 1000;
+    my_log::add(std::make_shared<SplitSink>());
+
+    bench::add(
+        "log/direct_endl",
+        [] {
+            static std::ofstream file("benchmark_log_direct.txt");
+            std::streambuf *previous = std::cout.rdbuf(file.rdbuf());
+            for (size_t i = 0; i < lines; ++i)
+                std::cout << "[" << my_log::key << "] " << "frame " << i << " position " << 0.5f * i << std::endl;
+            std::cout.rdbuf(previous);
+            return lines;
+        },
+        "calls");
+
+    // only queued records count, a dropped record is cheaper than a queued one and would inflate the throughput
+    bench::add(
+        "log/async_submit",
+        [] {
+            size_t const before = my_log::dropped();
+            for (size_t i = 0; i < lines; ++i)
+                my_log::out("frame ", i, " position ", 0.5f * i);
+            size_t const lost = my_log::dropped() - before;
+            if (lost)
+                my_log::error("log/async_submit dropped ", lost, " of ", lines, " records on a full queue.");
+            return lines - lost;
+        },
+        "calls");
+
+    bench::add(
+        "log/async_flushed",
+        [] {
+            size_t const before = my_log::dropped();
+            for (size_t i = 0; i < lines; ++i)
+                my_log::out("frame ", i, " position ", 0.5f * i);
+            my_log::flush();
+            size_t const lost = my_log::dropped() - before;
+            if (lost)
+                my_log::error("log/async_flushed dropped ", lost, " of ", lines, " records on a full queue.");
+            return lines - lost;
+        },
+        "calls");
+
+    // the harness is built with debug compiled out, the arguments of the calls are never evaluated
+    bench::add(
+        "log/debug_disabled",
+        [] {
+            static_assert(!my_log::compiled(my_log::Level::debug), "the benchmark compiles debug logging out");
+            for (size_t i = 0; i < lines; ++i)
+                ART_LOG_DEBUG("frame ", i, " position ", 0.5f * i);
+            return lines;
+        },
+        "calls");
+
+    // glsl permutations, shared headers are parsed once and expanded once per source
+    std::filesystem::path const glsl = std::filesystem::temp_directory_path() / "artengine_glsl";
+    std::filesystem::create_directories(glsl / "include");
+    std::ofstream(glsl / "include" / "common.glsl") << "#pragma once\nconst float PI = 3.14159265;\n";
+    for (std::string const name : {"light", "shadow", "material", "fog"})
+        std::ofstream(glsl / "include" / (name + ".glsl"))
+            << "#include \"common.glsl\"\nvec3 " << name << "(vec3 v) { return v * PI; }\n";
+    std::ofstream(glsl / "permutation.fs")
+        << "#version 430\n#include \"include/light.glsl\"\n#include \"include/shadow.glsl\"\n"
+        << "#include \"include/material.glsl\"\n#include \"include/fog.glsl\"\n"
+        << "out vec4 color;\nvoid main() { color = vec4(fog(material(shadow(light(vec3(1))))), 1); }\n";
+
+    bench::add(
+        "shader/preprocess_permutations",
+        [file = (glsl / "permutation.fs").string()] {
+            size_t length = 0;
+            for (int i = 0; i < 64; ++i)
+            {
+                Defines const defines{{"SHADOWS", std::to_string(i & 1)},
+                                      {"FOG", std::to_string((i >> 1) & 1)},
+                                      {"LIGHTS", std::to_string(i >> 2)}};
+                length += ShaderBase::preprocess(file, defines).text.length();
+            }
+            bench::keep(length);
+            return size_t(64);
+        },
+        "permutations");
+
+    // spline solve, degree 20 like the cubic spline example
+    bench::add(
+        "spline/cubic_21",
+        [] {
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+            std::deque<glm::vec3> points(21);
+            for (auto &p : points)
+                p = glm::vec3(distribution(rng), distribution(rng), distribution(rng));
+            std::vector<glm::vec3> coefficients = CubicSpline(points);
+            bench::keep(coefficients.data());
+            return points.size();
+        },
+        "points");
+
+    // simulation hand-off, a writer thread publishes curves while the reader holds one per frame
+    bench::add(
+        "snapshot/publish_acquire",
+        [] {
+            static size_t constexpr ticks = 10000;
+            Snapshot<std::vector<glm::vec3>> snapshot(std::vector<glm::vec3>(400));
+            std::atomic<bool> writing = true;
+            std::thread writer([&] {
+                std::vector<glm::vec3> curve(400);
+                for (size_t i = 0; i < ticks; ++i)
+                {
+                    curve[i % curve.size()] = glm::vec3(static_cast<float>(i));
+                    snapshot.publish(curve);
+                }
+                writing = false;
+            });
+            float sum = 0.0f;
+            while (writing)
+            {
+                sum += snapshot.acquire().front().x;
+                snapshot.release();
+            }
+            writer.join();
+            bench::keep(sum);
+            return snapshot.published();
+        },
+        "publishes");
+
+    // frame cap precision, 2 ms deadlines on a local clock reached by sleeping and spinning the last part
+    bench::add(
+        "pacing/cap_500fps",
+        [] {
+            using Clock = std::chrono::steady_clock;
+            static size_t constexpr frames = 100;
+            auto const period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 500.0));
+            auto deadline = Clock::now();
+            Clock::duration overshoot{};
+            for (size_t i = 0; i < frames; ++i)
+            {
+                deadline += period;
+                pacing::wait_until(deadline);
+                overshoot = std::max(overshoot, Clock::now() - deadline);
+            }
+            bench::keep(overshoot.count());
+            return frames;
+        },
+        "frames", 3);
+}
@@ -0,0 +1,89 @@
+#include "../include/pch.h"
+#include "../include/ArtEngine.h"
+
+#include "benchmark.h"
+
+void register_cases(std::vector<Model *> &models);
+
+/*
+ usage: ArtEngineBenchmark [-filter name] [-warmup n] [-iterations n]
+                           [-output results.json|results.csv]
+                           [-baseline baseline.json|baseline.csv] [-threshold 0.1]
+                           [--list] [--software]
+
+ always renders offscreen, --software forces llvmpipe as in ci
+
+ returns the number of regressions against the baseline and failed expectations
+*/
+int main(int argc, char *args[])
+{
+    parse::get(argc, args);
+
+    bench::Options options;
+    if (parse::options.contains("filter"))
+        options.filter = parse::options["filter"];
+    if (parse::options.contains("warmup"))
+        options.warmup = std::stoi(parse::options["warmup"]);
+    if (parse::options.contains("iterations"))
+        options.iterations = std::stoi(parse::options["iterations"]);
+    if (parse::options.contains("output"))
+        options.output = parse::options["output"];
+    if (parse::options.contains("baseline"))
+        options.baseline = parse::options["baseline"];
+    if (parse::options.contains("threshold"))
+        options.threshold = std::stod(parse::options["threshold"]);
+
+    // offscreen context for the models, no display server required (see Art::Headless)
+    Art::headless.enabled = true;
+    if (!Art::init())
+        return -1;
+
+    std::vector<Model *> models = object::load_all({"object/Section4"}, color::silver);
+    register_cases(models);
+
+    if (parse::flags.contains("list"))
+    {
+        for (auto const &c : bench::cases())
+            std::cout << c.name << std::endl;
+        Art::quit();
+        return 0;
+    }
+
+    std::cout << std::left << std::setw(36) << "case" << std::right << std::setw(10) << "min" << std::setw(10)
+              << "median" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(8) << "out"
+              << std::setw(16) << "throughput" << std::endl;
+
+    std::vector<bench::Result> results;
+    for (auto const &c : bench::cases())
+    {
+        if (!options.filter.empty() && c.name.find(options.filter) == std::string::npos)
+            continue;
+
+        bench::Result const r = bench::run(c, options);
+        results.push_back(r);
+        std::cout << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << r.min << std::setw(10) << r.median << std::setw(10) << r.p95 << std::setw(10)
+                  << r.p99 << std::setw(8) << r.outliers << std::setw(16) << std::setprecision(0) << r.throughput
+                  << " " << r.unit << "/s" << std::endl;
+    }
+
+    if (!options.output.empty())
+    {
+        bool const csv = options.output.ends_with(".csv");
+        csv ? bench::write_csv(results, options.output) : bench::write_json(results, options.output);
+    }
+
+    int regressions = 0;
+    if (!options.baseline.empty())
+        regressions = bench::compare(results, bench::read(options.baseline), options.threshold);
+
+    int const failures = static_cast<int>(bench::failures());
+    if (failures)
+        my_log::error(failures, " expectations of the cases failed.");
+
+    for (auto const *model : models)
+        delete model;
+    Art::quit();
+
+    return regressions + failures;
+}
@@ -172,4 +172,34 @@ std::vector<glm::vec3> CubicSpline(std::deque<glm::vec3> const &points)
   return result;
 }
 
+// sample the spline through the points into the curve, untouched for fewer than 3 points
+void EvaluateSpline(std::deque<glm::vec3> const &points, std::vector<glm::vec3> &curve)
+{
+  if (points.size() < 3)
+    return;
+
+  std::vector<glm::vec3> coeffs = CubicSpline(points);
+  size_t size = points.size() - 1;
+  int const samples = static_cast<int>(curve.size());
+  for (int i = 0; i < samples; ++i)
+  {
+    float const t = static_cast<float>(i) / static_cast<float>(samples - 1) * static_cast<float>(size);
+
+    glm::vec3 p(0);
+
+    int c = 0;
+    for (size_t j = 0; j < coeffs.size(); ++j)
+    {
+      if (j < 4)
+        p += coeffs[j] * powf(t, j);
+      else
+      {
+        ++c;
+        p += coeffs[j] * static_cast<float>(truncated_power_function(t, c, 3));
+      }
+    }
+    curve[i] = p;
+  }
+}
+
 #endif // ARTENGINE_CUBIC_SPLINE_H
@@ -6,6 +6,9 @@
 
 int main(int argc, char *args[])
 {
+    // --headless renders offscreen, see Art::Headless
+    parse::get(argc, args);
+
     // initialize the window
     Art::view.m_show_interface = true;
     Art::view.vsync(true);
@@ -26,6 +29,16 @@ int main(int argc, char *args[])
     // create the control point model
     Icosphere sphere(1, 2);
 
+    // stream the polygonal line and the curve instead of a line model per segment
+    std::vector<glm::vec3> polygon;
+    Model polygon_line({"in_Position"}, "polygon");
+    Buffer polygon_vertex;
+    polygon_vertex.stream<glm::vec3>(21); // degree 20 control points
+    Model curve_line({"in_Position"}, "curve");
+    GLuint const position = curve_line.bindings["in_Position"]; // rebound every frame, skip the name lookup
+    Buffer curve_vertex;
+    curve_vertex.stream<glm::vec3>(line_points);
+
     glLineWidth(0.5f);
 
     // view pipeline draws everything on screen
@@ -44,7 +57,7 @@ int main(int argc, char *args[])
             for (auto const &p : control_points)
             {
                 sphere.model = glm::translate(glm::mat4(1), p) * //
-                               glm::scale(glm::mat4(1), glm::vec3(1));
+                               glm::scale(glm::mat4(1), glm::vec3(sphere.radius));
                 shader.uniform("model", sphere.model);
                 sphere.render(GL_LINES);
             }
@@ -54,53 +67,50 @@ int main(int argc, char *args[])
         shader.uniform("alpha", 0.5f);
         if (draw_polygonal_line && control_points.size() >= 2)
         {
-            for (int i = 0; i < control_points.size() - 1; ++i)
-            {
-                Line line(control_points[i], control_points[i + 1]);
-                shader.uniform("model", line.model);
-                line.render(GL_LINES);
-            }
+            polygon.assign(control_points.begin(), control_points.end());
+            polygon_vertex.fill(std::span<glm::vec3 const>(polygon));
+            polygon_line.bind<glm::vec3>(position, &polygon_vertex);
+            polygon_line.size = polygon_vertex.size;
+            shader.uniform("model", polygon_line.model);
+            polygon_line.render(GL_LINE_STRIP);
         }
 
         // draw curve
         shader.uniform("color", color::magenta);
         shader.uniform("alpha", 1.00f);
-        for (int i = 0; i < curve_points.size() - 1; ++i)
-        {
-            Line line(curve_points[i], curve_points[i + 1]);
-            shader.uniform("model", line.model);
-            line.render(GL_LINES);
-        }
+        curve_vertex.fill(std::span<glm::vec3 const>(curve_points));
+        curve_line.bind<glm::vec3>(position, &curve_vertex);
+        curve_line.size = curve_vertex.size;
+        shader.uniform("model", curve_line.model);
+        curve_line.render(GL_LINE_STRIP);
     };
 
-    // project loop
-    Art::loop([&]() {
-        // perform cubic spline mathd
-        if (control_points.size() >= 3)
-        {
-            std::vector<glm::vec3> coeffs = CubicSpline(control_points);
-            size_t size = control_points.size() - 1;
-            for (int i = 0; i < line_points; ++i)
-            {
-                float const t = static_cast<float>(i) / static_cast<float>(line_points - 1) * static_cast<float>(size);
-
-                glm::vec3 p(0);
-
-                int c = 0;
-                for (size_t j = 0; j < coeffs.size(); ++j)
-                {
-                    if (j < 4)
-                        p += coeffs[j] * powf(t, j);
-                    else
-                    {
-                        ++c;
-                        p += coeffs[j] * static_cast<float>(truncated_power_function(t, c, 3));
-                    }
-                }
-                curve_points[i] = p;
-            }
-        }
-    });
+    // --threaded solves the spline at a fixed rate on the simulation thread, -rate n ticks per second
+    if (parse::flags.contains("threaded"))
+    {
+        double const rate = parse::options.contains("rate") ? std::stod(parse::options["rate"]) : 60.0;
+
+        // the interface edits the control points, the simulation reads them through their own snapshot
+        Snapshot<std::deque<glm::vec3>> controls(control_points);
+        Art::simulate(
+            curve_points, rate,
+            [&](std::vector<glm::vec3> &curve, float) {
+                EvaluateSpline(controls.acquire(), curve);
+                controls.release();
+            },
+            [&](std::vector<glm::vec3> const &curve, float) {
+                controls.publish(control_points);
+                curve_points = curve;
+            });
+    }
+    else
+    {
+        // project loop
+        Art::loop([&]() {
+            // perform cubic spline math
+            EvaluateSpline(control_points, curve_points);
+        });
+    }
 
     Art::quit();
 
@@ -106,17 +106,17 @@ void setup()
 
 // Event Handler
 std::function<void()> const eventHandler = []() {
-    if (Art::event.key_down(SDLK_w))
+    if (Art::event.key_down(SDL_SCANCODE_W))
         scale /= 0.99f;
-    if (Art::event.key_down(SDLK_a))
+    if (Art::event.key_down(SDL_SCANCODE_A))
         pos = glm::rotate(glm::mat4(1), -glm::radians(0.75f), up) * glm::vec4(pos, 1.0);
-    if (Art::event.key_down(SDLK_s))
+    if (Art::event.key_down(SDL_SCANCODE_S))
         scale *= 0.99f;
-    if (Art::event.key_down(SDLK_d))
+    if (Art::event.key_down(SDL_SCANCODE_D))
         pos = glm::rotate(glm::mat4(1), glm::radians(0.75f), up) * glm::vec4(pos, 1.0);
-    if (Art::event.key_down(SDLK_LSHIFT))
+    if (Art::event.key_down(SDL_SCANCODE_LSHIFT))
         pos = glm::rotate(glm::mat4(1), -glm::radians(0.75f), glm::vec3(1, 1, 1)) * glm::vec4(pos, 1.0);
-    if (Art::event.key_down(SDLK_SPACE))
+    if (Art::event.key_down(SDL_SCANCODE_SPACE))
         pos = glm::rotate(glm::mat4(1), glm::radians(0.75f), glm::vec3(1, 1, 1)) * glm::vec4(pos, 1.0);
 
     setup(); // recompute (I know this shouldn't be called all the time, whatever lol)
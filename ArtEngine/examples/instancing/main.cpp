@@ -0,0 +1,150 @@
+#include "../../include/pch.h"
+#include "../../include/ArtEngine.h"
+
+// instance grid
+static int constexpr width = 100;
+static int constexpr depth = 100;
+static int constexpr height = 10;
+static int constexpr count = width * depth * height;
+
+// controls
+bool animate = true;
+float speed = 1.0f;
+bool screenshot = false;
+bool record = false;
+
+int main(int argc, char *args[])
+{
+    // --headless renders offscreen, see Art::Headless
+    parse::get(argc, args);
+
+    // initialize the window
+    Art::view.m_show_interface = true;
+    Art::view.vsync(false);
+    Art::benchmark = true; // profile the loop
+    Art::window("Instancing", 1200, 800);
+
+    // set up the camera
+    camera::far = 2000.0f;
+    camera::rotation_y = 30.0f;
+    camera::init(300.0f);
+    camera::update();
+
+    // set input event handler
+    Art::event.handler = [] { camera::handler(); };
+
+    // frames are recorded to numbered png files on background encoders
+    std::unique_ptr<Capture> recording;
+
+    // set imgui interface
+    Art::view.interface = [&] {
+        ImGui::SetNextWindowSize(ImVec2(318, -1), ImGuiCond_Once);
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Once);
+
+        ImGui::Begin("Instancing Controller", nullptr, ImGuiWindowFlags_NoResize);
+        ImGui::Text("%d instances", count);
+        ImGui::Text("Average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        ImGui::Separator();
+        ImGui::Checkbox("Animate", &animate);
+        ImGui::SliderFloat("Speed", &speed, 0.0f, 5.0f);
+        if (ImGui::Button("Screenshot"))
+            screenshot = true;
+        ImGui::SameLine();
+        ImGui::Checkbox("Record", &record);
+        if (recording)
+            ImGui::Text("%zu frames recorded, %zu dropped", recording->encoded(), recording->dropped());
+        ImGui::End();
+    };
+
+    // set up the shader, instance attributes use explicit locations
+    Shader shader({"shader/default.vs", "shader/default.fs"}, {"in_Quad", "in_Tex"});
+
+    // stream transforms, colors and levels of detail per instance
+    Cube cube;
+    Instance instance(&cube);
+    instance.stream<glm::mat4>("in_Model", count);
+    instance.stream<glm::vec4>("in_Color", count);
+    instance.stream<GLuint>("in_Lod", count);
+
+    // colors never change, they are written once and copied around the ring
+    std::vector<glm::vec4> colors(count);
+    for (int i = 0; i < count; ++i)
+        colors[i] = glm::vec4(color::rainbow(static_cast<float>(i) / static_cast<float>(count)), 1.0f);
+    instance.update("in_Color", colors);
+
+    std::vector<glm::mat4> transforms(count);
+    std::vector<GLuint> lods(count);
+    float time = 0.0f;
+
+    // screenshots are read back asynchronously and saved once the copy lands
+    Readback readback;
+
+    // view pipeline draws everything on screen
+    Art::view.pipeline = [&]() {
+        Art::view.target(color::black);
+
+        shader.use();
+        shader.uniform("vp", camera::view_projection);
+        shader.uniform("light", glm::vec3(1.0f, 2.0f, 3.0f));
+        {
+            ART_PROFILE("Draw Instances");
+            ART_PROFILE_GPU("Draw Instances");
+            instance.render(GL_TRIANGLES);
+        }
+
+        // capture the scene before the interface is drawn on top
+        if (screenshot)
+        {
+            readback.read(0, glm::ivec2(0), glm::ivec2(Art::view.width(), Art::view.height()), GL_BACK);
+            screenshot = false;
+        }
+
+        // recording starts and stops with the checkbox, stopping finishes the queued frames
+        if (record && !recording)
+            recording = std::make_unique<Capture>("frame");
+        else if (!record && recording)
+            recording.reset();
+        if (recording)
+            recording->frame(0, glm::ivec2(Art::view.width(), Art::view.height()), GL_BACK);
+
+        // done drawing from this frame's region
+        instance.advance();
+    };
+
+    // project loop animates every instance each frame
+    Art::loop([&]() {
+        if (readback.pending() && readback.ready())
+            image::save(readback, "screenshot.png");
+
+        if (!animate)
+            return;
+        time += 0.01f * speed;
+
+        {
+            ART_PROFILE("Animate");
+            glm::vec3 const eye = camera::look + camera::radius * camera::position;
+            for (int i = 0; i < count; ++i)
+            {
+                int const x = i % width;
+                int const z = (i / width) % depth;
+                int const y = i / (width * depth);
+
+                glm::vec3 p(2.5f * (x - width / 2), 2.5f * y, 2.5f * (z - depth / 2));
+                p.y += std::sin(time + 0.1f * (x + z));
+
+                transforms[i] = glm::rotate(glm::translate(glm::mat4(1), p), time + 0.01f * i, glm::vec3(0, 1, 0)) *
+                                glm::scale(glm::mat4(1), glm::vec3(0.5f));
+                lods[i] = static_cast<GLuint>(std::min(glm::distance(eye, p) / 150.0f, 3.0f));
+            }
+        }
+
+        ART_PROFILE("Stream Update");
+        instance.update("in_Model", transforms);
+        instance.update("in_Lod", lods);
+    });
+
+    recording.reset();
+    Art::quit();
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#version 430
+
+in vec4 ex_Color;
+in vec3 ex_Model; //Model Space
+
+out vec4 fragColor;
+
+uniform vec3 light;
+
+void main(void)
+{
+    // flat shading from the screen space derivatives of the position
+    vec3 normal = normalize(cross(dFdx(ex_Model), dFdy(ex_Model)));
+    float diffuse = 0.3 + 0.7 * max(dot(normal, normalize(light)), 0.0);
+    fragColor = vec4(diffuse * ex_Color.rgb, ex_Color.a);
+}
@@ -0,0 +1,21 @@
+#version 430
+
+layout (location = 0) in vec3 in_Quad;
+
+// per-instance streams
+layout (location = 2) in mat4 in_Model;
+layout (location = 6) in vec4 in_Color;
+layout (location = 7) in uint in_Lod;
+
+uniform mat4 vp;
+
+out vec4 ex_Color;
+out vec3 ex_Model; //Model Space
+
+void main(void)
+{
+    ex_Model = (in_Model * vec4(in_Quad, 1.0f)).xyz;
+    gl_Position = vp * vec4(ex_Model, 1.0f);
+    // coarser levels of detail fade towards gray
+    ex_Color = mix(in_Color, vec4(0.5, 0.5, 0.5, 1.0), 0.25 * float(in_Lod));
+}
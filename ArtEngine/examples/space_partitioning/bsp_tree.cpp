@@ -98,6 +98,17 @@ BSPNode *BuildBSPTree(std::vector<triangle> const &polygons, //
     return node;
 }
 
+// release a tree built by BuildBSPTree
+void DeleteBSPTree(BSPNode const *node)
+{
+    if (node == nullptr)
+        return;
+
+    DeleteBSPTree(node->front);
+    DeleteBSPTree(node->back);
+    delete node;
+}
+
 Plane SplittingPlane(std::vector<triangle> const &polygons)
 {
     static float constexpr k = 0.8f;
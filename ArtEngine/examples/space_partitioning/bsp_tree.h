@@ -71,6 +71,9 @@ BSPNode *BuildBSPTree(std::vector<triangle> const &polygons, //
                       std::vector<int> const &model_index,   //
                       std::vector<std::vector<size_t>> const &model_indices);
 
+// release a tree built by BuildBSPTree
+void DeleteBSPTree(BSPNode const *node);
+
 Plane SplittingPlane(std::vector<triangle> const &polygons);
 
 Plane PlaneFromPolygons(triangle const &poly);
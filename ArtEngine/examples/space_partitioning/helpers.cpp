@@ -32,6 +32,11 @@ size_t model_size;
 bool use_octree = false;
 // bsp
 bool use_bsp = false;
+// gpu frustum culling
+bool use_culling = true;
+// level of detail
+bool use_lod = true;
+size_t triangles = 0;
 
 bool needs_update = false;
 
@@ -60,30 +65,30 @@ void setup()
 
 // Event Handler
 Handle eventHandler = []() {
-    if (Art::event.key_down(SDLK_w))
+    if (Art::event.key_down(SDL_SCANCODE_W))
         scale /= 0.99;
-    if (Art::event.key_down(SDLK_a))
+    if (Art::event.key_down(SDL_SCANCODE_A))
     {
         pos = glm::rotate(glm::mat4(1), -glm::radians(0.75f), up) * glm::vec4(pos, 1.0);
         xz = glm::rotate(glm::mat4(1), -glm::radians(0.75f), up) * glm::vec4(xz, 1.0);
     }
-    if (Art::event.key_down(SDLK_s))
+    if (Art::event.key_down(SDL_SCANCODE_S))
         scale *= 0.99;
-    if (Art::event.key_down(SDLK_d))
+    if (Art::event.key_down(SDL_SCANCODE_D))
     {
         pos = glm::rotate(glm::mat4(1), glm::radians(0.75f), up) * glm::vec4(pos, 1.0);
         xz = glm::rotate(glm::mat4(1), glm::radians(0.75f), up) * glm::vec4(xz, 1.0);
     }
-    if (Art::event.key_down(SDLK_LSHIFT))
+    if (Art::event.key_down(SDL_SCANCODE_LSHIFT))
         look.y -= 0.5f;
-    if (Art::event.key_down(SDLK_SPACE))
+    if (Art::event.key_down(SDL_SCANCODE_SPACE))
         look.y += 0.5f;
 
     // model transitions
-    if (Art::event.key_up() == SDLK_LEFT)
+    if (Art::event.key_up(SDL_SCANCODE_LEFT))
         if (model_index > 0)
             --model_index;
-    if (Art::event.key_up() == SDLK_RIGHT)
+    if (Art::event.key_up(SDL_SCANCODE_RIGHT))
         if (model_index < model_size)
             ++model_index;
 
@@ -125,6 +130,17 @@ Handle interfaceFunc = []() {
     ImGui::Spacing();
     ImGui::Spacing();
 
+    ImGui::Checkbox("GPU Culling", &use_culling);
+
+    ImGui::Spacing();
+    ImGui::Spacing();
+
+    ImGui::Checkbox("Level of Detail", &use_lod);
+    ImGui::Text("%zu triangles before culling", triangles);
+
+    ImGui::Spacing();
+    ImGui::Spacing();
+
     ImGui::End();
 };
 
@@ -41,6 +41,11 @@ static std::array<glm::vec3, 7> const colors = {color::red,  color::orange,  col
 extern bool use_octree;
 // bsp
 extern bool use_bsp;
+// gpu frustum culling
+extern bool use_culling;
+// level of detail
+extern bool use_lod;
+extern size_t triangles;
 
 extern bool needs_update;
 
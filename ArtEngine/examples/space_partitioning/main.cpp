@@ -7,6 +7,9 @@
 
 int main(int argc, char *args[])
 {
+    // --headless renders offscreen, see Art::Headless
+    parse::get(argc, args);
+
     // create window
     Art::view.vsync(true);
     Art::view.m_line_width = 2.0f;
@@ -20,60 +23,86 @@ int main(int argc, char *args[])
     Art::event.handler = eventHandler;
     Art::view.interface = interfaceFunc;
 
-    // load shader
-    Shader shader({"shader/default.vs", "shader/default.fs"}, {"in_Position", "in_Normal", "in_Color"});
+    // --compressed stores quantized positions, octahedral normals and palette colors
+    object::compressed = parse::flags.contains("compressed");
+    Defines defines;
+    if (object::compressed)
+        defines = {{"COMPRESSED", "1"}, {"PALETTE_SIZE", std::to_string(object::palette_size)}};
+
+    // load shaders
+    Shader shader({"shader/default.vs", "shader/default.fs"}, {"in_Position", "in_Normal", "in_Color"}, permutation,
+                  defines);
+    Shader batch_shader({"shader/batch.vs", "shader/default.fs"}, {"in_Position", "in_Normal", "in_Color", "in_DrawID"},
+                        permutation, defines);
+    if (object::compressed)
+        batch_shader.interface({"transforms", "quantization"});
+    else
+        batch_shader.interface("transforms");
 
     // load multiple objects from a file
     std::string path = "object/";
     std::vector<Model *> models = object::load_all({path + "Section4"}, color::silver);
     model_size = models.size() - 1;
 
-    // store diffuse color info
-    std::vector<std::vector<glm::vec4>> default_colors;
-    for (auto const &model : models)
+    // the palette is complete once every model is loaded
+    if (object::compressed)
     {
-        // get the color information
-        std::vector<glm::vec4> color;
-        color.resize(model->size);
-        model->buffers["in_Color"]->retrieve(color);
-
-        default_colors.push_back(color);
+        std::vector<glm::vec4> palette = object::palette();
+        palette.resize(object::palette_size, glm::vec4(0.0f));
+        for (Shader *s : {&shader, &batch_shader})
+        {
+            s->use();
+            s->uniform("palette", palette);
+        }
     }
 
-    // create the octree
-    OctreeNode const *octree = BuildOctTree(models, Center(models), Longest(models), 8);
-
-    // create the bsp tree
-    std::vector<triangle> world_triangles;
-    std::vector<int> model_index;
-    std::vector<std::vector<size_t>> model_indices;
-    for (size_t j = 0; j < models.size(); ++j)
-    {
-        // get the vertex information
-        std::vector<glm::vec3> vertices;
-        vertices.resize(models[j]->size);
-        models[j]->buffers["in_Position"]->retrieve(vertices);
-
-        for (size_t i = 0; i < vertices.size(); i += 3)
-        {
-            triangle temp;
-            temp.points[0] = vertices[i];
-            temp.points[1] = vertices[i + 1];
-            temp.points[2] = vertices[i + 2];
+    // store diffuse color info, the gpu copy is packed so keep the cpu colors
+    std::vector<std::vector<glm::vec4>> default_colors;
+    OctreeNode const *octree = nullptr;
+    BSPNode const *bsp_tree = nullptr;
 
-            world_triangles.push_back(temp);
+    // partition the models, repeated when a watched model is reloaded
+    auto partition = [&]() {
+        default_colors.clear();
+        for (auto const &model : models)
+            default_colors.push_back(model->color);
 
-            model_index.push_back(static_cast<int>(j));
+        // create the octree
+        DeleteOctTree(octree);
+        octree = BuildOctTree(models, Center(models), Longest(models), 8);
 
-            std::vector<size_t> temp_v;
-            temp_v.push_back(i);
-            temp_v.push_back(i + 1);
-            temp_v.push_back(i + 2);
-            model_indices.push_back(temp_v);
+        // create the bsp tree
+        std::vector<triangle> world_triangles;
+        std::vector<int> model_index;
+        std::vector<std::vector<size_t>> model_indices;
+        for (size_t j = 0; j < models.size(); ++j)
+        {
+            // get the vertex information
+            std::vector<glm::vec3> vertices = models[j]->positions();
+
+            for (size_t i = 0; i < vertices.size(); i += 3)
+            {
+                triangle temp;
+                temp.points[0] = vertices[i];
+                temp.points[1] = vertices[i + 1];
+                temp.points[2] = vertices[i + 2];
+
+                world_triangles.push_back(temp);
+
+                model_index.push_back(static_cast<int>(j));
+
+                std::vector<size_t> temp_v;
+                temp_v.push_back(i);
+                temp_v.push_back(i + 1);
+                temp_v.push_back(i + 2);
+                model_indices.push_back(temp_v);
+            }
         }
-    }
 
-    BSPNode const *bsp_tree = BuildBSPTree(world_triangles, models, 8, model_index, model_indices);
+        DeleteBSPTree(bsp_tree);
+        bsp_tree = BuildBSPTree(world_triangles, models, 8, model_index, model_indices);
+    };
+    partition();
 
     // load debug objects
     Cube cube;
@@ -85,6 +114,30 @@ int main(int argc, char *args[])
     for (auto const &model : models)
         model->model = glm::translate(glm::mat4(1), translate);
 
+    // merge the static models into a single batch
+    Batch batch({"in_Position", "in_Normal", "in_Color"});
+    for (auto const &model : models)
+        batch.add(model);
+    batch.build();
+
+    // cull the batch on the gpu
+    Cull cull(&batch);
+
+    // --watch reloads edited shaders and obj parts while running, the batch, its culling
+    // and the trees copied the geometry of the models and are rebuilt after a reload
+    if (parse::flags.contains("watch"))
+    {
+        watch::shader(&shader);
+        watch::shader(&batch_shader);
+        for (auto *model : models)
+            watch::model(model, color::silver, [&]() {
+                partition();
+                batch.build();
+                cull.update();
+                needs_update = true;
+            });
+    }
+
     // helper function to render entire tree
     std::function<void(OctreeNode const *)> render_octree = [&](OctreeNode const *node) {
         // base case
@@ -115,17 +168,22 @@ int main(int argc, char *args[])
         Art::view.target(color::black); // target screen
 
         // update shader lighting
-        shader.use();
-        shader.uniform("vp", proj * view);
-        shader.uniform("camera", pos);
-        shader.uniform("pointlightpos", plightpos);
-        shader.uniform("pointlightfar", pointfar);
-        shader.uniform("pointlighton", on);
-        shader.uniform("pointlightcolor", lightcolor);
-        shader.uniform("brightness", brightness);
-        shader.uniform("attenuation", attenuation);
-
-        shader.uniform("renderbv", false);
+        auto lighting = [&](Shader &s) {
+            s.use();
+            s.uniform("vp", proj * view);
+            s.uniform("camera", pos);
+            s.uniform("pointlightpos", plightpos);
+            s.uniform("pointlightfar", pointfar);
+            s.uniform("pointlighton", on);
+            s.uniform("pointlightcolor", lightcolor);
+            s.uniform("brightness", brightness);
+            s.uniform("attenuation", attenuation);
+            s.uniform("renderbv", false);
+        };
+
+        // compressed models read palette indices, the bsp colors are not in the palette
+        if (object::compressed)
+            needs_update = false;
 
         if (!use_bsp && needs_update)
         {
@@ -142,20 +200,47 @@ int main(int argc, char *args[])
         }
 
 
-        // render models using diffuse rendering
-        for (auto const &model : models)
+        // pick the detail level of every model from its projected size, the bsp colors only cover full detail
+        if (use_lod && !use_bsp)
+            lod::select(models, view, proj, static_cast<float>(Art::view.height()));
+        else
+            for (auto *model : models)
+                model->level = 0;
+        batch.detail();
+        triangles = lod::triangles(models);
+
+        // render models using diffuse rendering, the batch draws every model at once
+        if (!use_bsp)
         {
-            shader.uniform("model", model->model);
-            if (!use_bsp)
-                model->render(GL_TRIANGLES);
+            if (use_culling)
+                cull.dispatch(proj * view);
+
+            lighting(batch_shader);
+            if (use_culling)
+                cull.render(GL_TRIANGLES);
             else
+                batch.render(GL_TRIANGLES);
+        }
+
+        lighting(shader);
+        if (use_bsp)
+        {
+            for (auto const &model : models)
+            {
+                shader.uniform("model", model->model);
+                shader.uniform("origin", model->origin);
+                shader.uniform("extent", model->extent);
                 model->render(GL_LINES);
+            }
         }
 
         // reset color index and render octree
         if (use_octree)
         {
+            // debug cubes are not quantized, the identity box keeps their positions
             shader.uniform("renderbv", true);
+            shader.uniform("origin", glm::vec3(0.0f));
+            shader.uniform("extent", glm::vec3(1.0f));
             render_octree(octree);
         }
 
@@ -170,6 +255,8 @@ int main(int argc, char *args[])
     Art::quit();
 
     // cleanup
+    DeleteOctTree(octree);
+    DeleteBSPTree(bsp_tree);
     for (auto &m : models)
         delete m;
 
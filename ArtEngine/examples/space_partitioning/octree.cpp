@@ -57,6 +57,17 @@ OctreeNode *BuildOctTree(std::vector<Model *> const &models, glm::vec3 const &ce
     return node;
 }
 
+// release a tree built by BuildOctTree
+void DeleteOctTree(OctreeNode const *node)
+{
+    if (node == nullptr)
+        return;
+
+    for (auto const *child : node->children)
+        DeleteOctTree(child);
+    delete node;
+}
+
 bool inside(glm::vec3 const &a, glm::vec3 const &b, glm::vec3 const &c)
 {
     return a.x <= b.x && a.y <= b.y && a.z <= b.z && a.x >= c.x && a.y >= c.y && a.z >= c.z;
@@ -71,9 +82,7 @@ int TriangleCount(std::vector<Model *> const &models, glm::vec3 const &center, f
     for (auto const & model : models)
     {
         // get the vertex information
-        std::vector<glm::vec3> points;
-        points.resize(model->size);
-        model->buffers["in_Position"]->retrieve(points);
+        std::vector<glm::vec3> points = model->positions();
 
         for (size_t i = 0; i < points.size(); i += 3)
         {
@@ -33,6 +33,9 @@ struct OctreeNode
 
 OctreeNode *BuildOctTree(std::vector<Model *> const &models, glm::vec3 const &center, float half_size, int depth);
 
+// release a tree built by BuildOctTree
+void DeleteOctTree(OctreeNode const *node);
+
 // get number of triangles withing a given range given a center and half size
 int TriangleCount(std::vector<Model *> const &models, glm::vec3 const &center, float half_size, glm::vec4 const &color);
 
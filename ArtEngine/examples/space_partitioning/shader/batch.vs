@@ -0,0 +1,53 @@
+#version 430
+
+#ifdef COMPRESSED
+#include "compressed.glsl"
+
+in vec3 in_Position;// 16 bit offsets within the aabb
+in vec2 in_Normal;  // octahedral
+in uint in_Color;   // palette index
+
+// per-draw origin and extent of the quantized positions
+layout (std430) buffer quantization
+{
+    vec4 boxes[];
+};
+
+uniform vec4 palette[PALETTE_SIZE];
+#else
+in vec3 in_Position;
+in vec3 in_Normal;
+in vec4 in_Color;
+#endif
+in uint in_DrawID;
+
+// per-draw model matrices of the batch
+layout (std430) buffer transforms
+{
+    mat4 models[];
+};
+
+uniform mat4 vp;
+uniform mat4 dbvp;
+
+out vec4 ex_Color;
+out vec3 ex_Normal;
+out vec3 ex_Model;//Model Space
+out vec4 ex_Shadow;//Shadow Space
+out vec4 ex_Frag;
+
+void main(void)
+{
+#ifdef COMPRESSED
+    vec3 position = boxes[2 * in_DrawID].xyz + in_Position * boxes[2 * in_DrawID + 1].xyz;
+    ex_Model = (models[in_DrawID] * vec4(position, 1.0f)).xyz;
+    ex_Normal = octahedral(in_Normal);
+    ex_Color = palette[in_Color];
+#else
+    ex_Model = (models[in_DrawID] * vec4(in_Position, 1.0f)).xyz;
+    ex_Normal = in_Normal;
+    ex_Color = in_Color;
+#endif
+    ex_Shadow = dbvp * vec4(ex_Model, 1.0f);
+    gl_Position = vp * vec4(ex_Model, 1.0f);
+}
@@ -0,0 +1,10 @@
+// decoding of the compressed vertex attributes, see object::compressed
+
+// unit vector from its octahedral projection
+vec3 octahedral(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0)// unfold the lower hemisphere
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
@@ -0,0 +1,82 @@
+#version 430
+
+layout (local_size_x = 64) in;
+
+// model space bounding volumes of a draw
+struct Bounds
+{
+    vec4 sphere;// center (xyz), radius (w)
+    vec4 min;
+    vec4 max;
+};
+
+layout (std430) readonly buffer bounds
+{
+    Bounds volumes[];
+};
+
+layout (std430) readonly buffer transforms
+{
+    mat4 models[];
+};
+
+// indirect commands of the batch, the draw id is the last field of a command
+layout (std430) readonly buffer commands
+{
+    uint source[];
+};
+
+// compacted visible commands
+layout (std430) writeonly buffer culled
+{
+    uint destination[];
+};
+
+layout (std430) buffer draw_count
+{
+    uint counts[];
+};
+
+uniform vec4 planes[6];// frustum planes (normal, distance)
+uniform int draws;     // number of commands
+uniform int stride;    // fields per command
+uniform int slot;      // counter of the command list
+
+bool visible(uint id)
+{
+    mat4 model = models[id];
+    Bounds b = volumes[id];
+
+    // bounding sphere in world space
+    vec3 center = (model * vec4(b.sphere.xyz, 1.0)).xyz;
+    float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    float radius = b.sphere.w * scale;
+    for (int i = 0; i < 6; ++i)
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius)
+            return false;
+
+    // world space extents of the aabb
+    center = (model * vec4(0.5 * (b.min.xyz + b.max.xyz), 1.0)).xyz;
+    vec3 extent = mat3(abs(model[0].xyz), abs(model[1].xyz), abs(model[2].xyz)) * (0.5 * (b.max.xyz - b.min.xyz));
+    for (int i = 0; i < 6; ++i)
+        if (dot(planes[i].xyz, center) + planes[i].w < -dot(abs(planes[i].xyz), extent))
+            return false;
+
+    return true;
+}
+
+void main(void)
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(draws))
+        return;
+
+    uint first = i * uint(stride);
+    if (!visible(source[first + uint(stride) - 1u]))
+        return;
+
+    // append the command to the visible list
+    uint index = atomicAdd(counts[slot], 1u) * uint(stride);
+    for (uint j = 0u; j < uint(stride); ++j)
+        destination[index + j] = source[first + j];
+}
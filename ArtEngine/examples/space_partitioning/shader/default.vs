@@ -1,8 +1,20 @@
 #version 330
 
+#ifdef COMPRESSED
+#include "compressed.glsl"
+
+in vec3 in_Position;// 16 bit offsets within the aabb
+in vec2 in_Normal;  // octahedral
+in uint in_Color;   // palette index
+
+uniform vec3 origin;
+uniform vec3 extent;
+uniform vec4 palette[PALETTE_SIZE];
+#else
 in vec3 in_Position;
 in vec3 in_Normal;
 in vec4 in_Color;
+#endif
 
 uniform mat4 model;
 uniform mat4 vp;
@@ -16,9 +28,15 @@ out vec4 ex_Frag;
 
 void main(void)
 {
+#ifdef COMPRESSED
+    ex_Model = (model * vec4(origin + in_Position * extent, 1.0f)).xyz;
+    ex_Normal = octahedral(in_Normal);
+    ex_Color = palette[in_Color];
+#else
     ex_Model = (model * vec4(in_Position, 1.0f)).xyz;
     ex_Normal = in_Normal;
+    ex_Color = in_Color;
+#endif
     ex_Shadow = dbvp * vec4(ex_Model, 1.0f);
     gl_Position = vp * vec4(ex_Model, 1.0f);
-    ex_Color = in_Color;
 }
@@ -6,9 +6,11 @@
  \namespaces:  Art
 
  \functions:   sig_handler
+               configure
                init
                window
                quit
+               present
 
  \origin:      ArtEngine
 
@@ -24,7 +26,9 @@ View view;
 Event event;
 
 bool benchmark = false;
-int average = 0;
+Headless headless;
+
+static std::unique_ptr<Capture> recording; // png output of headless frames
 
 /*!F+F**************************************************************************
  \function: sig_handler
@@ -38,6 +42,64 @@ void sig_handler(int signal)
     event.quit(true);
 }
 
+/*!F+F**************************************************************************
+ \function: configure
+
+ \summary:  read the headless and frame pacing settings from the parsed
+            command line and prepare the environment before sdl creates the
+            context
+**************************************************************************F-F!*/
+static void configure()
+{
+    if (parse::flags.contains("headless"))
+        headless.enabled = true;
+    if (parse::flags.contains("software"))
+        headless.software = true;
+    if (parse::options.contains("frames"))
+        headless.frames = std::max(1, std::stoi(parse::options["frames"]));
+    if (parse::options.contains("width"))
+        headless.width = std::stoi(parse::options["width"]);
+    if (parse::options.contains("height"))
+        headless.height = std::stoi(parse::options["height"]);
+    if (parse::options.contains("output"))
+        headless.output = parse::options["output"];
+
+    // mesh cache, off unless a directory is given
+    if (parse::options.contains("meshes"))
+        object::cache = parse::options["meshes"];
+
+    // frame pacing, headless frames run as fast as they render
+    if (parse::options.contains("fps") && !headless.enabled)
+        pacing::fps = std::max(0.0, std::stod(parse::options["fps"]));
+    if (parse::options.contains("ahead"))
+        pacing::latency = std::max(0, std::stoi(parse::options["ahead"]));
+    if (parse::flags.contains("adaptive"))
+        view.m_adaptive = true;
+    if (parse::flags.contains("pacing"))
+        pacing::show = true;
+
+    if (!headless.enabled)
+        return;
+    if (headless.width <= 0)
+        headless.width = 1280;
+    if (headless.height <= 0)
+        headless.height = 720;
+
+#ifdef __linux__
+    // mesa picks the llvmpipe rasterizer, no gpu or display server required
+    if (headless.software)
+    {
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+        setenv("GALLIUM_DRIVER", "llvmpipe", 1);
+    }
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 22)
+    // egl pbuffer context without a display, falls back to a hidden window in init
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+#endif
+}
+
 /*!F+F**************************************************************************
  \function: init
 
@@ -48,9 +110,22 @@ void sig_handler(int signal)
 **************************************************************************F-F!*/
 bool init()
 {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    configure();
+
+    // workers start before any other thread exists, the main thread becomes worker 0
+    job::init();
+
+    bool initialized = SDL_Init(SDL_INIT_VIDEO) >= 0;
+    if (!initialized && headless.enabled)
     {
-        std::cout << "SDL could not initialize! Error: " << SDL_GetError() << std::endl;
+        // offscreen driver unavailable, use a hidden window of the default driver
+        my_log::error("Offscreen video driver unavailable (", SDL_GetError(), "), using a hidden window.");
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "");
+        initialized = SDL_Init(SDL_INIT_VIDEO) >= 0;
+    }
+    if (!initialized)
+    {
+        my_log::error("SDL could not initialize! Error: ", SDL_GetError());
         return false;
     }
 
@@ -61,21 +136,40 @@ bool init()
 
     if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG))
     {
-        std::cout << "SDL_Image could not initialize! Error: " << IMG_GetError() << std::endl;
+        my_log::error("SDL_Image could not initialize! Error: ", IMG_GetError());
         return false;
     }
 
     if (TTF_Init() == -1)
     {
-        std::cout << "SDL_ttf could not initialize! Error: " << TTF_GetError() << std::endl;
+        my_log::error("SDL_ttf could not initialize! Error: ", TTF_GetError());
         return false;
     }
 
     signal(SIGINT, &sig_handler);
 
+    if (headless.enabled)
+    {
+        // every frame is drawn into a target instead of the window
+        view.windowed(false);
+        view.m_show_interface = false;
+        view.vsync(false);
+        if (!view.init("ArtEngine Headless Context", headless.width, headless.height))
+        {
+            my_log::error("Failed to launch OpenGL Context.");
+            return false;
+        }
+        headless.target = new Billboard(headless.width, headless.height);
+        view.m_fbo = headless.target->m_fbo;
+        view.m_enabled = true;
+        if (!headless.output.empty())
+            recording = std::make_unique<Capture>(headless.output, Capture::Settings{.policy = Capture::Policy::block});
+        return true;
+    }
+
     if (!view.windowed() && !view.init("ArtEngine OpenGL Context", 0, 0))
     {
-        std::cout << "Failed to launch OpenGL Context" << std::endl;
+        my_log::error("Failed to launch OpenGL Context.");
         return false;
     }
 
@@ -89,6 +183,12 @@ bool init()
 **************************************************************************F-F!*/
 void quit()
 {
+    recording.reset();
+    delete headless.target;
+    headless.target = nullptr;
+    watch::stop();
+    job::shutdown();
+    my_log::stop();
     if (view.enabled())
         view.quit();
     TTF_Quit();
@@ -111,17 +211,41 @@ bool window(std::string window_name, int width, int height)
 {
     view.windowed(true);
 
+    // headless runs render at the window size unless overridden
+    if (!headless.width)
+        headless.width = width;
+    if (!headless.height)
+        headless.height = height;
     if (!init())
         return false;
+    if (headless.enabled)
+        return true;
 
     // start the visual interface
     if (!view.init(window_name, width, height))
     {
-        std::cout << "Failed to launch visual interface." << std::endl;
+        my_log::error("Failed to launch visual interface.");
         return false;
     }
 
     return true;
 }
 
-} // namespace Art
\ No newline at end of file
+/*!F+F**************************************************************************
+ \function: present
+
+ \summary:  finish a headless frame, the target is handed to the capture when
+            an output is set and the loop quits after the requested frames
+**************************************************************************F-F!*/
+void present()
+{
+    if (recording)
+        recording->frame(headless.target);
+    else
+        glFinish(); // account for the gpu work of the frame in the frame time
+
+    if (++headless.rendered >= headless.frames)
+        event.quit(true);
+}
+
+} // namespace Art
@@ -5,11 +5,15 @@
 
  \namespaces:  Art
 
+ \structs:     Headless
+
  \functions:   sig_handler
                init
                window
                quit
+               present
                loop
+               simulate
 
  \origin:      ArtEngine
 
@@ -25,6 +29,10 @@
 #include "view.h"
 #include "event.h"
 #include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/pacing.h"
+#include "helpers/job.h"
+#include "helpers/snapshot.h"
 
 namespace Art
 {
@@ -38,13 +46,43 @@ void quit();
 
 bool window(std::string window_name, int width, int height);
 
-extern bool benchmark; //!< benchmark the game loop
-extern int average;    //!< average for benchmarking the game loop
+extern bool benchmark; //!< profile the game loop
+
+/*!S+S**************************************************************************
+ \struct:   Headless
+
+ \summary:  offscreen rendering for batch jobs and regression runs, selected
+            with parse::get flags before Art::init or Art::window
+
+            --headless      render without a visible window into a target
+            --software      force the mesa software rasterizer (llvmpipe)
+            -frames n       frames rendered before the loop exits
+            -width n        target width, defaults to the window width
+            -height n       target height, defaults to the window height
+            -output prefix  save every frame as a numbered png
+**************************************************************************S-S!*/
+struct Headless
+{
+    bool enabled = false;        //!< render offscreen
+    bool software = false;       //!< use the software rasterizer
+    int frames = 1;              //!< frames rendered before quitting
+    int width = 0;               //!< target width, 0 uses the window width
+    int height = 0;              //!< target height, 0 uses the window height
+    std::string output;          //!< png prefix of the frames, none if empty
+    int rendered = 0;            //!< frames rendered so far
+    Billboard *target = nullptr; //!< framebuffer the view renders into
+};
+
+extern Headless headless; //!< offscreen settings (filled from parse::get)
+
+void present();
 
 /*!F+F**************************************************************************
  \function: loop
 
- \summary:  perform the game loop with or without benchmarking data
+ \summary:  perform the game loop, every phase is a profiler zone recorded
+            while benchmarking is enabled, rendering is measured on the gpu
+            as well, every frame is paced by pacing::begin
 
  \arg:      function - user-defined game loop
  \arg:      args -user defined function arguments
@@ -52,55 +90,156 @@ extern int average;    //!< average for benchmarking the game loop
 template <typename F, typename... Args>
 void loop(F function, Args &&...args)
 {
-    // perform the loop without benchmarking data
-    if (!benchmark)
+    profiler::enabled = benchmark;
+    profiler::name("main");
+
+    while (!event.quit())
     {
-        while (!event.quit())
+        pacing::begin(); // frame cap and gpu run-ahead, right before the input is taken
+
         {
+            ART_PROFILE("Frame");
+
             if (view.enabled())
             {
-                event.input();      // get input
+                ART_PROFILE("Event Input");
+                event.input(); // get input
+            }
+            if (view.enabled())
+            {
+                ART_PROFILE("Event Handling");
                 event.handle(view); // call event-handling system
             }
 
-            function(args...); // user-defined game loop
+            {
+                ART_PROFILE("Main Thread Jobs");
+                job::drain(); // gl-bound continuations queued by jobs
+            }
+
+            {
+                ART_PROFILE("Loop Function");
+                function(args...); // user-defined game loop
+            }
 
             if (view.enabled())
             {
+                ART_PROFILE("Render Pipeline");
+                ART_PROFILE_GPU("Render Pipeline");
                 view.render(); // render the view
             }
+
+            if (headless.enabled)
+                present(); // capture the offscreen frame, quit after the last one
         }
-        return; // completed main loop
+
+        profiler::frame(); // aggregate the zones of the frame
     }
+}
 
-    // perform the loop with benchmarking data
-    while (!event.quit())
-    {
-        if (view.enabled())
+/*!F+F**************************************************************************
+ \function: simulate
+
+ \summary:  perform the game loop with the simulation decoupled from rendering,
+            the update runs at a fixed tick rate on a simulation thread and
+            publishes its state into a double-buffered snapshot, the calling
+            thread owns the gl context, takes the input, drains the main
+            thread jobs and renders the latest snapshot at the display rate
+
+            the update must not touch gl or the view, gl work it produces is
+            queued with job::on_main, input reaches it through state the
+            event handler shares with it (e.g. a second snapshot), a tick that
+            falls more than a few ticks behind drops the backlog instead of
+            catching up forever
+
+ \arg:      state - initial simulation state, copied into the snapshots
+ \arg:      rate - simulation ticks per second
+ \arg:      update - called with the state and the tick length in seconds
+ \arg:      render - called with the latest state and the fraction of a tick
+                     elapsed since it was published, before the view renders
+**************************************************************************F-F!*/
+template <typename State, typename Update, typename Render>
+void simulate(State state, double rate, Update update, Render render)
+{
+    using Clock = std::chrono::steady_clock;
+
+    static int constexpr backlog = 4; // ticks the simulation may run behind before resynchronizing
+
+    profiler::enabled = benchmark;
+    profiler::name("main");
+
+    double const seconds = 1.0 / rate;
+    auto const tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    Snapshot<State> snapshot(state);
+    std::atomic<bool> simulating = true;
+    std::thread simulation([&, state]() mutable {
+        profiler::name("simulation");
+
+        auto next = Clock::now();
+        while (simulating.load(std::memory_order_acquire))
         {
-            // get input
-            std::cout << "Event Input ";
-            timer::benchmark<std::chrono::milliseconds>([&]() { event.input(); });
-            // call event-handling system
-            std::cout << "Event Handling ";
-            timer::benchmark<std::chrono::milliseconds>([&]() { event.handle(view); });
+            {
+                ART_PROFILE("Simulation Tick");
+                update(state, static_cast<float>(seconds));
+            }
+            next += tick;
+            snapshot.publish(state);
+
+            auto const now = Clock::now();
+            if (now - next > tick * backlog)
+                next = now;
+            std::this_thread::sleep_until(next);
         }
+    });
 
-        // user-defined game loop
-        std::cout << "Loop Function ";
-        timer::benchmark<std::chrono::microseconds>([&]() { function(args...); });
+    while (!event.quit())
+    {
+        pacing::begin(); // frame cap and gpu run-ahead, right before the input is taken
 
-        if (Art::view.enabled())
         {
-            // render view
-            std::cout << "Render Pipeline ";
-            double d = 0.99 * average + 0.01 * timer::benchmark<std::chrono::microseconds>([&]() {
-                                            view.render();
-                                            glFinish();
-                                        });
-            average = static_cast<int>(d);
+            ART_PROFILE("Frame");
+
+            if (view.enabled())
+            {
+                ART_PROFILE("Event Input");
+                event.input(); // get input
+            }
+            if (view.enabled())
+            {
+                ART_PROFILE("Event Handling");
+                event.handle(view); // call event-handling system
+            }
+
+            {
+                ART_PROFILE("Main Thread Jobs");
+                job::drain(); // gl-bound continuations queued by jobs and the simulation
+            }
+
+            State const &latest = snapshot.acquire();
+            {
+                ART_PROFILE("Render Function");
+                double const elapsed = std::chrono::duration<double>(Clock::now() - snapshot.stamp()).count();
+                render(latest, static_cast<float>(std::clamp(elapsed / seconds, 0.0, 1.0)));
+            }
+
+            if (view.enabled())
+            {
+                ART_PROFILE("Render Pipeline");
+                ART_PROFILE_GPU("Render Pipeline");
+                view.render(); // render the view, the pipeline may still read the snapshot
+            }
+            snapshot.release();
+
+            if (headless.enabled)
+                present(); // capture the offscreen frame, quit after the last one
         }
+
+        profiler::frame(); // aggregate the zones of the frame
     }
+
+    simulating.store(false, std::memory_order_release);
+    simulation.join();
+    job::drain(); // gl work queued by the last ticks
 }
 
 } // namespace Art
@@ -10,9 +10,16 @@
  \functions: Scroll::reset\n
              Event::input\n
              Event::handle\n
+             Event::subscribe\n
+             Event::unsubscribe\n
              Event::quit\n
              Event::key_down\n
-             Event::key_down\n
+             Event::key_up\n
+             Event::button_down\n
+             Event::button_up\n
+             Event::count\n
+             Event::event\n
+             Event::dropped\n
              Event::scroll\n
              Event::resize_window\n
 
@@ -46,14 +53,24 @@ void Scroll::reset()
 /*M+M***********************************************************************//*!
  \method:   Event::input
 
- \summary:  track inputs and add them to the stack
+ \summary:  clear the state of the previous frame, then track the new inputs
+            and record them in the event ring
 
  \modifies: [m_input, m_quit, m_key_down, m_key_up, m_scroll, m_mouse,
             m_mouse_move, m_button_down, m_button_up, m_window_event,
-            m_window_resize]
+            m_window_resize, m_events, m_first, m_count, m_dropped]
 ************************************************************************//*M-M*/
 void Event::input()
 {
+    // reset event triggers
+    m_key_up.reset();
+    m_button_up.reset();
+    m_scroll.reset();
+    m_mouse_move = false;
+    m_window_resize = false;
+    m_first = 0;
+    m_count = 0;
+
     while (SDL_PollEvent(&m_input))
     {
         ImGui_ImplSDL2_ProcessEvent(&m_input);
@@ -64,11 +81,11 @@ void Event::input()
             m_quit = true;
             break;
         case SDL_KEYDOWN:
-            m_key_down[m_input.key.keysym.sym] = true;
+            m_key_down.set(m_input.key.keysym.scancode);
             break;
         case SDL_KEYUP:
-            m_key_down[m_input.key.keysym.sym] = false;
-            m_key_up.push_front(static_cast<SDL_KeyCode>(m_input.key.keysym.sym));
+            m_key_down.reset(m_input.key.keysym.scancode);
+            m_key_up.set(m_input.key.keysym.scancode);
             break;
         case SDL_MOUSEWHEEL:
             m_scroll.positive_x = (m_input.wheel.x > 0.99);  // right
@@ -81,11 +98,11 @@ void Event::input()
             m_mouse_move = true;
             break;
         case SDL_MOUSEBUTTONDOWN:
-            m_button_down[m_input.button.button] = true;
+            m_button_down.set(m_input.button.button % m_button_down.size());
             break;
         case SDL_MOUSEBUTTONUP:
-            m_button_down[m_input.button.button] = false;
-            m_button_up.push_front(m_input.button.button);
+            m_button_down.reset(m_input.button.button % m_button_down.size());
+            m_button_up.set(m_input.button.button % m_button_up.size());
             break;
         case SDL_WINDOWEVENT:
             // only handle resizing events
@@ -98,17 +115,34 @@ void Event::input()
         default:
             break;
         }
+
+        push(m_input);
+    }
+}
+
+// record an event of the frame, a full ring overwrites its oldest event
+void Event::push(SDL_Event const &event)
+{
+    m_events[(m_first + m_count) % capacity] = event;
+    if (m_count < capacity)
+        ++m_count;
+    else
+    {
+        m_first = (m_first + 1) % capacity;
+        ++m_dropped;
     }
 }
 
 /*M+M***********************************************************************//*!
  \method:   Event::handle
 
- \summary:  event input handler
+ \summary:  event input handler, the events of the frame are dispatched to
+            their subscribers in the order they arrived before the
+            user-defined handler runs
 
  \args:     view - view to potentially resize
 
- \modifies: [m_key_up, m_button_up, m_scroll, m_mouse_move, m_window_resize]
+ \modifies: [m_subscribers, m_pending, m_dispatching]
 ************************************************************************//*M-M*/
 void Event::handle(View &view)
 {
@@ -118,34 +152,88 @@ void Event::handle(View &view)
         view.height(m_window_event.window.data2);
     }
 
+    // subscribers of a type are looked up once per event, no handler polls for it
+    m_dispatching = true;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        SDL_Event const &e = event(i);
+        auto it = m_subscribers.find(e.type);
+        if (it == m_subscribers.end())
+            continue;
+        for (auto const &subscriber : it->second)
+            if (subscriber.active)
+                subscriber.callback(e);
+    }
+    m_dispatching = false;
+
+    // apply the changes made by the subscribers, callbacks are only destroyed once none runs
+    for (auto &[type, subscribers] : m_subscribers)
+        std::erase_if(subscribers, [](Subscriber const &s) { return !s.active; });
+    for (auto &[type, subscriber] : m_pending)
+        m_subscribers[type].push_back(std::move(subscriber));
+    m_pending.clear();
+
     handler(); // call user-defined handler
 
-    if (!m_key_up.empty())
+    // toggle interface visibility
+    if (m_key_up[SDL_SCANCODE_ESCAPE])
+        view.toggle_interface();
+
+    // toggle fullscreen
+    if (m_key_up[SDL_SCANCODE_F11])
     {
-        // toggle interface visibility
-        if (m_key_up.back() == SDLK_ESCAPE)
-            view.toggle_interface();
+        view.toggle_fullscreen();
+        if (!view.fullscreen())
+            SDL_SetWindowFullscreen(view.window(), 0);
+        else
+            SDL_SetWindowFullscreen(view.window(), SDL_WINDOW_FULLSCREEN_DESKTOP);
+    }
+}
 
-        // toggle fullscreen
-        if (m_key_up.back() == SDLK_F11)
-        {
-            view.toggle_fullscreen();
-            if (!view.fullscreen())
-                SDL_SetWindowFullscreen(view.window(), 0);
-            else
-                SDL_SetWindowFullscreen(view.window(), SDL_WINDOW_FULLSCREEN_DESKTOP);
-        }
+/*M+M***********************************************************************//*!
+ \method:   Event::subscribe
 
-        m_key_up.pop_back();
-    }
+ \summary:  call a function for every event of a type, in arrival order during
+            handle, a subscription made while dispatching starts next frame
 
-    // reset event triggers
-    if (!m_button_up.empty())
-        m_button_up.pop_back();
+ \args:     type - sdl event type, e.g. SDL_KEYDOWN
+ \args:     callback - function receiving the event
 
-    m_scroll.reset();
-    m_mouse_move = false;
-    m_window_resize = false;
+ \modifies: [m_subscribers, m_pending, m_next_id]
+
+ \return:   size_t - id to unsubscribe with
+************************************************************************//*M-M*/
+size_t Event::subscribe(Uint32 type, Callback callback)
+{
+    Subscriber subscriber{m_next_id++, std::move(callback)};
+    size_t const id = subscriber.id;
+    if (m_dispatching)
+        m_pending.emplace_back(type, std::move(subscriber));
+    else
+        m_subscribers[type].push_back(std::move(subscriber));
+    return id;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Event::unsubscribe
+
+ \summary:  stop calling a subscribed function, safe to call from any callback
+            including its own, the callback is destroyed after the dispatch
+
+ \args:     id - id returned by subscribe
+
+ \modifies: [m_subscribers, m_pending]
+************************************************************************//*M-M*/
+void Event::unsubscribe(size_t id)
+{
+    for (auto &[type, subscribers] : m_subscribers)
+        for (auto &subscriber : subscribers)
+            if (subscriber.id == id)
+                subscriber.active = false; // the callback may be running, erased after the dispatch
+    std::erase_if(m_pending, [id](auto const &pending) { return pending.second.id == id; });
+    if (!m_dispatching)
+        for (auto &[type, subscribers] : m_subscribers)
+            std::erase_if(subscribers, [](Subscriber const &s) { return !s.active; });
 }
 
 /*M+M***********************************************************************//*!
@@ -178,24 +266,67 @@ void Event::quit(bool quit)
 /*M+M***********************************************************************//*!
  \method:   Event::key_down
 
- \summary:  accessor to check if a key is down
+ \summary:  accessor to check if a key is down, a single bit lookup
 
- \args:     key - SDL_Keycode to check
+ \args:     key - physical key to check
 
  \return:   True, if the key is down
  \return:   False, otherwise
 ************************************************************************//*M-M*/
-bool Event::key_down(SDL_Keycode key)
+bool Event::key_down(SDL_Scancode key) const
 {
     return m_key_down[key];
 }
 
-SDL_KeyCode Event::key_up() const
+// keycode of the current layout, translated to its scancode
+bool Event::key_down(SDL_Keycode key) const
 {
-    if (!m_key_up.empty())
-        return m_key_up.back();
-    else
-        return SDLK_UNKNOWN;
+    return key_down(SDL_GetScancodeFromKey(key));
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Event::key_up
+
+ \summary:  accessor to check if a key was released this frame
+
+ \args:     key - physical key to check
+
+ \return:   True, if the key was released
+ \return:   False, otherwise
+************************************************************************//*M-M*/
+bool Event::key_up(SDL_Scancode key) const
+{
+    return m_key_up[key];
+}
+
+// the mouse button is down, SDL_BUTTON_LEFT to SDL_BUTTON_X2
+bool Event::button_down(Uint8 button) const
+{
+    return m_button_down[button % m_button_down.size()];
+}
+
+// the mouse button was released this frame
+bool Event::button_up(Uint8 button) const
+{
+    return m_button_up[button % m_button_up.size()];
+}
+
+// events recorded this frame
+size_t Event::count() const
+{
+    return m_count;
+}
+
+// event i of the frame, oldest first, the sdl timestamp tells when it arrived
+SDL_Event const &Event::event(size_t i) const
+{
+    return m_events[(m_first + i) % capacity];
+}
+
+// events overwritten by a full ring since the start
+size_t Event::dropped() const
+{
+    return m_dropped;
 }
 
 /*M+M***********************************************************************//*!
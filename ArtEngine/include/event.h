@@ -1,7 +1,10 @@
 /*+*************************************************************************//*!
  \file:      event.h
 
- \summary:   track and handle events
+ \summary:   track and handle events, key and button state lives in flat
+             bitsets indexed by scancode and button, the events of a frame are
+             kept in a fixed ring buffer with their sdl timestamps and handed
+             to the callbacks subscribed to their type
 
  \structs    Scroll
  \classes:   Event
@@ -9,9 +12,17 @@
  \functions: Scroll::reset\n
              Event::input\n
              Event::handle\n
+             Event::subscribe\n
+             Event::unsubscribe\n
              Event::handler\n
              Event::quit\n
              Event::key_down\n
+             Event::key_up\n
+             Event::button_down\n
+             Event::button_up\n
+             Event::count\n
+             Event::event\n
+             Event::dropped\n
              Event::scroll\n
              Event::resize_window\n
 
@@ -44,57 +55,101 @@ struct Scroll
 /*C+C***********************************************************************//*!
  \class:    Event
 
- \summary:  track and handle input events
+ \summary:  track and handle input events, the per-frame state is cleared by
+            input so the cost of a frame only depends on its own events
 
- \methods:  input - take inputs and add them to the stack\n
-         :  handle - general event handler\n
+ \methods:  input - clear the previous frame and take the new inputs\n
+         :  handle - general event handler, dispatches the frame's events\n
+         :  subscribe - call a function for every event of a type\n
+         :  unsubscribe - remove a subscribed function\n
          :  handler - user-defined event handler\n
          :  quit - accessor to get if shutdown was called\n
          :  key_down - accessor to check if a key is down\n
+         :  key_up - accessor to check if a key was released this frame\n
+         :  button_down - accessor to check if a mouse button is down\n
+         :  button_up - accessor to check if a button was released this frame\n
+         :  count - accessor to get the number of events of the frame\n
+         :  event - accessor to get an event of the frame, oldest first\n
+         :  dropped - accessor to get the events lost to a full ring\n
          :  scroll - accessor to get scroll directions\n
          :  resize_window - accessor to check if the window was resized\n
 ************************************************************************//*C-C*/
 class Event
 {
   public:
+    using Callback = std::function<void(SDL_Event const &)>;
+
+    static size_t constexpr capacity = 256; //!< events kept per frame, older ones are overwritten
+
     void input();
     void handle(View &view);
 
+    size_t subscribe(Uint32 type, Callback callback);
+    void unsubscribe(size_t id);
+
     // user-defined
     Handle handler = []{}; //!< user-defined event handler
 
     // accessors
     [[nodiscard]] bool quit() const;
     void quit(bool quit);
-    [[nodiscard]] bool key_down(SDL_Keycode key);
-    [[nodiscard]] SDL_KeyCode key_up() const;
+    [[nodiscard]] bool key_down(SDL_Scancode key) const;
+    [[nodiscard]] bool key_down(SDL_Keycode key) const;
+    [[nodiscard]] bool key_up(SDL_Scancode key) const;
+    [[nodiscard]] bool button_down(Uint8 button) const;
+    [[nodiscard]] bool button_up(Uint8 button) const;
+    [[nodiscard]] size_t count() const;
+    [[nodiscard]] SDL_Event const &event(size_t i) const;
+    [[nodiscard]] size_t dropped() const;
     [[nodiscard]] Scroll scroll() const;
     [[nodiscard]] bool resize_window() const;
 
   private:
+    // function subscribed to an event type
+    struct Subscriber
+    {
+        size_t id;          //!< handle returned by subscribe
+        Callback callback;  //!< called per event
+        bool active = true; //!< false once unsubscribed, erased after the dispatch
+    };
+
+    void push(SDL_Event const &event);
+
     // public variables
     bool m_quit = false;      //!< shutdown
     bool m_toggle_fullscreen; //!< switch between fullscreen view
 
     // keyboard events
-    std::unordered_map<SDL_Keycode, bool> m_key_down; //!< active keys
-    std::deque<SDL_KeyCode> m_key_up;                 //!< key released
+    std::bitset<SDL_NUM_SCANCODES> m_key_down; //!< active keys
+    std::bitset<SDL_NUM_SCANCODES> m_key_up;   //!< keys released this frame
 
     // movement events
     SDL_MouseMotionEvent m_mouse; //!< active mouse
     bool m_mouse_move = false;    //!< mouse in motion
 
     // clicking events
-    std::unordered_map<Uint8, bool> m_button_down; //!< active buttons
-    std::deque<Uint8> m_button_up;                 //!< button released
+    std::bitset<8> m_button_down; //!< active buttons
+    std::bitset<8> m_button_up;   //!< buttons released this frame
 
     // scroll events
-    Scroll m_scroll;              //!< scroll directions
+    Scroll m_scroll{};            //!< scroll directions
     SDL_Event m_window_event;     //!< window resizing event
     bool m_window_resize = false; //!< window is resizing
 
     SDL_Event m_input; //!< SDL general events
 
+    // events of the frame
+    std::array<SDL_Event, capacity> m_events; //!< ring of the frame's events
+    size_t m_first = 0;                       //!< oldest event in the ring
+    size_t m_count = 0;                       //!< events in the ring
+    size_t m_dropped = 0;                     //!< events overwritten since the start
+
+    // subscriptions
+    std::unordered_map<Uint32, std::vector<Subscriber>> m_subscribers; //!< functions by event type
+    std::vector<std::pair<Uint32, Subscriber>> m_pending;              //!< subscribed while dispatching
+    size_t m_next_id = 0;                                              //!< id of the next subscription
+    bool m_dispatching = false;                                        //!< handle is calling subscribers
+
 }; // class Event
 
 #endif // ARTENGINE_EVENT_H
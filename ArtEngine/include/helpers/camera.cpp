@@ -255,29 +255,29 @@ std::function<bool()> handler = []() {
         pan(-turn_rate);
 
     // arrow keys to tilt / pan
-    if (Art::event.key_down(SDLK_UP))
+    if (Art::event.key_down(SDL_SCANCODE_UP))
         tilt(turn_rate);
-    if (Art::event.key_down(SDLK_DOWN))
+    if (Art::event.key_down(SDL_SCANCODE_DOWN))
         tilt(-turn_rate);
-    if (Art::event.key_down(SDLK_LEFT))
+    if (Art::event.key_down(SDL_SCANCODE_LEFT))
         pan(turn_rate);
-    if (Art::event.key_down(SDLK_RIGHT))
+    if (Art::event.key_down(SDL_SCANCODE_RIGHT))
         pan(-turn_rate);
 
     // WASD keys to stride / strafe
-    if (Art::event.key_down(SDLK_w))
+    if (Art::event.key_down(SDL_SCANCODE_W))
         stride(-move_rate);
-    if (Art::event.key_down(SDLK_a))
+    if (Art::event.key_down(SDL_SCANCODE_A))
         strafe(move_rate);
-    if (Art::event.key_down(SDLK_s))
+    if (Art::event.key_down(SDL_SCANCODE_S))
         stride(move_rate);
-    if (Art::event.key_down(SDLK_d))
+    if (Art::event.key_down(SDL_SCANCODE_D))
         strafe(-move_rate);
 
     // shift / space to rise / fall
-    if (Art::event.key_down(SDLK_LSHIFT))
+    if (Art::event.key_down(SDL_SCANCODE_LSHIFT))
         rise(move_rate);
-    if (Art::event.key_down(SDLK_SPACE))
+    if (Art::event.key_down(SDL_SCANCODE_SPACE))
         rise(-move_rate);
 
     // window resizing
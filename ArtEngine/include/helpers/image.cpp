@@ -1,5 +1,10 @@
 #include "../pch.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARTENGINE_IMAGE_SSE2
+#endif
+
 namespace image
 {
 
@@ -7,8 +12,7 @@ SDL_Surface *load(std::string path)
 {
     SDL_Surface *loaded = IMG_Load(path.c_str());
     if (!loaded)
-        std::cout << "Error: Unable to load image " << path.c_str() << "SDL_image Error: " << IMG_GetError()
-                  << std::endl;
+        my_log::error("Unable to load image ", path.c_str(), "SDL_image Error: ", IMG_GetError());
     SDL_Surface *optimized = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
     SDL_FreeSurface(loaded);
     return optimized;
@@ -19,59 +23,508 @@ void save(SDL_Surface *surface, std::string path)
     IMG_SavePNG(surface, path.c_str());
 }
 
-void save(Target target, std::string path)
+// blocking save of a target, use Capture or a Readback to keep the render loop running
+void save(Target *target, std::string path)
 {
-    SDL_Surface *surface = SDL_CreateRGBSurface(0, target.m_width, target.m_height, 32, 0, 0, 0, 0);
-    SDL_LockSurface(surface);
+    Readback readback;
+    readback.read(target);
+    save(readback, path);
+}
+
+/*F+F***********************************************************************//*!
+ \function: save
+
+ \summary:  save the pixels of a framebuffer readback (RGBA, unsigned bytes),
+            waits for the copy if it has not completed yet, poll
+            Readback::ready first to avoid the stall
+
+ \args:     readback - pending framebuffer readback
+ \args:     path - image path
+************************************************************************//*F-F*/
+void save(Readback &readback, std::string path)
+{
+    if (!readback.pending() || readback.m_size.x <= 0 || readback.m_size.y <= 0)
+        return;
+
+    int const width = readback.m_size.x;
+    int const height = readback.m_size.y;
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+    readback.retrieve(pixels);
 
-    target.sample(surface->pixels, glm::vec2(0), glm::vec2(target.m_width, target.m_height));
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_LockSurface(surface);
+    // framebuffer rows run bottom to top
+    unsigned char *image_raw = static_cast<unsigned char *>(surface->pixels);
+    for (int y = 0; y < height; ++y)
+        std::memcpy(image_raw + y * surface->pitch, pixels.data() + (height - 1 - y) * width * 4, width * 4);
     SDL_UnlockSurface(surface);
+
     save(surface, path);
+    SDL_FreeSurface(surface);
+}
 
-    delete surface;
+////////////////////////////////////////////////////////////////////////////////
+//// GENERATION
+////////////////////////////////////////////////////////////////////////////////
+
+Framebuffer::Framebuffer(int width, int height)
+    : width(width)
+    , height(height)
+    , r(static_cast<size_t>(width) * height)
+    , g(static_cast<size_t>(width) * height)
+    , b(static_cast<size_t>(width) * height)
+    , a(static_cast<size_t>(width) * height)
+{
 }
 
-SDL_Surface *make(std::function<glm::vec4(int)> handle, glm::vec2 size)
+// float component in [0, 1] to a rounded byte
+static Uint8 to_byte(float c)
 {
-    SDL_Surface *surface = SDL_CreateRGBSurface(0, size.x, size.y, 32, 0, 0, 0, 0);
-    SDL_LockSurface(surface);
+    return static_cast<Uint8>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
 
-    unsigned char *image_raw = static_cast<unsigned char *>(surface->pixels);
-    for (int i = 0; i < size.x * size.y; ++i)
+/*F+F***********************************************************************//*!
+\function: pack
+
+\summary:  convert colors to RGBA8, components are clamped to [0, 1] and
+           rounded, four pixels are converted per step with sse2
+
+\args:     colors - float colors
+\args:     pixels - RGBA8 output, 4 * count bytes
+\args:     count - number of pixels
+************************************************************************//*F-F*/
+void pack(glm::vec4 const *colors, Uint8 *pixels, int count)
+{
+    int i = 0;
+#ifdef ARTENGINE_IMAGE_SSE2
+    float const *in = &colors[0].r;
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const scale = _mm_set1_ps(255.0f);
+    for (; i + 4 <= count; i += 4)
     {
-        glm::vec4 color = handle(i);
-        *(image_raw + 4 * i) = static_cast<unsigned char>(255 * color.r);
-        *(image_raw + 4 * i + 1) = static_cast<unsigned char>(255 * color.g);
-        *(image_raw + 4 * i + 2) = static_cast<unsigned char>(255 * color.b);
-        *(image_raw + 4 * i + 3) = static_cast<unsigned char>(255 * color.a);
+        // one pixel per register, cvtps rounds to nearest
+        __m128i p[4];
+        for (int j = 0; j < 4; ++j)
+        {
+            __m128 const c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + 4 * (i + j)), zero), one);
+            p[j] = _mm_cvtps_epi32(_mm_mul_ps(c, scale));
+        }
+        __m128i const bytes = _mm_packus_epi16(_mm_packs_epi32(p[0], p[1]), _mm_packs_epi32(p[2], p[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + 4 * i), bytes);
     }
+#endif
+    for (; i < count; ++i)
+    {
+        pixels[4 * i] = to_byte(colors[i].r);
+        pixels[4 * i + 1] = to_byte(colors[i].g);
+        pixels[4 * i + 2] = to_byte(colors[i].b);
+        pixels[4 * i + 3] = to_byte(colors[i].a);
+    }
+}
 
-    SDL_UnlockSurface(surface);
-    return surface;
+/*F+F***********************************************************************//*!
+\function: pack
+
+\summary:  convert channel planes to interleaved RGBA8, four pixels are
+           converted per step with sse2
+
+\args:     r, g, b, a - channel planes
+\args:     pixels - RGBA8 output, 4 * count bytes
+\args:     count - number of pixels
+************************************************************************//*F-F*/
+void pack(float const *r, float const *g, float const *b, float const *a, Uint8 *pixels, int count)
+{
+    int i = 0;
+#ifdef ARTENGINE_IMAGE_SSE2
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const scale = _mm_set1_ps(255.0f);
+    auto const convert = [&](float const *plane) {
+        __m128 const c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(plane), zero), one);
+        return _mm_cvtps_epi32(_mm_mul_ps(c, scale));
+    };
+    for (; i + 4 <= count; i += 4)
+    {
+        // every lane is one pixel, byte order r g b a on little endian
+        __m128i pixel = convert(r + i);
+        pixel = _mm_or_si128(pixel, _mm_slli_epi32(convert(g + i), 8));
+        pixel = _mm_or_si128(pixel, _mm_slli_epi32(convert(b + i), 16));
+        pixel = _mm_or_si128(pixel, _mm_slli_epi32(convert(a + i), 24));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + 4 * i), pixel);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        pixels[4 * i] = to_byte(r[i]);
+        pixels[4 * i + 1] = to_byte(g[i]);
+        pixels[4 * i + 2] = to_byte(b[i]);
+        pixels[4 * i + 3] = to_byte(a[i]);
+    }
+}
+
+// RGBA32 surface, byte order r g b a on every platform
+SDL_Surface *surface(int width, int height)
+{
+    SDL_Surface *created = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!created)
+        my_log::error("Unable to create surface ", width, "x", height, ": ", SDL_GetError());
+    return created;
+}
+
+/*F+F***********************************************************************//*!
+\function: make
+
+\summary:  convert a float framebuffer to an RGBA32 surface, rows are packed
+           in parallel at the surface pitch
+
+\args:     framebuffer - channel planes
+
+\return:   SDL_Surface * - converted surface, free with SDL_FreeSurface
+************************************************************************//*F-F*/
+SDL_Surface *make(Framebuffer const &framebuffer)
+{
+    SDL_Surface *image = surface(framebuffer.width, framebuffer.height);
+    if (!image)
+        return nullptr;
+
+    SDL_LockSurface(image);
+    Uint8 *pixels = static_cast<Uint8 *>(image->pixels);
+    job::parallel_for(framebuffer.height, [&](size_t y) {
+        size_t const i = y * framebuffer.width;
+        pack(&framebuffer.r[i], &framebuffer.g[i], &framebuffer.b[i], &framebuffer.a[i], pixels + y * image->pitch,
+             framebuffer.width);
+    });
+    SDL_UnlockSurface(image);
+
+    return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// PIXEL ACCESS
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef ARTENGINE_IMAGE_SSE2
+// RGBA32 pixel to float components in [0, 255], red in the lowest lane
+static __m128 unpack(Uint32 pixel)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const bytes = _mm_cvtsi32_si128(static_cast<int>(pixel));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+static glm::vec4 store(__m128 color)
+{
+    glm::vec4 result;
+    _mm_storeu_ps(&result.r, _mm_mul_ps(color, _mm_set1_ps(1.0f / 255.0f)));
+    return result;
+}
+#endif
+
+// RGBA32 pixel to float components in [0, 1]
+static glm::vec4 decode(Uint32 pixel)
+{
+#ifdef ARTENGINE_IMAGE_SSE2
+    return store(unpack(pixel));
+#else
+    Uint8 const *c = reinterpret_cast<Uint8 const *>(&pixel);
+    return glm::vec4(c[0], c[1], c[2], c[3]) / 255.0f;
+#endif
+}
+
+Pixels::Pixels(SDL_Surface *surface)
+    : m_surface(surface)
+{
+    SDL_LockSurface(m_surface);
+    m_pixels = static_cast<Uint8 *>(m_surface->pixels);
+    m_rgba32 = m_surface->format->format == SDL_PIXELFORMAT_RGBA32;
+}
+
+Pixels::~Pixels()
+{
+    SDL_UnlockSurface(m_surface);
+}
+
+// encoded pixel at clamped coordinates, any pixel size
+Uint32 Pixels::raw(int x, int y) const
+{
+    x = std::clamp(x, 0, m_surface->w - 1);
+    y = std::clamp(y, 0, m_surface->h - 1);
+    int const bpp = m_surface->format->BytesPerPixel;
+    Uint8 const *p = m_pixels + static_cast<size_t>(y) * m_surface->pitch + static_cast<size_t>(x) * bpp;
+    switch (bpp)
+    {
+    case 1:
+        return *p;
+    case 2:
+        return *reinterpret_cast<Uint16 const *>(p);
+    case 3:
+        if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
+            return p[0] << 16 | p[1] << 8 | p[2];
+        return p[0] | p[1] << 8 | p[2] << 16;
+    default:
+        return *reinterpret_cast<Uint32 const *>(p);
+    }
 }
 
+glm::vec4 Pixels::color(int x, int y) const
+{
+    Uint32 const pixel = raw(x, y);
+    if (m_rgba32)
+        return decode(pixel);
+
+    Uint8 r, g, b, a;
+    SDL_GetRGBA(pixel, m_surface->format, &r, &g, &b, &a);
+    return glm::vec4(r, g, b, a) / 255.0f;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Pixels::bilinear
+
+\summary:  bilinear sample between the four nearest pixel centers, RGBA32
+           surfaces blend all four channels at once
+
+\args:     uv - normalized coordinates, (0, 0) is the first pixel of the
+                first row
+
+\return:   glm::vec4 - interpolated color
+************************************************************************//*M-M*/
+glm::vec4 Pixels::bilinear(glm::vec2 uv) const
+{
+    float const fx = uv.x * m_surface->w - 0.5f;
+    float const fy = uv.y * m_surface->h - 0.5f;
+    int const x = static_cast<int>(std::floor(fx));
+    int const y = static_cast<int>(std::floor(fy));
+    float const tx = fx - x;
+    float const ty = fy - y;
+
+#ifdef ARTENGINE_IMAGE_SSE2
+    if (m_rgba32)
+    {
+        __m128 const p00 = unpack(raw(x, y));
+        __m128 const p10 = unpack(raw(x + 1, y));
+        __m128 const p01 = unpack(raw(x, y + 1));
+        __m128 const p11 = unpack(raw(x + 1, y + 1));
+        __m128 const wx = _mm_set1_ps(tx);
+        __m128 const top = _mm_add_ps(p00, _mm_mul_ps(_mm_sub_ps(p10, p00), wx));
+        __m128 const bottom = _mm_add_ps(p01, _mm_mul_ps(_mm_sub_ps(p11, p01), wx));
+        return store(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(ty))));
+    }
+#endif
+    glm::vec4 const top = glm::mix(color(x, y), color(x + 1, y), tx);
+    glm::vec4 const bottom = glm::mix(color(x, y + 1), color(x + 1, y + 1), tx);
+    return glm::mix(top, bottom, ty);
+}
+
+/*M+M***********************************************************************//*!
+\method:   Pixels::area
+
+\summary:  average color of a region clipped to the surface, RGBA32 rows are
+           summed four pixels per step in integer lanes
+
+\args:     region - pixel rectangle
+
+\return:   glm::vec4 - average color, transparent black for an empty region
+************************************************************************//*M-M*/
+glm::vec4 Pixels::area(SDL_Rect region) const
+{
+    SDL_Rect const bounds{0, 0, m_surface->w, m_surface->h};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&region, &bounds, &clipped))
+        return glm::vec4(0.0f);
+    float const count = static_cast<float>(clipped.w) * clipped.h;
+
+#ifdef ARTENGINE_IMAGE_SSE2
+    if (m_rgba32)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        __m128 total = _mm_setzero_ps();
+        for (int y = clipped.y; y < clipped.y + clipped.h; ++y)
+        {
+            // a row of 8 bit channels fits the 32 bit lanes
+            std::span<Uint32 const> const pixels = span<Uint32 const>(clipped.x, y, clipped.w);
+            __m128i sum = zero;
+            size_t x = 0;
+            for (; x + 4 <= pixels.size(); x += 4)
+            {
+                __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&pixels[x]));
+                __m128i const low = _mm_unpacklo_epi8(v, zero);
+                __m128i const high = _mm_unpackhi_epi8(v, zero);
+                sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(low, zero));
+                sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(low, zero));
+                sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(high, zero));
+                sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(high, zero));
+            }
+            total = _mm_add_ps(total, _mm_cvtepi32_ps(sum));
+            for (; x < pixels.size(); ++x)
+                total = _mm_add_ps(total, unpack(pixels[x]));
+        }
+        return store(_mm_div_ps(total, _mm_set1_ps(count)));
+    }
+#endif
+    glm::vec4 total(0.0f);
+    for (int y = clipped.y; y < clipped.y + clipped.h; ++y)
+        for (int x = clipped.x; x < clipped.x + clipped.w; ++x)
+            total += color(x, y);
+    return total / count;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Pixels::read
+
+\summary:  decode a region row by row, coordinates outside the surface are
+           clamped to the edge
+
+\args:     region - pixel rectangle
+\args:     colors - receives region.w * region.h colors
+************************************************************************//*M-M*/
+void Pixels::read(SDL_Rect region, std::span<glm::vec4> colors) const
+{
+    if (colors.size() < static_cast<size_t>(region.w) * region.h)
+    {
+        my_log::error("Pixel read of ", region.w, "x", region.h, " does not fit ", colors.size(), " colors.");
+        return;
+    }
+
+    for (int y = 0; y < region.h; ++y)
+    {
+        glm::vec4 *out = &colors[static_cast<size_t>(y) * region.w];
+        int const row = region.y + y;
+        bool const inside = m_rgba32 && row >= 0 && row < m_surface->h && region.x >= 0 &&
+                            region.x + region.w <= m_surface->w;
+        if (inside)
+        {
+            std::span<Uint32 const> const pixels = span<Uint32 const>(region.x, row, region.w);
+            for (int x = 0; x < region.w; ++x)
+                out[x] = decode(pixels[x]);
+        }
+        else
+            for (int x = 0; x < region.w; ++x)
+                out[x] = color(region.x + x, row);
+    }
+}
+
+/*F+F***********************************************************************//*!
+\function: sample
+
+\summary:  bilinear samples at a batch of normalized coordinates
+
+\args:     pixels - locked surface
+\args:     uv - normalized coordinates
+\args:     colors - receives one color per coordinate
+************************************************************************//*F-F*/
+void sample(Pixels const &pixels, std::span<glm::vec2 const> uv, std::span<glm::vec4> colors)
+{
+    size_t const n = std::min(uv.size(), colors.size());
+    for (size_t i = 0; i < n; ++i)
+        colors[i] = pixels.bilinear(uv[i]);
+}
+
+/*F+F***********************************************************************//*!
+\function: copy
+
+\summary:  copy a region between surfaces without blending, rows are copied
+           directly when the formats match and converted by SDL otherwise
+
+\args:     source - surface to copy from
+\args:     region - source rectangle, clipped to the source
+\args:     destination - surface to copy to
+\args:     position - top left destination pixel
+
+\return:   True, if any pixel was copied
+\return:   False, otherwise
+************************************************************************//*F-F*/
+bool copy(SDL_Surface *source, SDL_Rect region, SDL_Surface *destination, glm::ivec2 position)
+{
+    if (source->format->format != destination->format->format)
+    {
+        SDL_BlendMode mode;
+        SDL_GetSurfaceBlendMode(source, &mode);
+        SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_NONE);
+        SDL_Rect target{position.x, position.y, region.w, region.h};
+        bool const copied = SDL_BlitSurface(source, &region, destination, &target) == 0;
+        SDL_SetSurfaceBlendMode(source, mode);
+        return copied;
+    }
+
+    // clip against the source and the destination
+    SDL_Rect const source_bounds{0, 0, source->w, source->h};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&region, &source_bounds, &clipped))
+        return false;
+    position += glm::ivec2(clipped.x - region.x, clipped.y - region.y);
+    SDL_Rect const moved{position.x, position.y, clipped.w, clipped.h};
+    SDL_Rect const destination_bounds{0, 0, destination->w, destination->h};
+    SDL_Rect visible;
+    if (!SDL_IntersectRect(&moved, &destination_bounds, &visible))
+        return false;
+    clipped.x += visible.x - moved.x;
+    clipped.y += visible.y - moved.y;
+
+    Pixels from(source);
+    Pixels to(destination);
+    int const bpp = source->format->BytesPerPixel;
+    for (int y = 0; y < visible.h; ++y)
+    {
+        std::span<Uint8> const out = to.row<Uint8>(visible.y + y).subspan(visible.x * bpp, visible.w * bpp);
+        std::span<Uint8> const in = from.row<Uint8>(clipped.y + y).subspan(clipped.x * bpp, visible.w * bpp);
+        std::memcpy(out.data(), in.data(), in.size());
+    }
+    return true;
+}
+
+/*F+F***********************************************************************//*!
+\function: resize
+
+\summary:  resample a surface to a new size, every destination pixel averages
+           the source area it covers when shrinking and samples bilinearly
+           when growing, rows are resampled in parallel
+
+\args:     source - surface to resample
+\args:     width - destination width
+\args:     height - destination height
+
+\return:   SDL_Surface * - RGBA32 surface, free with SDL_FreeSurface
+************************************************************************//*F-F*/
+SDL_Surface *resize(SDL_Surface *source, int width, int height)
+{
+    SDL_Surface *image = surface(width, height);
+    if (!image)
+        return nullptr;
+
+    Pixels const from(source);
+    Pixels const to(image);
+    float const sx = static_cast<float>(source->w) / width;
+    float const sy = static_cast<float>(source->h) / height;
+    job::parallel_for(height, [&](size_t y) {
+        std::vector<glm::vec4> row(width);
+        for (int x = 0; x < width; ++x)
+        {
+            if (sx > 1.0f || sy > 1.0f)
+            {
+                int const x0 = static_cast<int>(x * sx);
+                int const y0 = static_cast<int>(y * sy);
+                int const x1 = std::max(x0 + 1, static_cast<int>((x + 1) * sx));
+                int const y1 = std::max(y0 + 1, static_cast<int>((y + 1) * sy));
+                row[x] = from.area({x0, y0, x1 - x0, y1 - y0});
+            }
+            else
+                row[x] = from.bilinear({(x + 0.5f) / width, (y + 0.5f) / height});
+        }
+        pack(row.data(), to.row<Uint8>(static_cast<int>(y)).data(), width);
+    });
+
+    return image;
+}
+
+// pixel with components in [0, 255], prefer Pixels to read more than one pixel
 glm::vec4 color(SDL_Surface *surface, int x, int y)
 {
     // out of bounds checking
     if (x < 0 || x >= surface->w || y < 0 || y >= surface->h)
         return {0, 0, 0, 1};
 
-    SDL_PixelFormat *format = surface->format;
-    Uint8 r;
-    Uint8 g;
-    Uint8 b;
-    Uint8 a;
-
-    SDL_LockSurface(surface);
-    Uint32 pixels = static_cast<Uint32 *>(surface->pixels)[y * surface->w + x];
-    SDL_UnlockSurface(surface);
-
-    r = static_cast<Uint8>(((pixels & format->Rmask) >> format->Rshift) << format->Rloss);
-    g = static_cast<Uint8>(((pixels & format->Gmask) >> format->Gshift) << format->Gloss);
-    b = static_cast<Uint8>(((pixels & format->Bmask) >> format->Bshift) << format->Bloss);
-    a = static_cast<Uint8>(((pixels & format->Amask) >> format->Ashift) << format->Aloss);
-
-    return {r, g, b, a};
+    return Pixels(surface).color(x, y) * 255.0f;
 }
 
 glm::vec4 color(SDL_Surface *surface, float x, float y)
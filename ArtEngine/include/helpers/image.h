@@ -6,17 +6,200 @@
 namespace image
 {
 
+inline int constexpr tile_rows = 16; //!< rows generated per job
+
+/*S+S***********************************************************************//*!
+\struct:   Framebuffer
+
+\summary:  float image stored as separate channel planes (structure of
+           arrays), row major without padding, converted to a surface with
+           make
+************************************************************************//*S-S*/
+struct Framebuffer
+{
+    Framebuffer(int width, int height);
+
+    int width;            //!< pixels per row
+    int height;           //!< number of rows
+    std::vector<float> r; //!< red plane
+    std::vector<float> g; //!< green plane
+    std::vector<float> b; //!< blue plane
+    std::vector<float> a; //!< alpha plane
+};
+
+/*C+C***********************************************************************//*!
+\class:    Pixels
+
+\summary:  locked view of a surface for bulk access, the surface stays locked
+           for the lifetime of the view, rows are addressed through the pitch
+           and RGBA32 surfaces decode without the format masks
+
+           colors returned by the view have components in [0, 1], coordinates
+           outside the surface are clamped to the edge
+
+\methods:  Pixels - Constructor, locks the surface\n
+        :  ~Pixels - Destructor, unlocks the surface\n
+        :  row - typed view of a row\n
+        :  span - typed view of consecutive pixels of a row\n
+        :  color - decoded pixel\n
+        :  bilinear - bilinear sample at normalized coordinates\n
+        :  area - average color of a region\n
+        :  read - decode a region row by row\n
+************************************************************************//*C-C*/
+class Pixels
+{
+  public:
+    explicit Pixels(SDL_Surface *surface);
+    ~Pixels();
+
+    Pixels(Pixels const &) = delete;
+    Pixels &operator=(Pixels const &) = delete;
+
+    [[nodiscard]] int width() const
+    {
+        return m_surface->w;
+    }
+
+    [[nodiscard]] int height() const
+    {
+        return m_surface->h;
+    }
+
+    [[nodiscard]] bool rgba32() const
+    {
+        return m_rgba32;
+    }
+
+    // every element of T covers whole pixels, e.g. Uint32 for 32 bit surfaces
+    template <typename T = Uint32>
+    std::span<T> row(int y) const
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "rows are viewed as raw memory");
+        size_t const bytes = static_cast<size_t>(m_surface->w) * m_surface->format->BytesPerPixel;
+        return {reinterpret_cast<T *>(m_pixels + static_cast<size_t>(y) * m_surface->pitch), bytes / sizeof(T)};
+    }
+
+    template <typename T = Uint32>
+    std::span<T> span(int x, int y, int count) const
+    {
+        return row<T>(y).subspan(x, count);
+    }
+
+    [[nodiscard]] glm::vec4 color(int x, int y) const;
+    [[nodiscard]] glm::vec4 bilinear(glm::vec2 uv) const;
+    [[nodiscard]] glm::vec4 area(SDL_Rect region) const;
+    void read(SDL_Rect region, std::span<glm::vec4> colors) const;
+
+  private:
+    [[nodiscard]] Uint32 raw(int x, int y) const;
+
+    SDL_Surface *m_surface; //!< viewed surface
+    Uint8 *m_pixels;        //!< first byte of the first row
+    bool m_rgba32;          //!< byte order r g b a, decoded without masks
+
+}; // class Pixels
+
 SDL_Surface *load(std::string path);
 
 void save(SDL_Surface *surface, std::string path);
-void save(Target target, std::string path);
+void save(Target *target, std::string path);
+void save(Readback &readback, std::string path);
+
+void pack(glm::vec4 const *colors, Uint8 *pixels, int count);
+void pack(float const *r, float const *g, float const *b, float const *a, Uint8 *pixels, int count);
+
+SDL_Surface *surface(int width, int height);
+SDL_Surface *make(Framebuffer const &framebuffer);
 
-SDL_Surface *make(std::function<glm::vec4(int)> handle,
-                  glm::vec2 size = glm::vec2(Art::view.width(), Art::view.height()));
+void sample(Pixels const &pixels, std::span<glm::vec2 const> uv, std::span<glm::vec4> colors);
+bool copy(SDL_Surface *source, SDL_Rect region, SDL_Surface *destination, glm::ivec2 position);
+SDL_Surface *resize(SDL_Surface *source, int width, int height);
 
 glm::vec4 color(SDL_Surface *surface, int x, int y);
 glm::vec4 color(SDL_Surface *surface, float x, float y);
 
+/*F+F***********************************************************************//*!
+\function: make
+
+\summary:  generate an RGBA32 surface from a color function, the rows are
+           split into tiles generated in parallel on the job system and each
+           finished row is packed to bytes at the surface pitch
+
+           the function is called concurrently and either takes the pixel
+           index (y * width + x) or the pixel coordinates (x, y)
+
+\args:     handle - color of a pixel, components in [0, 1]
+\args:     size - image size in pixels
+
+\return:   SDL_Surface * - generated surface, free with SDL_FreeSurface
+************************************************************************//*F-F*/
+template <typename F>
+SDL_Surface *make(F handle, glm::vec2 size = glm::vec2(Art::view.width(), Art::view.height()))
+{
+    int const width = static_cast<int>(size.x);
+    int const height = static_cast<int>(size.y);
+    SDL_Surface *image = surface(width, height);
+    if (!image)
+        return nullptr;
+
+    SDL_LockSurface(image);
+    Uint8 *pixels = static_cast<Uint8 *>(image->pixels);
+    int const pitch = image->pitch;
+    job::parallel_for(
+        (height + tile_rows - 1) / tile_rows,
+        [&](size_t tile) {
+            std::vector<glm::vec4> row(width);
+            int const begin = static_cast<int>(tile) * tile_rows;
+            for (int y = begin; y < std::min(height, begin + tile_rows); ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    if constexpr (std::is_invocable_v<F &, int, int>)
+                        row[x] = handle(x, y);
+                    else
+                        row[x] = handle(y * width + x);
+                }
+                pack(row.data(), pixels + static_cast<size_t>(y) * pitch, width);
+            }
+        },
+        1);
+    SDL_UnlockSurface(image);
+
+    return image;
+}
+
+/*F+F***********************************************************************//*!
+\function: fill
+
+\summary:  evaluate a color function for every pixel of a float framebuffer,
+           row tiles are filled in parallel on the job system
+
+\args:     framebuffer - framebuffer to fill
+\args:     handle - color of a pixel (x, y), called concurrently
+************************************************************************//*F-F*/
+template <typename F>
+void fill(Framebuffer &framebuffer, F handle)
+{
+    int const width = framebuffer.width;
+    int const height = framebuffer.height;
+    job::parallel_for(
+        (height + tile_rows - 1) / tile_rows,
+        [&](size_t tile) {
+            int const begin = static_cast<int>(tile) * tile_rows;
+            for (int y = begin; y < std::min(height, begin + tile_rows); ++y)
+                for (int x = 0; x < width; ++x)
+                {
+                    size_t const i = static_cast<size_t>(y) * width + x;
+                    glm::vec4 const color = handle(x, y);
+                    framebuffer.r[i] = color.r;
+                    framebuffer.g[i] = color.g;
+                    framebuffer.b[i] = color.b;
+                    framebuffer.a[i] = color.a;
+                }
+        },
+        1);
+}
+
 } // namespace image
 
 #endif // ARTENGINE_IAMGE_H
@@ -0,0 +1,307 @@
+#include "../pch.h"
+
+namespace job
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//// INTERNAL STATE
+////////////////////////////////////////////////////////////////////////////////
+
+// job deque of a worker, the owner uses the back and thieves the front
+struct Worker
+{
+    std::mutex mutex;     // guards the deque
+    std::deque<Job> jobs; // queued jobs
+};
+
+static std::vector<std::unique_ptr<Worker>> workers; // worker 0 is the main thread
+static std::vector<std::thread> pool;                // threads of workers 1..n
+static std::atomic<bool> running = false;            // workers keep looking for jobs
+static std::atomic<size_t> pending = 0;              // queued jobs not yet taken
+static std::atomic<size_t> next = 0;                 // round robin for external threads
+static std::mutex sleep_mutex;                       // idle workers sleep on
+static std::condition_variable sleep;                // signalled for new jobs
+static thread_local int self = -1;                   // worker index of the calling thread
+
+static std::mutex main_mutex;      // guards the main thread queue
+static std::vector<Job> main_jobs; // gl-bound jobs drained by the main thread
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// take a job from the own deque or steal one from another worker
+static bool take(int index, Job &job)
+{
+    size_t const n = workers.size();
+    if (index >= 0)
+    {
+        Worker &own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            --pending;
+            return true;
+        }
+    }
+
+    // steal the oldest job, it tends to be the largest remaining piece of work
+    size_t const start = index >= 0 ? static_cast<size_t>(index) + 1 : next++;
+    for (size_t i = 0; i < n; ++i)
+    {
+        Worker &victim = *workers[(start + i) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            --pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+// worker thread, runs jobs until shutdown and sleeps when none are queued
+static void work(int index)
+{
+    self = index;
+    profiler::name("worker " + std::to_string(index));
+
+    Job job;
+    while (running)
+    {
+        if (take(index, job))
+        {
+            job();
+            job = nullptr;
+            continue;
+        }
+
+        // bounded wait, a job queued between the check and the wait is picked up late, not lost
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep.wait_for(lock, std::chrono::milliseconds(1), [] { return pending > 0 || !running; });
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// COUNTER
+////////////////////////////////////////////////////////////////////////////////
+
+Counter::Counter(int value)
+    : m_value(value)
+{
+}
+
+void Counter::add(int n)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_value += n;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Counter::done
+
+\summary:  signal a completed job, the last one releases the continuations,
+           the counter is not touched after the value reaches zero so a
+           waiter may destroy it right away
+
+\modifies: [m_value, m_continuations]
+************************************************************************//*M-M*/
+void Counter::done()
+{
+    std::vector<std::pair<Job, bool>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_value == 0)
+            continuations.swap(m_continuations);
+    }
+
+    for (auto &[continuation, on_main_thread] : continuations)
+        on_main_thread ? on_main(std::move(continuation)) : run(std::move(continuation));
+}
+
+bool Counter::finished()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_value <= 0;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Counter::then
+
+\summary:  run a job once every expected job completed, immediately if the
+           counter already reached zero
+
+\args:     continuation - job to run
+\args:     on_main - queue the job for the main thread (gl-bound work)
+
+\modifies: [m_continuations]
+************************************************************************//*M-M*/
+void Counter::then(Job continuation, bool on_main_thread)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_value > 0)
+        {
+            m_continuations.emplace_back(std::move(continuation), on_main_thread);
+            return;
+        }
+    }
+    on_main_thread ? on_main(std::move(continuation)) : run(std::move(continuation));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// JOB SYSTEM
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: init
+
+\summary:  start the workers, the calling thread becomes worker 0, called by
+           Art::init on the main thread and again to change the worker count,
+           never while other threads use the job system
+
+\args:     count - number of workers including the caller, zero uses every
+                   hardware thread
+************************************************************************//*F-F*/
+void init(size_t count)
+{
+    shutdown();
+
+    if (!count)
+        count = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < count; ++i)
+        workers.push_back(std::make_unique<Worker>());
+    self = 0;
+    running = true;
+    for (size_t i = 1; i < count; ++i)
+        pool.emplace_back(work, static_cast<int>(i));
+}
+
+/*F+F***********************************************************************//*!
+\function: shutdown
+
+\summary:  finish the queued jobs and stop the workers
+************************************************************************//*F-F*/
+void shutdown()
+{
+    if (workers.empty())
+        return;
+
+    // help finish the queued jobs
+    Job job;
+    while (pending > 0)
+        if (take(self, job))
+        {
+            job();
+            job = nullptr;
+        }
+
+    running = false;
+    sleep.notify_all();
+    for (auto &thread : pool)
+        thread.join();
+    pool.clear();
+    workers.clear();
+}
+
+// workers including the main thread, 1 before init since jobs then run on the caller
+size_t threads()
+{
+    return std::max<size_t>(1, workers.size());
+}
+
+/*F+F***********************************************************************//*!
+\function: run
+
+\summary:  queue a job on the deque of the calling worker, threads outside the
+           job system spread their jobs over the workers, before init the job
+           runs on the caller
+
+\args:     function - job to run
+\args:     counter - signalled when the job completed
+************************************************************************//*F-F*/
+void run(Job function, Counter *counter)
+{
+    if (workers.empty())
+    {
+        if (counter)
+            counter->add();
+        function();
+        if (counter)
+            counter->done();
+        return;
+    }
+
+    Job job = std::move(function);
+    if (counter)
+    {
+        counter->add();
+        job = [job = std::move(job), counter] {
+            job();
+            counter->done();
+        };
+    }
+
+    size_t const index = self >= 0 ? static_cast<size_t>(self) : next++ % workers.size();
+    {
+        Worker &worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+    }
+    ++pending;
+    sleep.notify_one();
+}
+
+/*F+F***********************************************************************//*!
+\function: wait
+
+\summary:  run queued jobs until every job of the counter completed, the
+           caller never idles while work is available
+
+\args:     counter - counter to wait for
+************************************************************************//*F-F*/
+void wait(Counter &counter)
+{
+    Job job;
+    while (!counter.finished())
+    {
+        if (take(self, job))
+        {
+            job();
+            job = nullptr;
+        }
+        else
+            std::this_thread::yield();
+    }
+}
+
+// queue a gl-bound job for the main thread, executed by drain
+void on_main(Job function)
+{
+    std::lock_guard<std::mutex> lock(main_mutex);
+    main_jobs.push_back(std::move(function));
+}
+
+/*F+F***********************************************************************//*!
+\function: drain
+
+\summary:  run the jobs queued for the main thread, called once per frame by
+           the game loop from the thread owning the gl context
+************************************************************************//*F-F*/
+void drain()
+{
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(main_mutex);
+        jobs.swap(main_jobs);
+    }
+    for (auto &job : jobs)
+        job();
+}
+
+} // namespace job
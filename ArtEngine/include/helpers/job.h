@@ -0,0 +1,152 @@
+/*+*************************************************************************//*!
+\file:      job.h
+
+\summary:   work-stealing job system, every worker owns a deque it pushes and
+            pops at the back while idle workers steal from the front of the
+            others, the main thread is worker 0 and helps while it waits
+
+\classes:   Counter
+
+\functions: init\n
+            shutdown\n
+            threads\n
+            run\n
+            wait\n
+            on_main\n
+            drain\n
+            parallel_for\n
+            parallel_reduce\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_JOB_H
+#define ARTENGINE_JOB_H
+
+namespace job
+{
+
+using Job = std::function<void()>;
+
+/*C+C***********************************************************************//*!
+\class:    Counter
+
+\summary:  dependency counter, jobs signal it when they complete and
+           continuations run once it reaches zero
+
+\methods:  add - expect more jobs\n
+        :  done - signal a completed job\n
+        :  finished - every expected job completed\n
+        :  then - run a job once finished, on the workers or the main thread\n
+************************************************************************//*C-C*/
+class Counter
+{
+  public:
+    explicit Counter(int value = 0);
+
+    Counter(Counter const &) = delete;
+    Counter &operator=(Counter const &) = delete;
+
+    void add(int n = 1);
+    void done();
+    [[nodiscard]] bool finished();
+    void then(Job continuation, bool on_main = false);
+
+  private:
+    std::mutex m_mutex;                                //!< guards the value and continuations
+    int m_value;                                       //!< outstanding jobs
+    std::vector<std::pair<Job, bool>> m_continuations; //!< jobs waiting for zero (job, on main thread)
+
+}; // class Counter
+
+void init(size_t count = 0);
+void shutdown();
+[[nodiscard]] size_t threads();
+
+void run(Job function, Counter *counter = nullptr);
+void wait(Counter &counter);
+
+void on_main(Job function);
+void drain();
+
+/*F+F***********************************************************************//*!
+\function: parallel_for
+
+\summary:  call a function for every index of a range, the range is split into
+           chunks executed on the workers, returns once every call completed
+
+\args:     n - number of indices
+\args:     function - called with each index
+\args:     grain - indices per job, zero picks four chunks per worker
+************************************************************************//*F-F*/
+template <typename F>
+void parallel_for(size_t n, F function, size_t grain = 0)
+{
+    if (!n)
+        return;
+
+    size_t const chunk = grain ? grain : std::max<size_t>(1, n / (threads() * 4));
+    if (chunk >= n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            function(i);
+        return;
+    }
+
+    Counter counter;
+    for (size_t begin = 0; begin < n; begin += chunk)
+    {
+        size_t const end = std::min(n, begin + chunk);
+        run(
+            [&function, begin, end] {
+                for (size_t i = begin; i < end; ++i)
+                    function(i);
+            },
+            &counter);
+    }
+    wait(counter);
+}
+
+/*F+F***********************************************************************//*!
+\function: parallel_reduce
+
+\summary:  map every index of a range and combine the results, chunks are
+           reduced on the workers and combined in order, so the result is
+           deterministic for an associative reduction
+
+\args:     n - number of indices
+\args:     identity - neutral element of the reduction
+\args:     map - called with each index, returns a value
+\args:     reduce - combines two values
+\args:     grain - indices per job, zero picks four chunks per worker
+
+\return:   T - reduction of the mapped values
+************************************************************************//*F-F*/
+template <typename T, typename Map, typename Reduce>
+T parallel_reduce(size_t n, T identity, Map map, Reduce reduce, size_t grain = 0)
+{
+    size_t const chunk = grain ? grain : std::max<size_t>(1, n / (threads() * 4));
+    size_t const chunks = (n + chunk - 1) / chunk;
+
+    std::vector<T> partial(chunks, identity);
+    parallel_for(
+        chunks,
+        [&](size_t c) {
+            T value = identity;
+            for (size_t i = c * chunk; i < std::min(n, (c + 1) * chunk); ++i)
+                value = reduce(value, map(i));
+            partial[c] = value;
+        },
+        1);
+
+    T result = identity;
+    for (auto const &value : partial)
+        result = reduce(result, value);
+    return result;
+}
+
+} // namespace job
+
+#endif // ARTENGINE_JOB_H
@@ -0,0 +1,439 @@
+#include "../pch.h"
+
+namespace lod
+{
+
+size_t levels = 4;        //!< simplified levels generated per mesh, 0 disables lod
+float ratio = 0.5f;       //!< triangles kept by a level relative to the previous one
+float tolerance = 1.0f;   //!< screen space error in pixels a level may introduce
+float hysteresis = 0.25f; //!< fraction of the tolerance a coarser level has to undercut
+
+static size_t constexpr minimum = 8;      // triangles below which no coarser level is generated
+static double constexpr seam_weight = 10; // weight of the planes holding boundaries and material seams in place
+static double constexpr flip = 0.2;       // cosine below which a collapse is rejected as a face flip
+
+////////////////////////////////////////////////////////////////////////////////
+//// QUADRICS
+////////////////////////////////////////////////////////////////////////////////
+
+// symmetric 4x4 matrix summing the squared distances to a set of planes, upper triangle
+struct Quadric
+{
+    double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+
+    // squared distance to the plane dot(n, p) + d = 0
+    static Quadric plane(glm::dvec3 const &n, double d, double weight = 1.0)
+    {
+        return {weight * n.x * n.x, weight * n.x * n.y, weight * n.x * n.z, weight * n.x * d,
+                weight * n.y * n.y, weight * n.y * n.z, weight * n.y * d,   weight * n.z * n.z,
+                weight * n.z * d,   weight * d * d};
+    }
+
+    Quadric &operator+=(Quadric const &q)
+    {
+        xx += q.xx;
+        xy += q.xy;
+        xz += q.xz;
+        xw += q.xw;
+        yy += q.yy;
+        yz += q.yz;
+        yw += q.yw;
+        zz += q.zz;
+        zw += q.zw;
+        ww += q.ww;
+        return *this;
+    }
+
+    Quadric operator+(Quadric const &q) const
+    {
+        Quadric sum = *this;
+        return sum += q;
+    }
+
+    // sum of the squared plane distances of a point
+    [[nodiscard]] double error(glm::dvec3 const &p) const
+    {
+        double const e = xx * p.x * p.x + 2 * xy * p.x * p.y + 2 * xz * p.x * p.z + 2 * xw * p.x + //
+                         yy * p.y * p.y + 2 * yz * p.y * p.z + 2 * yw * p.y +                     //
+                         zz * p.z * p.z + 2 * zw * p.z + ww;
+        return std::max(e, 0.0);
+    }
+
+    // point of least error, false if the planes do not pin down a single point
+    bool optimum(glm::dvec3 &p) const
+    {
+        glm::dmat3 const a(xx, xy, xz, xy, yy, yz, xz, yz, zz);
+        double const det = glm::determinant(a);
+        double const scale = xx + yy + zz;
+        if (std::abs(det) <= 1e-9 * scale * scale * scale)
+            return false;
+        p = glm::inverse(a) * -glm::dvec3(xw, yw, zw);
+        return true;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//// SIMPLIFICATION
+////////////////////////////////////////////////////////////////////////////////
+
+using Face = std::array<std::uint32_t, 3>;
+
+// edge collapse waiting in the queue, stale once a vertex changed after it was queued
+struct Collapse
+{
+    double cost;             // quadric error of the merged vertex
+    std::uint32_t a;         // surviving vertex
+    std::uint32_t b;         // removed vertex
+    std::uint32_t version_a; // version of a the collapse was computed for
+    std::uint32_t version_b; // version of b the collapse was computed for
+    glm::dvec3 position;     // position of the merged vertex
+
+    bool operator>(Collapse const &other) const
+    {
+        return cost > other.cost;
+    }
+};
+
+// welded mesh being simplified
+struct State
+{
+    std::vector<glm::dvec3> points;                 // vertex positions
+    std::vector<Quadric> quadrics;                  // accumulated quadric of every vertex
+    std::vector<std::uint32_t> versions;            // bumped whenever a vertex changes
+    std::vector<char> removed;                      // vertex merged into another one
+    std::vector<std::vector<std::uint32_t>> around; // faces around every vertex, may hold deleted faces
+    std::vector<Face> faces;                        // vertices of every face
+    std::vector<glm::vec4> materials;               // color of every face
+    std::vector<char> deleted;                      // face degenerated by a collapse
+    size_t alive = 0;                               // faces not deleted
+
+    // cheapest collapse first
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+};
+
+// unit normal of a triangle, zero if degenerate
+static glm::dvec3 normal(glm::dvec3 const &a, glm::dvec3 const &b, glm::dvec3 const &c)
+{
+    glm::dvec3 const n = glm::cross(b - a, c - a);
+    double const length = glm::length(n);
+    return length > 0.0 ? n / length : glm::dvec3(0.0);
+}
+
+// merge vertices sharing a position, obj faces repeat their corners
+static void weld(object::Mesh const &mesh, State &state)
+{
+    size_t const n = mesh.positions.size() / 3;
+    auto const position = [&mesh](size_t i) {
+        return std::tie(mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2]);
+    };
+
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t i, std::uint32_t j) { return position(i) < position(j); });
+
+    std::vector<std::uint32_t> ids(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i == 0 || position(order[i]) != position(order[i - 1]))
+            state.points.emplace_back(mesh.positions[order[i] * 3], mesh.positions[order[i] * 3 + 1],
+                                      mesh.positions[order[i] * 3 + 2]);
+        ids[order[i]] = static_cast<std::uint32_t>(state.points.size() - 1);
+    }
+
+    for (size_t f = 0; f < n / 3; ++f)
+    {
+        Face const face = {ids[f * 3], ids[f * 3 + 1], ids[f * 3 + 2]};
+        if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2])
+            continue;
+        state.faces.push_back(face);
+        state.materials.emplace_back(mesh.colors[f * 12], mesh.colors[f * 12 + 1], mesh.colors[f * 12 + 2],
+                                     mesh.colors[f * 12 + 3]);
+    }
+
+    size_t const vertices = state.points.size();
+    state.quadrics.resize(vertices);
+    state.versions.resize(vertices, 0);
+    state.removed.resize(vertices, false);
+    state.around.resize(vertices);
+    state.deleted.resize(state.faces.size(), false);
+    state.alive = state.faces.size();
+    for (std::uint32_t f = 0; f < state.faces.size(); ++f)
+        for (auto const v : state.faces[f])
+            state.around[v].push_back(f);
+}
+
+// plane quadrics of the faces, boundaries and material seams get perpendicular planes so
+// they keep their outline and colors do not bleed across them
+static void plane_quadrics(State &state)
+{
+    std::unordered_map<std::uint64_t, std::pair<std::uint32_t, int>> edges; // first face and face count
+    std::unordered_set<std::uint64_t> seams;
+    for (std::uint32_t f = 0; f < state.faces.size(); ++f)
+    {
+        Face const &face = state.faces[f];
+        glm::dvec3 const n = normal(state.points[face[0]], state.points[face[1]], state.points[face[2]]);
+        Quadric const q = Quadric::plane(n, -glm::dot(n, state.points[face[0]]));
+        for (auto const v : face)
+            state.quadrics[v] += q;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            std::uint32_t const u = std::min(face[i], face[(i + 1) % 3]);
+            std::uint32_t const v = std::max(face[i], face[(i + 1) % 3]);
+            std::uint64_t const key = std::uint64_t(u) << 32 | v;
+            auto [it, inserted] = edges.try_emplace(key, f, 0);
+            if (++it->second.second > 1 && state.materials[it->second.first] != state.materials[f])
+                seams.insert(key);
+        }
+    }
+
+    for (auto const &[key, edge] : edges)
+    {
+        if (edge.second > 1 && !seams.contains(key))
+            continue;
+
+        auto const u = static_cast<std::uint32_t>(key >> 32);
+        auto const v = static_cast<std::uint32_t>(key & 0xffffffff);
+        Face const &face = state.faces[edge.first];
+        glm::dvec3 const n = normal(state.points[face[0]], state.points[face[1]], state.points[face[2]]);
+        glm::dvec3 const side = glm::cross(state.points[v] - state.points[u], n);
+        double const length = glm::length(side);
+        if (length <= 0.0)
+            continue;
+        Quadric const q = Quadric::plane(side / length, -glm::dot(side / length, state.points[u]), seam_weight);
+        state.quadrics[u] += q;
+        state.quadrics[v] += q;
+    }
+}
+
+// queue the collapse of the edge (a, b) at its position of least error
+static void push(State &state, std::uint32_t a, std::uint32_t b)
+{
+    Quadric const q = state.quadrics[a] + state.quadrics[b];
+    glm::dvec3 position;
+    if (!q.optimum(position))
+    {
+        // degenerate quadric, take the best of the end points and the midpoint
+        glm::dvec3 const candidates[] = {state.points[a], state.points[b], (state.points[a] + state.points[b]) * 0.5};
+        position = *std::min_element(std::begin(candidates), std::end(candidates),
+                                     [&q](auto const &p, auto const &r) { return q.error(p) < q.error(r); });
+    }
+    state.queue.push({q.error(position), a, b, state.versions[a], state.versions[b], position});
+}
+
+// vertices sharing a live face with v
+static std::vector<std::uint32_t> neighbours(State const &state, std::uint32_t v)
+{
+    std::vector<std::uint32_t> result;
+    for (auto const f : state.around[v])
+        if (!state.deleted[f])
+            for (auto const w : state.faces[f])
+                if (w != v)
+                    result.push_back(w);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// a collapse keeps the surface manifold and flips no face
+static bool valid(State const &state, Collapse const &collapse)
+{
+    // the end points may only share the opposite vertices of the two faces on the edge
+    std::vector<std::uint32_t> const na = neighbours(state, collapse.a);
+    std::vector<std::uint32_t> const nb = neighbours(state, collapse.b);
+    std::vector<std::uint32_t> shared;
+    std::set_intersection(na.begin(), na.end(), nb.begin(), nb.end(), std::back_inserter(shared));
+    if (shared.size() > 2)
+        return false;
+
+    for (auto const v : {collapse.a, collapse.b})
+        for (auto const f : state.around[v])
+        {
+            Face const &face = state.faces[f];
+            bool const edge = std::find(face.begin(), face.end(), collapse.a) != face.end() &&
+                              std::find(face.begin(), face.end(), collapse.b) != face.end();
+            if (state.deleted[f] || edge)
+                continue;
+
+            std::array<glm::dvec3, 3> moved;
+            for (int i = 0; i < 3; ++i)
+                moved[i] = face[i] == v ? collapse.position : state.points[face[i]];
+            glm::dvec3 const before = normal(state.points[face[0]], state.points[face[1]], state.points[face[2]]);
+            glm::dvec3 const after = normal(moved[0], moved[1], moved[2]);
+            if (glm::dot(before, after) < flip)
+                return false;
+        }
+    return true;
+}
+
+// merge b into a and queue the collapses of the edges around a
+static void apply(State &state, Collapse const &collapse)
+{
+    std::uint32_t const a = collapse.a;
+    std::uint32_t const b = collapse.b;
+    state.points[a] = collapse.position;
+    state.quadrics[a] += state.quadrics[b];
+    state.removed[b] = true;
+    ++state.versions[a];
+    ++state.versions[b];
+
+    for (auto const f : state.around[b])
+    {
+        if (state.deleted[f])
+            continue;
+        Face &face = state.faces[f];
+        if (std::find(face.begin(), face.end(), a) != face.end())
+        {
+            state.deleted[f] = true;
+            --state.alive;
+            continue;
+        }
+        std::replace(face.begin(), face.end(), b, a);
+        state.around[a].push_back(f);
+    }
+    state.around[b].clear();
+
+    std::vector<std::uint32_t> &around = state.around[a];
+    around.erase(std::remove_if(around.begin(), around.end(), [&](std::uint32_t f) { return state.deleted[f]; }),
+                 around.end());
+
+    for (auto const v : neighbours(state, a))
+        push(state, a, v);
+}
+
+// append the live faces as a detail level, flat normals as parsed from the obj
+static void emit(State const &state, object::Mesh &mesh, float error)
+{
+    auto const first = static_cast<GLuint>(mesh.positions.size() / 3);
+    for (size_t f = 0; f < state.faces.size(); ++f)
+    {
+        if (state.deleted[f])
+            continue;
+        Face const &face = state.faces[f];
+        glm::vec3 const n(normal(state.points[face[0]], state.points[face[1]], state.points[face[2]]));
+        glm::vec4 const &color = state.materials[f];
+        for (auto const v : face)
+        {
+            glm::vec3 const p(state.points[v]);
+            mesh.positions.insert(mesh.positions.end(), {p.x, p.y, p.z});
+            mesh.normals.insert(mesh.normals.end(), {n.x, n.y, n.z});
+            mesh.colors.insert(mesh.colors.end(), {color.r, color.g, color.b, color.a});
+        }
+    }
+    auto const count = static_cast<GLuint>(mesh.positions.size() / 3 - first);
+    mesh.levels.push_back({first, count, error});
+}
+
+/*F+F***********************************************************************//*!
+\function: generate
+
+\summary:  append simplified copies of a parsed mesh as detail levels, edges
+           are collapsed in order of their quadric error until every level
+           keeps ratio of the triangles of the previous one, touches no gl
+           state and is safe to call from a job
+
+\args:     mesh - parsed geometry, receives the levels after its own vertices
+************************************************************************//*F-F*/
+void generate(object::Mesh &mesh)
+{
+    size_t const n = mesh.positions.size() / 3;
+    mesh.levels = {{0, static_cast<GLuint>(n), 0.0f}};
+    if (!levels || n < minimum * 3)
+        return;
+
+    State state;
+    weld(mesh, state);
+    plane_quadrics(state);
+    for (std::uint32_t v = 0; v < state.points.size(); ++v)
+        for (auto const w : neighbours(state, v))
+            if (v < w)
+                push(state, v, w);
+
+    // error is the root of the largest quadric error so far, an upper bound of the distance to the source planes
+    double error = 0.0;
+    size_t previous = state.alive;
+    for (size_t level = 1; level <= levels; ++level)
+    {
+        size_t const target = static_cast<size_t>(static_cast<float>(previous) * ratio);
+        if (target < minimum)
+            break;
+
+        while (state.alive > target && !state.queue.empty())
+        {
+            Collapse const collapse = state.queue.top();
+            state.queue.pop();
+            if (state.removed[collapse.a] || state.removed[collapse.b] ||
+                state.versions[collapse.a] != collapse.version_a || state.versions[collapse.b] != collapse.version_b)
+                continue; // stale, a fresh collapse was queued when the vertex changed
+            if (!valid(state, collapse))
+                continue;
+            apply(state, collapse);
+            error = std::max(error, collapse.cost);
+        }
+
+        if (state.alive >= previous)
+            break; // no collapse left that keeps the surface intact
+        emit(state, mesh, static_cast<float>(std::sqrt(error)));
+        previous = state.alive;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// SELECTION
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: select
+
+\summary:  pick the detail level of a model from the projected size of its
+           bounding sphere, the error of a level relative to the radius
+           times the projected radius is its screen space error, a finer
+           level is picked as soon as the tolerance is exceeded and a
+           coarser one only once it undercuts the tolerance by hysteresis
+
+\args:     model - model with detail levels
+\args:     view - world space to view space matrix
+\args:     projection - view space to clip space matrix
+\args:     height - viewport height in pixels
+
+\modifies: [model->level]
+************************************************************************//*F-F*/
+void select(Model *model, glm::mat4 const &view, glm::mat4 const &projection, float height)
+{
+    if (model->levels.size() < 2 || model->sphere.radius <= 0.0f)
+        return;
+
+    glm::vec4 const center = model->model * glm::vec4(model->sphere.center, 1.0f);
+    float const w = (projection * view * center).w; // view depth for perspective, 1 for orthographic
+    if (w <= 0.0f)
+        return; // behind the camera, culled anyway
+
+    glm::mat3 const m(model->model);
+    float const scale = std::max({glm::length(m[0]), glm::length(m[1]), glm::length(m[2])});
+    float const projected = model->sphere.radius * scale * projection[1][1] * 0.5f * height / w; // radius in pixels
+
+    auto const screen = [&](size_t i) { return model->levels[i].error / model->sphere.radius * projected; };
+    size_t level = std::min(model->level, model->levels.size() - 1);
+    while (level > 0 && screen(level) > tolerance)
+        --level;
+    while (level + 1 < model->levels.size() && screen(level + 1) <= tolerance * (1.0f - hysteresis))
+        ++level;
+    model->level = level;
+}
+
+void select(std::vector<Model *> const &models, glm::mat4 const &view, glm::mat4 const &projection, float height)
+{
+    for (auto *model : models)
+        select(model, view, projection, height);
+}
+
+// triangles drawn by the models at their selected levels
+size_t triangles(std::vector<Model *> const &models)
+{
+    size_t count = 0;
+    for (auto const *model : models)
+        count += (model->levels.empty() ? model->size : model->levels[model->level].count) / 3;
+    return count;
+}
+
+} // namespace lod
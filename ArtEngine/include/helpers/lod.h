@@ -0,0 +1,40 @@
+/*+*************************************************************************//*!
+\file:      lod.h
+
+\summary:   automatic level of detail, obj meshes are simplified into a chain of
+            coarser levels with quadric error metrics (Garland-Heckbert) and
+            the level drawn is picked every frame from the projected size of
+            the bounding sphere, a level only becomes coarser once it clearly
+            undercuts the screen space tolerance so models do not flicker
+            between two levels
+
+\functions: generate\n
+            select\n
+            triangles\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_LOD_H
+#define ARTENGINE_LOD_H
+
+namespace lod
+{
+
+extern size_t levels;    //!< simplified levels generated per mesh, 0 disables lod
+extern float ratio;      //!< triangles kept by a level relative to the previous one
+extern float tolerance;  //!< screen space error in pixels a level may introduce
+extern float hysteresis; //!< fraction of the tolerance a coarser level has to undercut
+
+void generate(object::Mesh &mesh);
+
+void select(Model *model, glm::mat4 const &view, glm::mat4 const &projection, float height);
+void select(std::vector<Model *> const &models, glm::mat4 const &view, glm::mat4 const &projection, float height);
+
+[[nodiscard]] size_t triangles(std::vector<Model *> const &models);
+
+} // namespace lod
+
+#endif // ARTENGINE_LOD_H
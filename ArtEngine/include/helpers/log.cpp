@@ -5,10 +5,375 @@ namespace my_log
 
 bool is_debug = true;    //!< use debug mode
 std::string key = "LOG"; //!< type of log
+bool async = true;       //!< format on the writer thread, otherwise on the caller
 
-void raw()
+////////////////////////////////////////////////////////////////////////////////
+//// INTERNAL STATE
+////////////////////////////////////////////////////////////////////////////////
+
+enum class State : int
+{
+    idle,    // writer not started yet, started by the first record
+    running, // records are queued for the writer
+    stopped  // writer joined, records are written by the caller
+};
+
+static Queue queue;                              // records in flight
+static std::atomic<State> state = State::idle;   // writer state
+static std::atomic<size_t> submitted = 0;        // records pushed into the queue
+static std::atomic<size_t> written = 0;          // records written by the writer
+static std::atomic<size_t> lost = 0;             // records dropped on a full queue
+static std::atomic<bool> sleeping = false;       // writer waits for a push
+static std::mutex wake_mutex;                    // guards the wait of the writer
+static std::condition_variable wake;             // signalled by a push to a sleeping writer
+static std::mutex sinks_mutex;                   // guards the sinks and the writer start
+static std::vector<std::shared_ptr<Sink>> sinks; // line destinations
+static bool console = true;                      // add the console when no sink was added
+static std::mutex flush_mutex;                   // flushers wait on
+static std::condition_variable flushed;          // signalled after every written batch
+static std::thread writer;                       // background writer
+
+// time the log started, file lines are stamped relative to it
+static std::chrono::steady_clock::time_point const origin = std::chrono::steady_clock::now();
+
+////////////////////////////////////////////////////////////////////////////////
+//// QUEUE
+////////////////////////////////////////////////////////////////////////////////
+
+Queue::Queue()
+    : cells(new Cell[capacity])
+{
+    for (size_t i = 0; i < capacity; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+/*M+M***********************************************************************//*!
+\method:   Queue::push
+
+\summary:  claim the next free cell and publish a record, safe to call from
+           any number of threads
+
+\args:     record - record to store
+
+\return:   True, if the record was stored
+\return:   False, if the queue was full and the record dropped
+************************************************************************//*M-M*/
+bool Queue::push(Record &&record)
+{
+    size_t position = head.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true)
+    {
+        cell = &cells[position % capacity];
+        size_t const sequence = cell->sequence.load(std::memory_order_acquire);
+        auto const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0)
+        {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+            return false; // the writer has not released the cell of the previous lap
+        else
+            position = head.load(std::memory_order_relaxed);
+    }
+
+    cell->record = std::move(record);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Queue::pop
+
+\summary:  take the oldest published record and release its cell for the next
+           lap, only called by the writer
+
+\args:     record - receives the record
+
+\return:   True, if a record was taken
+\return:   False, if no record is published yet
+************************************************************************//*M-M*/
+bool Queue::pop(Record &record)
+{
+    Cell &cell = cells[tail % capacity];
+    if (cell.sequence.load(std::memory_order_acquire) != tail + 1)
+        return false;
+
+    record = std::move(cell.record);
+    cell.record = Record();
+    cell.sequence.store(tail + capacity, std::memory_order_release);
+    ++tail;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// SINKS
+////////////////////////////////////////////////////////////////////////////////
+
+void Console::write(Level, double, std::string_view line)
+{
+    std::cout << line;
+}
+
+void Console::flush()
+{
+    std::cout.flush();
+}
+
+File::File(std::string path)
+    : m_file(path, std::ios::out | std::ios::trunc)
+{
+    if (!m_file.is_open())
+        std::cout << "[ERROR] Unable to open log file " << path << "." << std::endl;
+}
+
+void File::write(Level, double time, std::string_view line)
 {
-    std::cout << std::endl;
+    if (m_file.is_open())
+        m_file << "[" << std::fixed << std::setprecision(6) << time << "] " << line;
 }
 
-} // namespace log
\ No newline at end of file
+void File::flush()
+{
+    m_file.flush();
+}
+
+/*F+F***********************************************************************//*!
+\function: add
+
+\summary:  add a line destination, the console is only used while no sink was
+           added
+
+\args:     sink - destination to add
+************************************************************************//*F-F*/
+void add(std::shared_ptr<Sink> sink)
+{
+    std::lock_guard<std::mutex> lock(sinks_mutex);
+    if (console)
+    {
+        sinks.clear();
+        console = false;
+    }
+    sinks.push_back(std::move(sink));
+}
+
+// remove every sink, records are discarded until a sink is added
+void clear()
+{
+    std::lock_guard<std::mutex> lock(sinks_mutex);
+    sinks.clear();
+    console = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// WRITER
+////////////////////////////////////////////////////////////////////////////////
+
+// format a record and hand the line to every sink, called with the sinks locked
+static void write(Record const &record)
+{
+    std::ostringstream line; // fresh stream, formats may leave manipulators behind
+    if (!record.tag.empty())
+        line << "[" << record.tag << "] ";
+    if (record.format)
+        record.format(line);
+    if (record.line)
+        line << "\n";
+
+    std::string const text = line.str();
+    double const time = std::chrono::duration<double>(record.time - origin).count();
+    for (auto &sink : sinks)
+        sink->write(record.level, time, text);
+}
+
+// wake the writer if it sleeps, a push only pays for the check while the writer is busy
+static void notify()
+{
+    if (!sleeping.load() || !sleeping.exchange(false))
+        return;
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    wake.notify_one();
+}
+
+// write the queued records in batches, sinks are flushed once per batch
+static void run()
+{
+    profiler::name("log writer");
+
+    Record record;
+    size_t reported = 0;
+    size_t taken = 0; // records popped, compared against the submitted count before sleeping
+    while (true)
+    {
+        bool const stopping = state.load(std::memory_order_acquire) != State::running;
+
+        size_t batch = 0;
+        {
+            std::lock_guard<std::mutex> lock(sinks_mutex);
+            while (queue.pop(record))
+            {
+                write(record);
+                ++batch;
+            }
+            taken += batch;
+
+            size_t const count = lost.load(std::memory_order_relaxed);
+            if (count != reported)
+            {
+                Record report{Level::error, std::chrono::steady_clock::now(), "LOG",
+                              format(count - reported, " records dropped on a full queue.")};
+                write(report);
+                reported = count;
+            }
+
+            if (batch)
+                for (auto &sink : sinks)
+                    sink->flush();
+        }
+
+        if (batch)
+        {
+            written.fetch_add(batch, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            flushed.notify_all();
+            continue;
+        }
+        if (stopping)
+            break;
+
+        // announce the sleep before checking the count, a producer counts its push before checking the announcement
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        sleeping.store(true);
+        if (submitted.load() <= taken && state.load() == State::running)
+            wake.wait(lock, [] { return !sleeping.load(); });
+        sleeping.store(false);
+    }
+}
+
+/*F+F***********************************************************************//*!
+\function: start
+
+\summary:  start the writer thread, called implicitly by the first record
+************************************************************************//*F-F*/
+void start()
+{
+    std::lock_guard<std::mutex> lock(sinks_mutex);
+    if (state.load(std::memory_order_acquire) != State::idle)
+        return;
+
+    if (console && sinks.empty())
+        sinks.push_back(std::make_shared<Console>());
+    state.store(State::running, std::memory_order_release);
+    writer = std::thread(run);
+}
+
+/*F+F***********************************************************************//*!
+\function: stop
+
+\summary:  write the queued records and join the writer, later records are
+           written synchronously by the calling thread
+************************************************************************//*F-F*/
+void stop()
+{
+    State expected = State::running;
+    if (!state.compare_exchange_strong(expected, State::stopped))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        sleeping.store(false);
+        wake.notify_one();
+    }
+    writer.join();
+}
+
+/*F+F***********************************************************************//*!
+\function: flush
+
+\summary:  block until every record submitted before the call was written and
+           the sinks were flushed
+************************************************************************//*F-F*/
+void flush()
+{
+    size_t const target = submitted.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(flush_mutex);
+    while (state.load(std::memory_order_acquire) == State::running &&
+           written.load(std::memory_order_acquire) < target)
+        flushed.wait_for(lock, std::chrono::milliseconds(1));
+}
+
+// records dropped on a full queue since the start
+size_t dropped()
+{
+    return lost.load(std::memory_order_relaxed);
+}
+
+// write a record on the calling thread after the queued records, then flush the sinks
+static void write_now(Record const &record)
+{
+    flush();
+    std::lock_guard<std::mutex> lock(sinks_mutex);
+    if (console && sinks.empty())
+        sinks.push_back(std::make_shared<Console>());
+    write(record);
+    for (auto &sink : sinks)
+        sink->flush();
+}
+
+/*F+F***********************************************************************//*!
+\function: submit
+
+\summary:  queue a record for the writer, the caller only captures the time
+           and pays for the push, formatting happens on the writer, errors
+           are never dropped and return once they reached the sinks so they
+           survive a crash right after the call
+
+\args:     level - severity
+\args:     tag - prefix in brackets, none if empty
+\args:     format - writes the captured arguments
+\args:     line - terminate with a newline
+************************************************************************//*F-F*/
+void submit(Level level, std::string tag, Format format, bool line)
+{
+    Record record{level, std::chrono::steady_clock::now(), std::move(tag), std::move(format), line};
+
+    State current = state.load(std::memory_order_acquire);
+    if (current == State::idle && async)
+    {
+        start();
+        current = state.load(std::memory_order_acquire);
+    }
+
+    // synchronous path, after stop or when asynchronous logging is disabled
+    if (current != State::running || !async)
+    {
+        write_now(record);
+        return;
+    }
+
+    if (!queue.push(std::move(record)))
+    {
+        if (level == Level::error)
+            write_now(record); // the push failed before moving from the record
+        else
+            lost.fetch_add(1, std::memory_order_relaxed);
+        notify();
+        return;
+    }
+    submitted.fetch_add(1);
+    notify();
+
+    if (level == Level::error)
+        flush();
+}
+
+// joins the writer before the static state is destroyed at exit
+static struct Shutdown
+{
+    ~Shutdown()
+    {
+        stop();
+    }
+} shutdown;
+
+} // namespace my_log
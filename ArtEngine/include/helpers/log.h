@@ -1,65 +1,228 @@
+/*+*************************************************************************//*!
+\file:      log.h
+
+\summary:   asynchronous logging, the calling thread captures the arguments and
+            pushes a record into a lock-free multi-producer queue, a background
+            writer formats the records and hands the lines to the sinks, levels
+            below ARTENGINE_LOG_LEVEL are compiled out, the ART_LOG macros also
+            skip evaluating the arguments of a compiled out call
+
+\structs:   Record
+            Queue
+
+\classes:   Sink
+            Console
+            File
+
+\functions: add\n
+            clear\n
+            start\n
+            stop\n
+            flush\n
+            dropped\n
+            submit\n
+            raw\n
+            out\n
+            error\n
+            debug\n
+            progress\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
 #ifndef ARTENGINE_LOG_H
 #define ARTENGINE_LOG_H
 
+// lowest level compiled in, 0 debug, 1 info, 2 error, 3 none
+#ifndef ARTENGINE_LOG_LEVEL
+#define ARTENGINE_LOG_LEVEL 0
+#endif
+
+namespace my_log
+{
+
+enum class Level : int
+{
+    debug = 0,
+    info = 1,
+    error = 2,
+    none = 3
+};
+
+// level is compiled in
+consteval bool compiled(Level level)
+{
+    return static_cast<int>(level) >= ARTENGINE_LOG_LEVEL;
+}
+
+} // namespace my_log
+
+// log call whose arguments are not even evaluated when the level is compiled out
+#define ART_LOG(level, function, ...)                                                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (my_log::compiled(level))                                                                         \
+            my_log::function(__VA_ARGS__);                                                                             \
+    } while (false)
+#define ART_LOG_OUT(...) ART_LOG(my_log::Level::info, out, __VA_ARGS__)
+#define ART_LOG_ERROR(...) ART_LOG(my_log::Level::error, error, __VA_ARGS__)
+#define ART_LOG_DEBUG(...) ART_LOG(my_log::Level::debug, debug, __VA_ARGS__)
+
 namespace my_log
 {
 
 extern bool is_debug;   //!< use debug mode
 extern std::string key; //!< type of log
+extern bool async;      //!< format on the writer thread, otherwise on the caller
 
-////////////////////////////////////////////////////////////////////////////////
-//// RAW DATA OUTPUT
-////////////////////////////////////////////////////////////////////////////////
+using Format = std::function<void(std::ostream &)>;
+
+// log call captured by the caller, formatted by the writer
+struct Record
+{
+    Level level = Level::info;                  //!< severity
+    std::chrono::steady_clock::time_point time; //!< time of the call
+    std::string tag;                            //!< prefix in brackets, none if empty
+    Format format;                              //!< writes the captured arguments
+    bool line = true;                           //!< terminate with a newline
+};
+
+/*S+S***********************************************************************//*!
+\struct:   Queue
+
+\summary:  bounded multi-producer, single consumer queue of records, every
+           cell carries a sequence number so producers claim cells with a
+           single compare exchange and never block each other or the writer,
+           a full queue drops info and debug records, errors are written by
+           the caller instead
+
+\methods:  push - append a record, dropped when the queue is full\n
+        :  pop - take the oldest published record, writer only\n
+************************************************************************//*S-S*/
+struct Queue
+{
+    static size_t constexpr capacity = 1 << 13; //!< records in flight
+
+    Queue();
+
+    bool push(Record &&record);
+    bool pop(Record &record);
+
+    // queue cell, the sequence tells producers and the consumer whose turn it is
+    struct Cell
+    {
+        std::atomic<size_t> sequence; //!< publication state of the cell
+        Record record;                //!< stored record
+    };
+
+    std::unique_ptr<Cell[]> cells;           //!< cell storage
+    alignas(64) std::atomic<size_t> head{0}; //!< next cell claimed (producers)
+    alignas(64) size_t tail = 0;             //!< next cell read (consumer)
+};
+
+/*C+C***********************************************************************//*!
+\class:    Sink
+
+\summary:  destination of formatted lines, only called by one thread at a time
+
+\methods:  write - output a formatted line\n
+        :  flush - push buffered lines to the destination\n
+************************************************************************//*C-C*/
+class Sink
+{
+  public:
+    virtual ~Sink() = default;
 
-void raw();
+    virtual void write(Level level, double time, std::string_view line) = 0;
+    virtual void flush()
+    {
+    }
+
+}; // class Sink
+
+// standard output, flushed once per batch instead of once per line
+class Console : public Sink
+{
+  public:
+    void write(Level level, double time, std::string_view line) override;
+    void flush() override;
+
+}; // class Console
+
+// log file, every line is prefixed with the seconds since the log started
+class File : public Sink
+{
+  public:
+    explicit File(std::string path);
+
+    void write(Level level, double time, std::string_view line) override;
+    void flush() override;
 
+  private:
+    std::ofstream m_file; //!< output file
+
+}; // class File
+
+void add(std::shared_ptr<Sink> sink);
+void clear();
+
+void start();
+void stop();
+void flush();
+[[nodiscard]] size_t dropped();
+
+void submit(Level level, std::string tag, Format format, bool line = true);
+
+// copy arguments that may not outlive the call, e.g. c strings of temporaries
 template <typename T>
-void raw(T message)
+auto deferred(T const &value)
 {
-    std::cout << message << std::endl;
+    if constexpr (std::is_convertible_v<T const &, std::string_view>)
+        return std::string(value);
+    else
+        return value;
 }
 
-template <typename T, typename... Args>
-void raw(T message, Args... args)
+// capture the arguments by value, they are written on the writer thread
+template <typename... Args>
+Format format(Args const &...args)
 {
-    std::cout << message;
-    raw(args...);
+    return [... values = deferred(args)](std::ostream &out) { (out << ... << values); };
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//// STANDARD OUTPUT
+//// RAW DATA OUTPUT
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename T>
-void out(T message)
+template <typename... Args>
+void raw(Args const &...args)
 {
-    std::cout << "[" << key << "] ";
-    raw(message);
+    if constexpr (compiled(Level::info))
+        submit(Level::info, "", format(args...));
 }
 
-template <typename T, typename... Args>
-void out(T message, Args... args)
+////////////////////////////////////////////////////////////////////////////////
+//// STANDARD OUTPUT
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename... Args>
+void out(Args const &...args)
 {
-    std::cout << "[" << key << "] ";
-    raw(message, args...);
+    if constexpr (compiled(Level::info))
+        submit(Level::info, key, format(args...));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //// ERROR OUTPUT
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename T>
-void error(T message)
-{
-    std::cout << "[ERROR] ";
-    raw(message);
-}
-
-template <typename T, typename... Args>
-void error(T message, Args... args)
+template <typename... Args>
+void error(Args const &...args)
 {
-    std::cout << "[ERROR] ";
-    raw(message, args...);
+    if constexpr (compiled(Level::error))
+        submit(Level::error, "ERROR", format(args...));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -67,43 +230,54 @@ void error(T message, Args... args)
 ////////////////////////////////////////////////////////////////////////////////
 
 template <typename... Args>
-void debug(Args... args)
+void debug(Args const &...args)
 {
-    if (!is_debug)
-        return;
-    std::cout << "[DEBUG] ";
-    raw(args...);
+    if constexpr (compiled(Level::debug))
+    {
+        if (!is_debug)
+            return;
+        submit(Level::debug, "DEBUG", format(args...));
+    }
 }
 
 template <typename... Args>
-void debug(bool condition, Args... args)
+void debug(bool condition, Args const &...args)
 {
-    if (!condition)
-        return; // failed the debug condition
-    std::cout << "[DEBUG] ";
-    raw(args...);
+    if constexpr (compiled(Level::debug))
+    {
+        if (!condition)
+            return; // failed the debug condition
+        submit(Level::debug, "DEBUG", format(args...));
+    }
 }
 
 template <typename T>
 void progress(T d, T D)
 {
-    if (d != 0)
-        std::cout << "\n";
-    std::cout << "[" << d << "/" << D << "][";
-
-    for (int i = 0; i < 25; ++i)
+    if constexpr (compiled(Level::info))
     {
-        if (i < 25 * static_cast<float>(d) / static_cast<float>(D))
-            std::cout << "#";
-        else
-            std::cout << "-";
+        submit(
+            Level::info, "",
+            [d, D](std::ostream &out) {
+                if (d != 0)
+                    out << "\n";
+                out << "[" << d << "/" << D << "][";
+
+                for (int i = 0; i < 25; ++i)
+                {
+                    if (i < 25 * static_cast<float>(d) / static_cast<float>(D))
+                        out << "#";
+                    else
+                        out << "-";
+                }
+                out << "]";
+                if (d == D - 1)
+                    out << "\n";
+            },
+            false);
     }
-    std::cout << "]";
-    if (d == D - 1)
-        std::cout << "\n";
-    std::cout << std::flush;
 }
 
-} // namespace log
+} // namespace my_log
 
 #endif // ARTENGINE_LOG_H
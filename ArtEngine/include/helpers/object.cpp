@@ -3,6 +3,29 @@
 namespace object
 {
 
+bool compressed = false;          //!< upload quantized positions, octahedral normals and palette indices
+std::string cache;                //!< parsed and simplified mesh directory, empty disables caching
+
+static std::vector<glm::vec4> colors; // palette shared by every compressed model
+
+// format of the cached meshes, bumped whenever parse or lod::generate change their output
+static std::uint32_t constexpr mesh_version = 1;
+
+// header of a cached mesh, followed by the bounds, the vertex arrays and the levels
+struct MeshHeader
+{
+    char magic[4];          // "ARTM"
+    std::uint32_t version;  // mesh_version of the writer
+    std::uint32_t levels;   // detail levels
+    std::uint64_t vertices; // vertices of every level
+};
+
+// obj path as loaded, models are looked up in the object folder
+static std::string path(std::string const &file)
+{
+    return file.substr(0, 7) == "object/" ? file : "object/" + file;
+}
+
 std::unordered_map<std::string, glm::vec3> materials(std::string file)
 {
     std::unordered_map<std::string, glm::vec3> material;
@@ -10,7 +33,7 @@ std::unordered_map<std::string, glm::vec3> materials(std::string file)
     std::ifstream in(file + ".mtl", std::ios::in);
     if (!in.is_open())
     {
-        std::cout << "Error: Failed to open file " << file << ".mtl" << std::endl;
+        my_log::error("Failed to open file ", file, ".mtl");
         return material;
     }
 
@@ -32,7 +55,7 @@ std::unordered_map<std::string, glm::vec3> materials(std::string file)
             float b;
             int n = sscanf_s(line.substr(3).c_str(), "%f %f %f\n", &r, &g, &b);
             if (n != 3)
-                std::cout << "Error: Material Color Data was not read correctly." << std::endl;
+                my_log::error("Material Color Data was not read correctly.");
             else
                 material[material_name] = glm::vec3(r, g, b);
         }
@@ -42,17 +65,29 @@ std::unordered_map<std::string, glm::vec3> materials(std::string file)
     return material;
 }
 
-Model *load(std::string file, glm::vec3 color)
+/*F+F***********************************************************************//*!
+\function: parse
+
+\summary:  read an obj file and its materials into cpu side buffers, touches
+           no gl state and is safe to call from a job
+
+\args:     file - obj file path without extension
+\args:     mesh - parsed geometry
+\args:     color - color used until a material is selected
+
+\return:   True, if the file was parsed
+\return:   False, otherwise
+************************************************************************//*F-F*/
+bool parse(std::string file, Mesh &mesh, glm::vec3 color)
 {
     // append the object folder if trying to load a model without it
-    if (file.substr(0, 7) != "object/")
-        file = "object/" + file;
+    file = path(file);
 
     std::ifstream in(file + ".obj", std::ios::in);
     if (!in.is_open())
     {
-        std::cout << "Error: Failed to open file " << file << ".obj" << std::endl;
-        return nullptr;
+        my_log::error("Failed to open file ", file, ".obj");
+        return false;
     }
 
     std::unordered_map<std::string, glm::vec3> material = materials(file);
@@ -60,9 +95,9 @@ Model *load(std::string file, glm::vec3 color)
     std::vector<glm::vec3> vertex_buffer;
     std::vector<glm::vec3> normal_buffer;
 
-    std::vector<float> positions;
-    std::vector<float> normals;
-    std::vector<float> colors;
+    std::vector<float> &positions = mesh.positions;
+    std::vector<float> &normals = mesh.normals;
+    std::vector<float> &colors = mesh.colors;
 
     bool vt = false;
 
@@ -130,8 +165,8 @@ Model *load(std::string file, glm::vec3 color)
                 int n = sscanf_s(line.substr(2).c_str(), "%d %d %d", &vi[0], &vi[1], &vi[2]);
                 if (n != 3)
                 {
-                    std::cout << "Error: Face data could not be read correctly." << std::endl;
-                    return nullptr;
+                    my_log::error("Face data could not be read correctly.");
+                    return false;
                 }
             }
             else // parse face data normally
@@ -148,8 +183,8 @@ Model *load(std::string file, glm::vec3 color)
                                  &vi[2], &ni[2]);
                     if (n != 6)
                     {
-                        std::cout << "Error: Face data could not be read correctly." << std::endl;
-                        return nullptr;
+                        my_log::error("Face data could not be read correctly.");
+                        return false;
                     }
                 }
             }
@@ -205,53 +240,334 @@ Model *load(std::string file, glm::vec3 color)
         distance = std::max(distance, d);
     }
 
+    mesh.name = file;
+    mesh.min = min;
+    mesh.max = max;
+    mesh.center = center;
+    mesh.radius = distance;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// MESH CACHE
+////////////////////////////////////////////////////////////////////////////////
+
+// 64 bit fnv-1a hash
+static std::uint64_t fnv1a(std::string_view data, std::uint64_t hash = 14695981039346656037ull)
+{
+    for (unsigned char const c : data)
+        hash = (hash ^ c) * 1099511628211ull;
+    return hash;
+}
+
+// cache key of an obj, changes with the format, the obj and mtl files, the default color and the lod settings
+static std::string cache_key(std::string const &file, glm::vec3 color)
+{
+    std::uint64_t hash = fnv1a(file + ";" + std::to_string(mesh_version) + ";");
+    for (auto const &extension : {".obj", ".mtl"})
+    {
+        std::error_code code;
+        auto const time = std::filesystem::last_write_time(file + extension, code).time_since_epoch().count();
+        auto const bytes = std::filesystem::file_size(file + extension, code);
+        hash = fnv1a(std::to_string(time) + ";" + std::to_string(bytes) + ";", hash);
+    }
+    hash = fnv1a(glm::to_string(color), hash);
+    hash = fnv1a(std::to_string(lod::levels) + ";" + std::to_string(lod::ratio), hash);
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
+// read a cached mesh, false if missing, of another format, truncated or corrupt
+static bool load_cached(std::string const &key, Mesh &mesh)
+{
+    if (cache.empty())
+        return false;
+
+    std::string const file = cache + "/" + key + ".mesh";
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    MeshHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::string_view(header.magic, 4) != "ARTM" || header.version != mesh_version)
+        return false;
+
+    // the counts have to match the file size before anything is allocated for them
+    std::error_code code;
+    std::uint64_t const size = std::filesystem::file_size(file, code);
+    std::uint64_t const bounds = 3 * sizeof(glm::vec3) + sizeof(float);
+    std::uint64_t const vertex = 10 * sizeof(float);
+    if (code || size < sizeof(header) + bounds || header.vertices > (size - sizeof(header) - bounds) / vertex ||
+        size != sizeof(header) + bounds + header.vertices * vertex + header.levels * sizeof(Model::Level))
+        return false;
+
+    mesh.positions.resize(header.vertices * 3);
+    mesh.normals.resize(header.vertices * 3);
+    mesh.colors.resize(header.vertices * 4);
+    mesh.levels.resize(header.levels);
+    in.read(reinterpret_cast<char *>(&mesh.min), sizeof(mesh.min));
+    in.read(reinterpret_cast<char *>(&mesh.max), sizeof(mesh.max));
+    in.read(reinterpret_cast<char *>(&mesh.center), sizeof(mesh.center));
+    in.read(reinterpret_cast<char *>(&mesh.radius), sizeof(mesh.radius));
+    in.read(reinterpret_cast<char *>(mesh.positions.data()), mesh.positions.size() * sizeof(float));
+    in.read(reinterpret_cast<char *>(mesh.normals.data()), mesh.normals.size() * sizeof(float));
+    in.read(reinterpret_cast<char *>(mesh.colors.data()), mesh.colors.size() * sizeof(float));
+    in.read(reinterpret_cast<char *>(mesh.levels.data()), mesh.levels.size() * sizeof(Model::Level));
+    return static_cast<bool>(in);
+}
+
+// store a parsed and simplified mesh
+static void save_cached(std::string const &key, Mesh const &mesh)
+{
+    if (cache.empty())
+        return;
+
+    std::error_code code;
+    std::filesystem::create_directories(cache, code);
+    std::ofstream out(cache + "/" + key + ".mesh", std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        my_log::error("Unable to write mesh to ", cache, ".");
+        return;
+    }
+
+    MeshHeader const header{{'A', 'R', 'T', 'M'}, mesh_version, static_cast<std::uint32_t>(mesh.levels.size()),
+                            mesh.positions.size() / 3};
+    out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    out.write(reinterpret_cast<char const *>(&mesh.min), sizeof(mesh.min));
+    out.write(reinterpret_cast<char const *>(&mesh.max), sizeof(mesh.max));
+    out.write(reinterpret_cast<char const *>(&mesh.center), sizeof(mesh.center));
+    out.write(reinterpret_cast<char const *>(&mesh.radius), sizeof(mesh.radius));
+    out.write(reinterpret_cast<char const *>(mesh.positions.data()), mesh.positions.size() * sizeof(float));
+    out.write(reinterpret_cast<char const *>(mesh.normals.data()), mesh.normals.size() * sizeof(float));
+    out.write(reinterpret_cast<char const *>(mesh.colors.data()), mesh.colors.size() * sizeof(float));
+    out.write(reinterpret_cast<char const *>(mesh.levels.data()), mesh.levels.size() * sizeof(Model::Level));
+}
+
+/*F+F***********************************************************************//*!
+\function: prepare
+
+\summary:  parsed geometry of an obj with its detail levels, read from the
+           mesh cache while the obj and mtl are unchanged, otherwise parsed,
+           simplified and stored, touches no gl state and is safe to call
+           from a job
+
+\args:     file - obj file path without extension
+\args:     mesh - parsed geometry
+\args:     color - color used until a material is selected
+
+\return:   True, if the mesh was read or parsed
+\return:   False, otherwise
+************************************************************************//*F-F*/
+bool prepare(std::string file, Mesh &mesh, glm::vec3 color)
+{
+    file = path(file);
+    std::string const key = cache_key(file, color);
+    if (load_cached(key, mesh))
+    {
+        mesh.name = file;
+        return true;
+    }
+    mesh = Mesh();
+
+    if (!parse(file, mesh, color))
+        return false;
+    lod::generate(mesh);
+    save_cached(key, mesh);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// UPLOAD
+////////////////////////////////////////////////////////////////////////////////
+
+// palette index of a color, added on first use, the last entry is reused once the palette is full
+static std::uint16_t palette_index(glm::vec4 const &color)
+{
+    auto it = std::find(colors.begin(), colors.end(), color);
+    if (it != colors.end())
+        return static_cast<std::uint16_t>(it - colors.begin());
+
+    if (colors.size() == palette_size)
+    {
+        my_log::error("Material palette full, ", palette_size, " colors.");
+        return static_cast<std::uint16_t>(palette_size - 1);
+    }
+    colors.push_back(color);
+    return static_cast<std::uint16_t>(colors.size() - 1);
+}
+
+// upload compact geometry, 16 bytes per vertex instead of 40
+static void upload_compressed(Model *model, Mesh const &mesh)
+{
+    size_t const n = mesh.positions.size() / 3;
+
+    // positions as 16 bit offsets within the aabb, a flat axis keeps a nonzero extent
+    model->quantized = true;
+    model->origin = mesh.min;
+    model->extent = glm::max(mesh.max - mesh.min, glm::vec3(std::numeric_limits<float>::min()));
+    std::vector<float> offsets(n * 3);
+    for (size_t i = 0; i < n * 3; ++i)
+        offsets[i] = glm::clamp((mesh.positions[i] - model->origin[i % 3]) / model->extent[i % 3], 0.0f, 1.0f);
+
+    // one palette index per vertex, the corners of a face share the material so look ups repeat
+    std::vector<std::uint16_t> materials(n);
+    glm::vec4 last(-1.0f);
+    std::uint16_t index = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        glm::vec4 const color(mesh.colors[i * 4], mesh.colors[i * 4 + 1], mesh.colors[i * 4 + 2],
+                              mesh.colors[i * 4 + 3]);
+        if (color != last)
+            index = palette_index(last = color);
+        materials[i] = index;
+    }
+
+    model->bind<vertex::Unorm16<3>>("in_Position", new Buffer(vertex::pack<vertex::Unorm16<3>>(offsets)), true);
+    model->bind<vertex::Octahedral>("in_Normal", new Buffer(vertex::pack<vertex::Octahedral>(mesh.normals)), true);
+    model->bind<vertex::Uint16<1>>(
+        "in_Color", new Buffer(vertex::pack<vertex::Uint16<1>, std::uint16_t>(materials)), true);
+}
+
+// colors referenced by the palette indices of compressed models
+std::vector<glm::vec4> const &palette()
+{
+    return colors;
+}
+
+/*F+F***********************************************************************//*!
+\function: upload
+
+\summary:  construct a model from parsed geometry, requires the gl context
+
+\args:     mesh - parsed geometry
+
+\return:   Model * - model owning its buffers
+************************************************************************//*F-F*/
+Model *upload(Mesh const &mesh)
+{
     // construct the model from the buffer data
-    Model *model = new Model({"in_Position", "in_Normal", "in_Color"}, file);
-    model->bind<glm::vec3>("in_Position", new Buffer(positions), true);
-    model->bind<glm::vec3>("in_Normal", new Buffer(normals), true);
-    model->bind<glm::vec4>("in_Color", new Buffer(colors), true);
-    model->size = positions.size() / 3;
+    Model *model = new Model({"in_Position", "in_Normal", "in_Color"}, mesh.name);
+    if (compressed)
+        upload_compressed(model, mesh);
+    else
+    {
+        // normals and colors are packed to a word each
+        model->bind<glm::vec3>("in_Position", new Buffer(mesh.positions), true);
+        model->bind<vertex::Snorm10>("in_Normal", new Buffer(vertex::pack<vertex::Snorm10>(mesh.normals)), true);
+        model->bind<vertex::Unorm8<4>>("in_Color", new Buffer(vertex::pack<vertex::Unorm8<4>>(mesh.colors)), true);
+    }
+    // the buffers hold every level, size counts the full detail one
+    model->size = mesh.levels.empty() ? mesh.positions.size() / 3 : mesh.levels[0].count;
+    model->levels = mesh.levels;
     // construct aabb
-    model->aabb.center = center;
-    model->aabb.min = min;
-    model->aabb.max = max;
-    model->aabb.scale = max - center;
+    model->aabb.center = mesh.center;
+    model->aabb.min = mesh.min;
+    model->aabb.max = mesh.max;
+    model->aabb.scale = mesh.max - mesh.center;
     model->aabb.model = model;
     // construct bounding sphere
-    model->sphere.center = center;
-    model->sphere.radius = distance;
+    model->sphere.center = mesh.center;
+    model->sphere.radius = mesh.radius;
     model->sphere.model = model;
     // copy color info
-    model->color.resize(model->size);
-    model->buffers["in_Color"]->retrieve(model->color);
+    model->color.resize(mesh.positions.size() / 3);
+    for (size_t i = 0; i < model->color.size(); ++i)
+        model->color[i] = {mesh.colors[i * 4], mesh.colors[i * 4 + 1], mesh.colors[i * 4 + 2], mesh.colors[i * 4 + 3]};
 
     return model;
 }
 
+/*F+F***********************************************************************//*!
+\function: replace
+
+\summary:  swap the geometry of a model for newly parsed geometry, the model
+           keeps its address, transform and name, requires the gl context
+
+\args:     model - model to update
+\args:     mesh - parsed geometry
+************************************************************************//*F-F*/
+void replace(Model *model, Mesh const &mesh)
+{
+    Model *fresh = upload(mesh);
+    std::swap(model->vao, fresh->vao);
+    std::swap(model->idx, fresh->idx);
+    std::swap(model->indexed, fresh->indexed);
+    std::swap(model->size, fresh->size);
+    std::swap(model->bindings, fresh->bindings);
+    std::swap(model->buffers, fresh->buffers);
+    std::swap(model->color, fresh->color);
+    std::swap(model->levels, fresh->levels);
+    model->level = 0;
+    model->quantized = fresh->quantized;
+    model->origin = fresh->origin;
+    model->extent = fresh->extent;
+    model->aabb = fresh->aabb;
+    model->aabb.model = model;
+    model->sphere = fresh->sphere;
+    model->sphere.model = model;
+    delete fresh; // releases the previous vertex array and buffers
+}
+
+Model *load(std::string file, glm::vec3 color)
+{
+    Mesh mesh;
+    if (!prepare(file, mesh, color))
+        return nullptr;
+    return upload(mesh);
+}
+
+/*F+F***********************************************************************//*!
+\function: load_all
+
+\summary:  load every obj listed in the given files, the files are parsed and
+           simplified in parallel on the job system, or read from the mesh
+           cache, and uploaded in list order on the calling thread, which
+           owns the gl context
+
+\args:     files - list file paths without extension, one obj per line
+\args:     color - color used until a material is selected
+
+\return:   std::vector<Model *> - loaded models in list order
+************************************************************************//*F-F*/
 std::vector<Model *> load_all(std::vector<std::string> files, glm::vec3 color)
 {
-    std::vector<Model *> models;
+    std::vector<std::string> names;
     for (auto const &file : files)
     {
         std::ifstream in(file + ".txt", std::ios::in);
         if (!in.is_open())
         {
-            std::cout << "Error: Failed to open file " << file << ".txt" << std::endl;
+            my_log::error("Failed to open file ", file, ".txt");
             break;
         }
 
         std::string line;
         while (std::getline(in, line))
-        {
-            // load and save the model
-            Model *model = load(line.substr(0, line.length() - 4), color);
-            if (!model)
-                continue;
-            models.push_back(model);
-        }
+            names.push_back(line.substr(0, line.length() - 4));
 
         in.close();
     }
+
+    // parse and simplify every obj on the workers, one job per file
+    std::vector<Mesh> meshes(names.size());
+    std::vector<char> parsed(names.size(), false);
+    job::parallel_for(
+        names.size(), [&](size_t i) { parsed[i] = prepare(names[i], meshes[i], color); }, 1);
+
+    // create the gl buffers on the calling thread
+    std::vector<Model *> models;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (!parsed[i])
+            continue;
+        models.push_back(upload(meshes[i]));
+        meshes[i] = Mesh(); // release the cpu copy early
+    }
     return models;
 }
 
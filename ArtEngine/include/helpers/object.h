@@ -4,8 +4,33 @@
 namespace object
 {
 
+size_t constexpr palette_size = 128; //!< colors addressable by compressed models, PALETTE_SIZE in shaders
+
+extern bool compressed;   //!< upload quantized positions, octahedral normals and palette indices
+extern std::string cache; //!< parsed and simplified mesh directory, empty (default) disables caching, -meshes dir
+
+// cpu side geometry of an obj file, parsed off the main thread and uploaded on it
+struct Mesh
+{
+    std::string name;                 //!< obj file path without extension
+    std::vector<float> positions;     //!< xyz per vertex
+    std::vector<float> normals;       //!< xyz per vertex
+    std::vector<float> colors;        //!< rgba per vertex
+    glm::vec3 min;                    //!< aabb minimum
+    glm::vec3 max;                    //!< aabb maximum
+    glm::vec3 center;                 //!< aabb center
+    float radius = 0.0f;              //!< centroid sphere radius
+    std::vector<Model::Level> levels; //!< detail levels, full detail first, see lod::generate
+};
+
 std::unordered_map<std::string, glm::vec3> materials(std::string file);
 
+bool parse(std::string file, Mesh &mesh, glm::vec3 color = color::magenta);
+bool prepare(std::string file, Mesh &mesh, glm::vec3 color = color::magenta);
+Model *upload(Mesh const &mesh);
+void replace(Model *model, Mesh const &mesh);
+std::vector<glm::vec4> const &palette();
+
 Model * load(std::string file, glm::vec3 color = color::magenta);
 
 std::vector<Model*> load_all(std::vector<std::string> files, glm::vec3 color = color::magenta);
@@ -0,0 +1,282 @@
+#include "../pch.h"
+
+namespace pacing
+{
+
+double fps = 0.0;
+double spin = 1.5;
+int latency = 2;
+size_t window = 240;
+bool show = false;
+
+////////////////////////////////////////////////////////////////////////////////
+//// INTERNAL STATE
+////////////////////////////////////////////////////////////////////////////////
+
+using Clock = std::chrono::steady_clock;
+
+// fence placed after the gpu work of a frame
+struct Pending
+{
+    GLsync sync;             // signaled once the gpu finished the frame
+    Clock::time_point start; // frame start, right before its input was polled
+    std::uint64_t frame;     // frame number
+};
+
+static size_t constexpr fence_limit = 8;             // fences kept when the run-ahead is unbounded
+static GLuint64 constexpr fence_timeout = 100000000; // nanoseconds a blocking fence wait lasts at most
+
+static std::deque<Frame> history;  // rolling window of completed frames
+static std::uint64_t first = 0;    // frame number of the oldest frame in the history
+static std::deque<Pending> fences; // frames the gpu has not finished yet
+static Clock::time_point start;    // start of the current frame
+static Clock::time_point deadline; // start of the current frame according to the cap
+static std::uint64_t current = 0;  // frame number of the current frame
+static bool started = false;       // a frame was begun
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// milliseconds between two time points
+static float milliseconds(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+// remove the oldest fence if the gpu finished its frame, waiting for it if blocking
+static bool retire(bool block)
+{
+    Pending const &pending = fences.front();
+    GLenum const result = glClientWaitSync(pending.sync, block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                           block ? fence_timeout : 0);
+    if (result == GL_TIMEOUT_EXPIRED && !block)
+        return false;
+
+    // latency of a polled fence includes the time until it was polled, at most a frame
+    if (pending.frame >= first && pending.frame - first < history.size())
+        history[pending.frame - first].latency = milliseconds(pending.start, Clock::now());
+
+    glDeleteSync(pending.sync);
+    fences.pop_front();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// PACING
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: begin
+
+\summary:  start a frame, called by the game loop before the input is taken,
+           finishes the timings of the previous frame, waits for the gpu if
+           the cpu ran too far ahead and sleeps until the deadline of the cap,
+           so the input is polled as late as possible
+************************************************************************//*F-F*/
+void begin()
+{
+    auto const entry = Clock::now();
+
+    // the previous frame joins the history first so its own fence can report the latency
+    if (started)
+    {
+        Frame frame;
+        frame.work = milliseconds(start, entry);
+        if (history.empty())
+            first = current;
+        history.push_back(frame);
+        while (history.size() > window)
+        {
+            history.pop_front();
+            ++first;
+        }
+        ++current;
+    }
+
+    // frames the gpu finished since the last frame
+    while (!fences.empty() && retire(false))
+        ;
+
+    // bound the frames queued ahead of the gpu
+    size_t const limit = latency > 0 ? static_cast<size_t>(latency) : fence_limit;
+    while (fences.size() >= limit)
+        retire(true);
+    auto const synced = Clock::now();
+
+    // cap the frame rate, a deadline missed by more than a frame restarts the pace
+    if (fps > 0.0 && started)
+    {
+        auto const period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+        deadline += period;
+        if (synced > deadline + period)
+            deadline = synced;
+        wait_until(deadline);
+    }
+    else
+        deadline = synced;
+    auto const now = Clock::now();
+
+    if (started)
+    {
+        Frame &frame = history.back();
+        frame.frame = milliseconds(start, now);
+        frame.fence = milliseconds(entry, synced);
+        frame.sleep = milliseconds(synced, now);
+    }
+
+    start = now;
+    started = true;
+}
+
+// sleep until shortly before the time point and spin the rest, sleeps overshoot by up to a scheduler tick
+void wait_until(Clock::time_point time)
+{
+    auto const margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(spin));
+    auto const coarse = time - margin;
+    if (Clock::now() < coarse)
+        std::this_thread::sleep_until(coarse);
+    while (Clock::now() < time)
+        std::this_thread::yield();
+}
+
+// place a fence after the gpu work of the frame, called by the view after the swap
+void fence()
+{
+    fences.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), start, current});
+}
+
+// delete the pending fences, called before the context is destroyed
+void clear()
+{
+    for (auto const &pending : fences)
+        glDeleteSync(pending.sync);
+    fences.clear();
+}
+
+std::deque<Frame> const &frames()
+{
+    return history;
+}
+
+/*F+F***********************************************************************//*!
+\function: stats
+
+\summary:  summarize the frame times and latencies of the rolling window
+
+\return:   Stats - mean, deviation, percentile and latency in milliseconds
+************************************************************************//*F-F*/
+Stats stats()
+{
+    Stats result;
+    result.frames = history.size();
+    if (history.empty())
+        return result;
+
+    std::vector<float> times;
+    times.reserve(history.size());
+    size_t measured = 0;
+    for (auto const &f : history)
+    {
+        times.push_back(f.frame);
+        result.mean += f.frame;
+        result.work += f.work;
+        result.peak = std::max<double>(result.peak, f.frame);
+        if (f.latency > 0.0f)
+        {
+            result.latency += f.latency;
+            ++measured;
+        }
+    }
+    double const n = static_cast<double>(history.size());
+    result.mean /= n;
+    result.work /= n;
+    if (measured)
+        result.latency /= static_cast<double>(measured);
+
+    for (float const time : times)
+        result.deviation += (time - result.mean) * (time - result.mean);
+    result.deviation = std::sqrt(result.deviation / n);
+
+    size_t const p = std::min(times.size() - 1, static_cast<size_t>(0.99 * static_cast<double>(times.size())));
+    std::nth_element(times.begin(), times.begin() + p, times.end());
+    result.p99 = times[p];
+
+    return result;
+}
+
+/*F+F***********************************************************************//*!
+\function: interface
+
+\summary:  draw the frame statistics, the frame time history and histogram,
+           and the controls for the cap, spin, run-ahead and vsync mode
+
+\args:     view - view whose swap interval is tuned
+************************************************************************//*F-F*/
+void interface(View &view)
+{
+    if (!show)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(480, 520), ImGuiCond_Once);
+    ImGui::Begin("Frame Pacing", &show);
+
+    Stats const s = stats();
+    ImGui::Text("%.1f fps, %.3f ms mean, %.3f ms deviation", s.mean > 0.0 ? 1000.0 / s.mean : 0.0, s.mean,
+                s.deviation);
+    ImGui::Text("%.3f ms p99, %.3f ms peak, %.3f ms cpu", s.p99, s.peak, s.work);
+    ImGui::Text("%.3f ms input latency, %zu frames in flight", s.latency, fences.size());
+
+    // vsync mode, adaptive falls back to vsync without swap control tear
+    bool vsync = view.m_vsync;
+    if (ImGui::Checkbox("Vsync", &vsync))
+        view.vsync(vsync);
+    ImGui::SameLine();
+    bool adaptive = view.m_adaptive;
+    if (ImGui::Checkbox("Adaptive", &adaptive))
+        view.adaptive(adaptive);
+    ImGui::SameLine();
+    ImGui::Text("swap interval %d", view.swap_interval());
+
+    float cap = static_cast<float>(fps);
+    if (ImGui::SliderFloat("FPS Cap", &cap, 0.0f, 360.0f, cap > 0.0f ? "%.0f" : "off"))
+        fps = cap;
+    float threshold = static_cast<float>(spin);
+    if (ImGui::SliderFloat("Spin ms", &threshold, 0.0f, 4.0f, "%.2f"))
+        spin = threshold;
+    ImGui::SliderInt("Frames Ahead", &latency, 0, 4, latency > 0 ? "%d" : "unbounded");
+
+    std::vector<float> times, work, latencies;
+    times.reserve(history.size());
+    work.reserve(history.size());
+    latencies.reserve(history.size());
+    for (auto const &f : history)
+    {
+        times.push_back(f.frame);
+        work.push_back(f.work);
+        latencies.push_back(f.latency);
+    }
+
+    if (ImPlot::BeginPlot("##Timeline", ImVec2(-1, 160)))
+    {
+        ImPlot::SetupAxes(nullptr, "ms", ImPlotAxisFlags_NoTickLabels, ImPlotAxisFlags_AutoFit);
+        ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, static_cast<double>(window), ImPlotCond_Always);
+        ImPlot::SetupFinish();
+        ImPlot::PlotLine("frame", times.data(), static_cast<int>(times.size()));
+        ImPlot::PlotLine("cpu", work.data(), static_cast<int>(work.size()));
+        ImPlot::PlotLine("latency", latencies.data(), static_cast<int>(latencies.size()));
+        ImPlot::EndPlot();
+    }
+
+    if (ImPlot::BeginPlot("##Histogram", ImVec2(-1, 160), ImPlotFlags_NoLegend))
+    {
+        ImPlot::SetupAxes("frame ms", nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        ImPlot::SetupFinish();
+        ImPlot::PlotHistogram("##frames", times.data(), static_cast<int>(times.size()), 32);
+        ImPlot::EndPlot();
+    }
+
+    ImGui::End();
+}
+
+} // namespace pacing
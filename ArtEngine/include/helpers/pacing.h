@@ -0,0 +1,78 @@
+/*+*************************************************************************//*!
+\file:      pacing.h
+
+\summary:   frame pacing, every frame starts at a deadline of the frame cap
+            reached by sleeping most of the way and spinning the rest, the
+            cpu may only queue a few frames ahead of the gpu before it waits
+            on the fence of an older frame, and the timings of every frame are
+            kept in a rolling window so frame time variance and input latency
+            (input poll to gpu completion) can be measured while tuning
+
+            -fps n          cap the frame rate, ignored when headless
+            -ahead n        frames the cpu may queue ahead of the gpu
+            --adaptive      adaptive vsync, falls back to vsync
+            --pacing        show the frame pacing statistics
+
+\structs:   Frame
+            Stats
+
+\functions: begin\n
+            wait_until\n
+            fence\n
+            clear\n
+            frames\n
+            stats\n
+            interface\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_PACING_H
+#define ARTENGINE_PACING_H
+
+namespace pacing
+{
+
+// timings of a frame in milliseconds
+struct Frame
+{
+    float frame = 0.0f;   //!< start to start of the next frame
+    float work = 0.0f;    //!< cpu time of the frame without the pacing waits
+    float sleep = 0.0f;   //!< waited for the frame cap
+    float fence = 0.0f;   //!< waited for the gpu to finish an older frame
+    float latency = 0.0f; //!< input poll to gpu completion, 0 until the fence of the frame signaled
+};
+
+// frame statistics of the rolling window in milliseconds
+struct Stats
+{
+    double mean = 0.0;      //!< average frame time
+    double deviation = 0.0; //!< standard deviation of the frame time
+    double p99 = 0.0;       //!< 99th percentile frame time
+    double peak = 0.0;      //!< longest frame
+    double work = 0.0;      //!< average cpu time
+    double latency = 0.0;   //!< average input latency of the frames whose fence signaled
+    size_t frames = 0;      //!< frames in the window
+};
+
+extern double fps;    //!< frame cap, 0 leaves the pace to vsync
+extern double spin;   //!< milliseconds before a deadline spent spinning instead of sleeping
+extern int latency;   //!< frames the cpu may queue ahead of the gpu, 0 only bounds the fences kept
+extern size_t window; //!< frames kept for the statistics
+extern bool show;     //!< draw the pacing interface
+
+void begin();
+void wait_until(std::chrono::steady_clock::time_point time);
+void fence();
+void clear();
+
+[[nodiscard]] std::deque<Frame> const &frames();
+[[nodiscard]] Stats stats();
+
+void interface(View &view);
+
+} // namespace pacing
+
+#endif // ARTENGINE_PACING_H
@@ -0,0 +1,575 @@
+#include "../pch.h"
+
+namespace profiler
+{
+
+std::atomic<bool> enabled = false;
+size_t window = 240;
+bool show = true;
+
+////////////////////////////////////////////////////////////////////////////////
+//// INTERNAL STATE
+////////////////////////////////////////////////////////////////////////////////
+
+static std::mutex registry;                      // guards the ring list and thread names
+static std::vector<std::unique_ptr<Ring>> rings; // ring of every thread that opened a zone
+static std::deque<Frame> history;                // rolling window of aggregated frames
+static std::int64_t boundary = 0;                // start of the current frame
+static std::uint64_t frame_index = 0;            // number of the current frame
+
+static bool recording = false;                   // append drained events to the capture
+static std::vector<Event> captured;              // events of the capture session
+static size_t constexpr capture_limit = 1 << 22; // events kept by a capture session
+
+static bool paused = false; // freeze the views on the selected frame
+static int selected = -1;   // frame of the flame view, newest when negative
+
+// timestamp queries of a zone
+struct GpuQuery
+{
+    char const *name;    // zone name
+    std::uint32_t depth; // nesting depth on the gpu timeline
+    GLuint start;        // start timestamp query
+    GLuint stop;         // stop timestamp query, zero while the zone is open
+};
+
+// timestamp queries issued during a frame
+struct GpuPool
+{
+    std::vector<GLuint> queries; // query objects, reused every time the ring comes around
+    size_t used = 0;             // queries issued this frame
+    std::vector<GpuQuery> zones; // zones issued this frame
+    std::uint64_t frame = 0;     // frame that issued the zones
+};
+
+static size_t constexpr gpu_frames = 3;       // query pools in flight
+static std::array<GpuPool, gpu_frames> pools; // ring of query pools
+static size_t pool = 0;                       // pool of the current frame
+static std::uint32_t gpu_depth = 0;           // open gpu zones
+static Ring *gpu_ring = nullptr;              // identifies the gpu timeline
+static std::uint64_t gpu_dropped = 0;         // frames whose queries were not ready
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// milliseconds between two nanosecond timestamps
+static double milliseconds(std::int64_t start, std::int64_t stop)
+{
+    return static_cast<double>(stop - start) / 1e6;
+}
+
+// stable color of a zone name
+static ImU32 zone_color(std::string_view name)
+{
+    size_t const hash = std::hash<std::string_view>{}(name);
+    return ImColor::HSV(static_cast<float>(hash % 360) / 360.0f, 0.45f, 0.85f);
+}
+
+// escape a string for a json document
+static std::string escape(std::string_view text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char const c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped.push_back('\\');
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+// aggregate the zones of a frame by name and timeline
+static void aggregate(Frame &f)
+{
+    f.stats.clear();
+    std::map<std::pair<std::string_view, bool>, size_t> index;
+    for (auto const &e : f.events)
+    {
+        bool const gpu = gpu_ring && e.thread == gpu_ring->thread;
+        auto [it, inserted] = index.try_emplace({e.name, gpu}, f.stats.size());
+        if (inserted)
+            f.stats.push_back({e.name, 0.0, 0.0, 0, gpu});
+        Stat &s = f.stats[it->second];
+        double const duration = milliseconds(e.start, e.stop);
+        s.total += duration;
+        s.max = std::max(s.max, duration);
+        ++s.calls;
+    }
+}
+
+// next free timestamp query of a pool, the pool grows in chunks
+static GLuint query(GpuPool &p)
+{
+    if (p.used == p.queries.size())
+    {
+        size_t const n = p.queries.size();
+        p.queries.resize(n + 64);
+        glGenQueries(64, p.queries.data() + n);
+    }
+    return p.queries[p.used++];
+}
+
+/*F+F***********************************************************************//*!
+\function: resolve
+
+\summary:  read the timestamps of the pool issued gpu_frames - 1 frames ago
+           without blocking, convert them to the cpu clock and append them to
+           the frame that issued them
+
+\args:     p - pool to resolve and recycle
+************************************************************************//*F-F*/
+static void resolve(GpuPool &p)
+{
+    if (!p.zones.empty() && p.used)
+    {
+        // timestamps complete in issue order, the last issued query covers the pool, the last
+        // zone is the innermost one of its nesting and its stop can precede the outer stops
+        GLint available = 0;
+        glGetQueryObjectiv(p.queries[p.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            ++gpu_dropped;
+        else
+        {
+            // offset between the gpu and cpu clocks, both in nanoseconds
+            GLint64 gpu_now = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+            std::int64_t const offset = now() - gpu_now;
+
+            std::vector<Event> events;
+            events.reserve(p.zones.size());
+            for (auto const &z : p.zones)
+            {
+                if (!z.stop)
+                    continue;
+                GLuint64 start = 0;
+                GLuint64 stop = 0;
+                glGetQueryObjectui64v(z.start, GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(z.stop, GL_QUERY_RESULT, &stop);
+                events.push_back({z.name, static_cast<std::int64_t>(start) + offset,
+                                  static_cast<std::int64_t>(stop) + offset, z.depth, gpu_ring->thread});
+            }
+
+            // correlate with the cpu zones of the issuing frame
+            auto f = std::find_if(history.rbegin(), history.rend(), [&](Frame const &h) { return h.index == p.frame; });
+            if (f != history.rend())
+            {
+                f->events.insert(f->events.end(), events.begin(), events.end());
+                aggregate(*f);
+            }
+            if (recording && captured.size() + events.size() <= capture_limit)
+                captured.insert(captured.end(), events.begin(), events.end());
+        }
+    }
+
+    p.used = 0;
+    p.zones.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// RING
+////////////////////////////////////////////////////////////////////////////////
+
+/*M+M***********************************************************************//*!
+\method:   Ring::push
+
+\summary:  append a completed zone, only called by the owning thread
+
+\args:     event - completed zone
+
+\return:   True, if the event was stored
+\return:   False, if the ring was full and the event dropped
+************************************************************************//*M-M*/
+bool Ring::push(Event const &event)
+{
+    std::uint64_t const h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= capacity)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    events[h % capacity] = event;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Ring::drain
+
+\summary:  move every published event to a vector, only called by the frame
+           aggregation
+
+\args:     out - receives the events
+************************************************************************//*M-M*/
+void Ring::drain(std::vector<Event> &out)
+{
+    std::uint64_t const t = tail.load(std::memory_order_relaxed);
+    std::uint64_t const h = head.load(std::memory_order_acquire);
+    for (std::uint64_t i = t; i < h; ++i)
+        out.push_back(events[i % capacity]);
+    tail.store(h, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// RECORDING
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: attach
+
+\summary:  create and register the ring of the calling thread, called once per
+           thread on its first zone
+
+\return:   Ring& - ring of the calling thread
+************************************************************************//*F-F*/
+Ring &attach()
+{
+    std::lock_guard<std::mutex> lock(registry);
+    rings.push_back(std::make_unique<Ring>());
+    Ring &r = *rings.back();
+    r.thread = static_cast<std::uint32_t>(rings.size() - 1);
+    r.name = "thread " + std::to_string(r.thread);
+    return r;
+}
+
+/*F+F***********************************************************************//*!
+\function: name
+
+\summary:  name the calling thread in the flame view and trace export
+
+\args:     thread_name - name of the thread
+************************************************************************//*F-F*/
+void name(std::string thread_name)
+{
+    Ring &r = ring();
+    std::lock_guard<std::mutex> lock(registry);
+    r.name = thread_name;
+}
+
+/*F+F***********************************************************************//*!
+\function: frame
+
+\summary:  close the current frame, drain the zones of every thread and
+           aggregate them into the rolling window, call once per frame from
+           the main thread after the last zone of the frame closed
+
+\modifies: [history, boundary, captured]
+************************************************************************//*F-F*/
+void frame()
+{
+    std::int64_t const stop = now();
+    if (!boundary || !enabled)
+    {
+        boundary = stop;
+        return;
+    }
+
+    Frame f;
+    f.index = frame_index++;
+    f.start = boundary;
+    f.stop = stop;
+    boundary = stop;
+    {
+        std::lock_guard<std::mutex> lock(registry);
+        for (auto &r : rings)
+            r->drain(f.events);
+    }
+
+    std::sort(f.events.begin(), f.events.end(), [](Event const &a, Event const &b) {
+        return std::tie(a.thread, a.start, a.depth) < std::tie(b.thread, b.start, b.depth);
+    });
+
+    aggregate(f);
+
+    if (recording)
+    {
+        if (captured.size() + f.events.size() > capture_limit)
+        {
+            my_log::error("Profiler capture limit reached, capture stopped.");
+            recording = false;
+        }
+        else
+            captured.insert(captured.end(), f.events.begin(), f.events.end());
+    }
+
+    // move the gpu zones to the next pool and resolve the oldest one
+    pools[pool].frame = f.index;
+    pool = (pool + 1) % gpu_frames;
+
+    if (!paused)
+    {
+        history.push_back(std::move(f));
+        while (history.size() > window)
+            history.pop_front();
+    }
+
+    resolve(pools[pool]);
+}
+
+std::deque<Frame> const &frames()
+{
+    return history;
+}
+
+/*F+F***********************************************************************//*!
+\function: capture
+
+\summary:  start or stop a capture session, starting discards the previous
+           session
+
+\args:     record - True to start, False to stop
+************************************************************************//*F-F*/
+void capture(bool record)
+{
+    if (record && !recording)
+        captured.clear();
+    recording = record;
+}
+
+bool capturing()
+{
+    return recording;
+}
+
+/*F+F***********************************************************************//*!
+\function: save
+
+\summary:  export the capture session as chrome trace json, viewable in
+           chrome://tracing or perfetto
+
+\args:     path - output file path
+
+\return:   True, if the trace was written
+\return:   False, otherwise
+************************************************************************//*F-F*/
+bool save(std::string path)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        my_log::error("Unable to open trace file ", path, ".");
+        return false;
+    }
+
+    std::int64_t const base = captured.empty() ? 0 : captured.front().start;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(registry);
+        for (auto const &r : rings)
+        {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << r->thread
+                << ",\"args\":{\"name\":\"" << escape(r->name) << "\"}}";
+            first = false;
+        }
+    }
+
+    // complete events, timestamps and durations in microseconds
+    for (auto const &e : captured)
+    {
+        out << (first ? "" : ",") << "\n{\"name\":\"" << escape(e.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+            << e.thread << ",\"ts\":" << static_cast<double>(e.start - base) / 1e3
+            << ",\"dur\":" << static_cast<double>(e.stop - e.start) / 1e3 << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+
+    return out.good();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// GPU ZONE
+////////////////////////////////////////////////////////////////////////////////
+
+GpuZone::GpuZone(char const *name)
+{
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+
+    if (!gpu_ring)
+    {
+        gpu_ring = &attach();
+        std::lock_guard<std::mutex> lock(registry);
+        gpu_ring->name = "gpu";
+    }
+
+    m_active = true;
+    m_pool = pool;
+    GpuPool &p = pools[m_pool];
+    m_zone = p.zones.size();
+    p.zones.push_back({name, gpu_depth++, query(p), 0});
+    glQueryCounter(p.zones[m_zone].start, GL_TIMESTAMP);
+}
+
+GpuZone::~GpuZone()
+{
+    if (!m_active)
+        return;
+
+    --gpu_depth;
+    GpuPool &p = pools[m_pool];
+    GLuint const stop = query(p);
+    glQueryCounter(stop, GL_TIMESTAMP);
+    p.zones[m_zone].stop = stop;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// INTERFACE
+////////////////////////////////////////////////////////////////////////////////
+
+// flame view of a frame, one band of rows per thread with nested zones below
+static void flame(Frame const &f)
+{
+    // first row of every thread
+    std::map<std::uint32_t, std::uint32_t> rows;
+    std::map<std::uint32_t, std::uint32_t> depths;
+    for (auto const &e : f.events)
+        depths[e.thread] = std::max(depths[e.thread], e.depth + 1);
+    std::uint32_t total = 0;
+    for (auto const &[thread, depth] : depths)
+    {
+        rows[thread] = total;
+        total += depth;
+    }
+
+    if (!ImPlot::BeginPlot("##Flame", ImVec2(-1, 24.0f * std::max(total, 4u) + 40.0f), ImPlotFlags_NoLegend))
+        return;
+    ImPlot::SetupAxes("ms", nullptr, ImPlotAxisFlags_None, ImPlotAxisFlags_Invert | ImPlotAxisFlags_NoTickLabels);
+    ImPlot::SetupAxesLimits(0.0, milliseconds(f.start, f.stop), 0.0, std::max(total, 1u),
+                            paused ? ImPlotCond_Once : ImPlotCond_Always);
+    ImPlot::SetupFinish();
+
+    ImDrawList *draw = ImPlot::GetPlotDrawList();
+    ImVec2 const mouse = ImGui::GetMousePos();
+    ImPlot::PushPlotClipRect();
+    for (auto const &e : f.events)
+    {
+        double const row = rows[e.thread] + e.depth;
+        ImVec2 const a = ImPlot::PlotToPixels(milliseconds(f.start, e.start), row);
+        ImVec2 const b = ImPlot::PlotToPixels(milliseconds(f.start, e.stop), row + 1.0);
+        ImVec2 const min(std::min(a.x, b.x), std::min(a.y, b.y) + 1.0f);
+        ImVec2 const max(std::max(a.x, b.x), std::max(a.y, b.y) - 1.0f);
+
+        draw->AddRectFilled(min, max, zone_color(e.name));
+        // label zones wide enough to hold their name
+        if (max.x - min.x > ImGui::CalcTextSize(e.name).x + 4.0f)
+            draw->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32(0, 0, 0, 255), e.name);
+        if (ImPlot::IsPlotHovered() && mouse.x >= min.x && mouse.x <= max.x && mouse.y >= min.y && mouse.y <= max.y)
+            ImGui::SetTooltip("%s\n%.3f ms", e.name, milliseconds(e.start, e.stop));
+    }
+    ImPlot::PopPlotClipRect();
+    ImPlot::EndPlot();
+}
+
+/*F+F***********************************************************************//*!
+\function: interface
+
+\summary:  draw the frame timeline, the flame view of a selected frame and the
+           zone statistics averaged over the rolling window
+************************************************************************//*F-F*/
+void interface()
+{
+    if (!show)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640, 560), ImGuiCond_Once);
+    ImGui::Begin("Profiler", &show);
+
+    // frame times of the rolling window
+    std::vector<double> times;
+    times.reserve(history.size());
+    for (auto const &f : history)
+        times.push_back(milliseconds(f.start, f.stop));
+    double const average = times.empty() ? 0.0 : std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    double const peak = times.empty() ? 0.0 : *std::max_element(times.begin(), times.end());
+
+    ImGui::Text("Frame %.3f ms average, %.3f ms peak over %zu frames", average, peak, times.size());
+    if (gpu_dropped)
+        ImGui::Text("%llu frames of gpu zones not ready in time", static_cast<unsigned long long>(gpu_dropped));
+    ImGui::Checkbox("Pause", &paused);
+    ImGui::SameLine();
+    if (ImGui::Button(recording ? "Stop Capture" : "Start Capture"))
+        capture(!recording);
+    ImGui::SameLine();
+    ImGui::BeginDisabled(recording || captured.empty());
+    if (ImGui::Button("Save Trace"))
+        save("trace.json");
+    ImGui::EndDisabled();
+    if (recording)
+    {
+        ImGui::SameLine();
+        ImGui::Text("%zu events", captured.size());
+    }
+
+    if (ImPlot::BeginPlot("##Frames", ImVec2(-1, 140), ImPlotFlags_NoLegend))
+    {
+        ImPlot::SetupAxes(nullptr, "ms", ImPlotAxisFlags_NoTickLabels, ImPlotAxisFlags_AutoFit);
+        ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, static_cast<double>(window), ImPlotCond_Always);
+        ImPlot::SetupFinish();
+        ImPlot::PlotShaded("##frame", times.data(), static_cast<int>(times.size()));
+        ImPlot::PlotLine("##frame", times.data(), static_cast<int>(times.size()));
+        if (selected >= 0)
+        {
+            double const x = selected;
+            ImPlot::PlotInfLines("##selected", &x, 1);
+        }
+        // select the frame shown in the flame view
+        if (ImPlot::IsPlotHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+        {
+            selected = static_cast<int>(std::round(ImPlot::GetPlotMousePos().x));
+            paused = true;
+        }
+        ImPlot::EndPlot();
+    }
+    if (!paused)
+        selected = -1;
+
+    if (!history.empty())
+    {
+        size_t const f = selected < 0 ? history.size() - 1 : std::min<size_t>(selected, history.size() - 1);
+        flame(history[f]);
+    }
+
+    // zone statistics averaged over the window
+    std::map<std::pair<std::string_view, bool>, Stat> stats;
+    for (auto const &f : history)
+        for (auto const &s : f.stats)
+        {
+            Stat &total = stats[{s.name, s.gpu}];
+            total.name = s.name;
+            total.gpu = s.gpu;
+            total.total += s.total;
+            total.max = std::max(total.max, s.max);
+            total.calls += s.calls;
+        }
+
+    if (ImGui::BeginTable("##Zones", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+    {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("ms / frame");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableSetupColumn("calls / frame");
+        ImGui::TableHeadersRow();
+        double const n = std::max<double>(history.size(), 1.0);
+        for (auto const &[key, s] : stats)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s%.*s", s.gpu ? "[gpu] " : "", static_cast<int>(s.name.size()), s.name.data());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.total / n);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.max);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", s.calls / n);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+} // namespace profiler
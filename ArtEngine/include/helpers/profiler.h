@@ -0,0 +1,209 @@
+/*+*************************************************************************//*!
+\file:      profiler.h
+
+\summary:   hierarchical cpu profiler, scoped zones are recorded into lock-free
+            per-thread rings and aggregated once per frame into a rolling
+            window drawn as a timeline and flame view, captured sessions can
+            be exported as chrome trace json
+
+            gpu zones place timestamp queries around passes, the results are
+            read back without blocking a few frames later and shown on the
+            cpu timeline as their own thread
+
+\structs:   Event
+            Ring
+            Stat
+            Frame
+
+\classes:   Zone
+            GpuZone
+
+\functions: now\n
+            attach\n
+            ring\n
+            name\n
+            frame\n
+            frames\n
+            capture\n
+            capturing\n
+            save\n
+            interface\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_PROFILER_H
+#define ARTENGINE_PROFILER_H
+
+// scoped zone named by a string literal, compiled out with ARTENGINE_NO_PROFILER
+#define ART_PROFILE_CONCAT_(a, b) a##b
+#define ART_PROFILE_CONCAT(a, b) ART_PROFILE_CONCAT_(a, b)
+#ifndef ARTENGINE_NO_PROFILER
+#define ART_PROFILE(name) profiler::Zone ART_PROFILE_CONCAT(profiler_zone_, __LINE__)(name)
+#define ART_PROFILE_GPU(name) profiler::GpuZone ART_PROFILE_CONCAT(profiler_gpu_zone_, __LINE__)(name)
+#else
+#define ART_PROFILE(name)
+#define ART_PROFILE_GPU(name)
+#endif
+
+namespace profiler
+{
+
+// completed zone
+struct Event
+{
+    char const *name;     //!< zone name (string literal)
+    std::int64_t start;   //!< start time in nanoseconds
+    std::int64_t stop;    //!< stop time in nanoseconds
+    std::uint32_t depth;  //!< nesting depth on its thread
+    std::uint32_t thread; //!< profiler thread id
+};
+
+/*S+S***********************************************************************//*!
+\struct:   Ring
+
+\summary:  single producer, single consumer ring of completed zones, written
+           by its owning thread and drained by the frame aggregation
+
+\methods:  push - append an event, dropped when the ring is full\n
+        :  drain - move every available event to a vector\n
+************************************************************************//*S-S*/
+struct Ring
+{
+    static size_t constexpr capacity = 1 << 14; //!< events held between two frames
+
+    bool push(Event const &event);
+    void drain(std::vector<Event> &events);
+
+    std::array<Event, capacity> events;    //!< event storage
+    std::atomic<std::uint64_t> head{0};    //!< next event written (producer)
+    std::atomic<std::uint64_t> tail{0};    //!< next event read (consumer)
+    std::atomic<std::uint64_t> dropped{0}; //!< events lost to a full ring
+    std::uint32_t thread = 0;              //!< profiler thread id
+    std::uint32_t depth = 0;               //!< open zones of the owner
+    std::string name;                      //!< thread name for the views
+};
+
+// aggregated zone of a frame
+struct Stat
+{
+    std::string_view name; //!< zone name
+    double total = 0.0;    //!< summed duration in milliseconds
+    double max = 0.0;      //!< longest call in milliseconds
+    int calls = 0;         //!< number of calls
+    bool gpu = false;      //!< measured on the gpu timeline
+};
+
+// events and statistics of a frame
+struct Frame
+{
+    std::uint64_t index = 0;   //!< frame number
+    std::int64_t start = 0;    //!< frame start in nanoseconds
+    std::int64_t stop = 0;     //!< frame stop in nanoseconds
+    std::vector<Event> events; //!< zones, sorted by thread and start
+    std::vector<Stat> stats;   //!< zones aggregated by name
+};
+
+extern std::atomic<bool> enabled; //!< record zones
+extern size_t window;             //!< frames kept in the rolling window
+extern bool show;                 //!< draw the profiler interface
+
+// monotonic time in nanoseconds
+inline std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+Ring &attach();
+
+inline thread_local Ring *local = nullptr; //!< ring of the calling thread
+
+inline Ring &ring()
+{
+    if (!local)
+        local = &attach();
+    return *local;
+}
+
+void name(std::string thread_name);
+void frame();
+std::deque<Frame> const &frames();
+void capture(bool record);
+[[nodiscard]] bool capturing();
+bool save(std::string path);
+void interface();
+
+/*C+C***********************************************************************//*!
+\class:    Zone
+
+\summary:  measure the execution time between the creation and destruction of
+           the object as a nested zone of the calling thread
+
+\methods:  Zone - Constructor, opens the zone\n
+        :  ~Zone - Destructor, closes and records the zone\n
+************************************************************************//*C-C*/
+class Zone
+{
+  public:
+    explicit Zone(char const *name)
+        : m_name(name)
+    {
+        if (!enabled.load(std::memory_order_relaxed))
+            return;
+        m_ring = &ring();
+        m_depth = m_ring->depth++;
+        m_start = now();
+    }
+
+    ~Zone()
+    {
+        if (!m_ring)
+            return;
+        std::int64_t const stop = now();
+        --m_ring->depth;
+        m_ring->push({m_name, m_start, stop, m_depth, m_ring->thread});
+    }
+
+    Zone(Zone const &) = delete;
+    Zone &operator=(Zone const &) = delete;
+
+  private:
+    char const *m_name;     //!< zone name
+    Ring *m_ring = nullptr; //!< ring of the opening thread, null when disabled
+    std::int64_t m_start;   //!< start time in nanoseconds
+    std::uint32_t m_depth;  //!< nesting depth
+
+}; // class Zone
+
+/*C+C***********************************************************************//*!
+\class:    GpuZone
+
+\summary:  measure the gpu execution time of the commands issued between the
+           creation and destruction of the object with timestamp queries,
+           only used on the thread owning the gl context
+
+\methods:  GpuZone - Constructor, queries the start timestamp\n
+        :  ~GpuZone - Destructor, queries the stop timestamp\n
+************************************************************************//*C-C*/
+class GpuZone
+{
+  public:
+    explicit GpuZone(char const *name);
+    ~GpuZone();
+
+    GpuZone(GpuZone const &) = delete;
+    GpuZone &operator=(GpuZone const &) = delete;
+
+  private:
+    bool m_active = false; //!< zone recorded, false when disabled
+    size_t m_pool;         //!< query pool of the issuing frame
+    size_t m_zone;         //!< zone within the pool
+
+}; // class GpuZone
+
+} // namespace profiler
+
+#endif // ARTENGINE_PROFILER_H
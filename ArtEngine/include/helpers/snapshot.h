@@ -0,0 +1,132 @@
+/*+*************************************************************************//*!
+\file:      snapshot.h
+
+\summary:   double-buffered state handed from one thread to another, the
+            writer copies into the buffer the reader is not using and flips
+            it to the front, the reader always sees the latest complete copy
+            and neither side waits for the other to finish its work
+
+\classes:   Snapshot
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_SNAPSHOT_H
+#define ARTENGINE_SNAPSHOT_H
+
+/*C+C***********************************************************************//*!
+\class:    Snapshot
+
+\summary:  two copies of a state, a single writer publishes into the back
+           buffer and a single reader holds the front buffer between acquire
+           and release, a publish that would overwrite the buffer still being
+           read is skipped, the writer publishes again on its next tick
+
+\methods:  publish - copy a state into the back buffer and flip it to the front\n
+        :  acquire - hold the latest published state\n
+        :  release - let the writer reuse the held state\n
+        :  stamp - accessor to get when the held state was published\n
+        :  published - accessor to get the number of published states\n
+        :  skipped - accessor to get the number of skipped publishes\n
+************************************************************************//*C-C*/
+template <typename T>
+class Snapshot
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Snapshot(T const &initial = T()) : m_buffers{initial, initial}, m_stamps{Clock::now(), Clock::now()}
+    {
+    }
+
+    Snapshot(Snapshot const &) = delete;
+    Snapshot &operator=(Snapshot const &) = delete;
+
+    /*M+M*******************************************************************//*!
+    \method:   publish
+
+    \summary:  copy a state into the buffer that is neither in front nor read,
+               the copy happens outside of the lock
+
+    \args:     state - latest state of the writer
+    \args:     stamp - time the state belongs to
+
+    \return:   bool - false if the reader still holds the back buffer
+    ********************************************************************//*M-M*/
+    bool publish(T const &state, Clock::time_point stamp = Clock::now())
+    {
+        int back;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            back = 1 - m_front;
+            if (back == m_reading)
+            {
+                ++m_skipped;
+                return false;
+            }
+        }
+
+        // the reader only takes the front buffer, the back one is ours until the flip
+        m_buffers[back] = state;
+        m_stamps[back] = stamp;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_front = back;
+        ++m_published;
+        return true;
+    }
+
+    /*M+M*******************************************************************//*!
+    \method:   acquire
+
+    \summary:  hold the front buffer, it stays valid until release even if the
+               writer publishes newer states in the meantime
+
+    \return:   T const & - latest published state
+    ********************************************************************//*M-M*/
+    T const &acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_reading = m_front;
+        return m_buffers[m_reading];
+    }
+
+    // let the writer reuse the buffer returned by acquire
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_reading = -1;
+    }
+
+    // time the held state was published with, only valid between acquire and release
+    [[nodiscard]] Clock::time_point stamp() const
+    {
+        return m_stamps[m_reading];
+    }
+
+    [[nodiscard]] size_t published() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_published;
+    }
+
+    [[nodiscard]] size_t skipped() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_skipped;
+    }
+
+  private:
+    std::array<T, 2> m_buffers;                //!< front and back copies
+    std::array<Clock::time_point, 2> m_stamps; //!< publish time of each copy
+    mutable std::mutex m_mutex;                //!< guards the indices and counters, never the copies
+    int m_front = 0;                           //!< latest complete copy
+    int m_reading = -1;                        //!< copy held by the reader, -1 if none
+    size_t m_published = 0;                    //!< states flipped to the front
+    size_t m_skipped = 0;                      //!< publishes dropped while the back copy was read
+
+}; // class Snapshot
+
+#endif // ARTENGINE_SNAPSHOT_H
@@ -0,0 +1,258 @@
+#include "../pch.h"
+
+namespace timer
+{
+
+/*F+F***********************************************************************//*!
+\function: scheduler
+
+\summary:  shared scheduler of every timer, created on first use
+
+\return:   Scheduler& - the scheduler
+************************************************************************//*F-F*/
+Scheduler &scheduler()
+{
+    static Scheduler instance;
+    return instance;
+}
+
+static thread_local Control const *executing = nullptr; // task whose function runs on this thread
+
+/*M+M***********************************************************************//*!
+\method:   Task::wait
+
+\summary:  block until no execution of the task is in progress, an execution
+           calling this on its own thread is not waited for, cancel first or
+           a periodic task keeps starting new executions
+************************************************************************//*M-M*/
+void Task::wait()
+{
+    if (!m_control)
+        return;
+
+    int const own = executing == m_control.get() ? 1 : 0;
+    std::unique_lock<std::mutex> lock(m_control->mutex);
+    m_control->idle.wait(lock, [&] { return m_control->running <= own; });
+}
+
+Scheduler::~Scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+/*M+M***********************************************************************//*!
+\method:   Scheduler::schedule
+
+\summary:  execute a function at a deadline, and periodically if a period is
+           given, the scheduler thread starts on the first call
+
+\args:     deadline - first execution
+\args:     period - interval after an execution, empty to execute once
+\args:     fixed - advance deadlines by the period instead of restarting the
+                   period after each execution
+\args:     function - function to execute
+\args:     dispatch - execute on the dispatcher when one is set
+
+\modifies: [m_queue, m_thread]
+
+\return:   Task - cancellation handle
+************************************************************************//*M-M*/
+Task Scheduler::schedule(clock::time_point deadline, Period period, bool fixed, std::function<void()> function,
+                         bool dispatch)
+{
+    auto control = std::make_shared<Control>();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push({deadline, std::move(period), fixed, dispatch, std::move(function), control});
+        if (!m_thread.joinable())
+            m_thread = std::thread(&Scheduler::run, this);
+    }
+    m_wake.notify_one(); // the new entry may be the earliest
+    return Task(control);
+}
+
+// due functions marked for dispatch run through this function, e.g. a worker pool
+void Scheduler::dispatcher(Dispatch dispatch)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dispatch = std::move(dispatch);
+}
+
+/*M+M***********************************************************************//*!
+\method:   Scheduler::hybrid
+
+\summary:  sleep until shortly before a deadline and spin the rest, the spin
+           window covers the measured sleep overshoot
+
+\args:     spin - True to enable spinning, False to only sleep
+
+\modifies: [m_spin]
+************************************************************************//*M-M*/
+void Scheduler::hybrid(bool spin)
+{
+    std::chrono::nanoseconds window{0};
+    if (spin)
+    {
+        Resolution const r = measure(20);
+        window = std::max(2 * r.overshoot, std::chrono::nanoseconds(std::chrono::microseconds(200)));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_spin = window;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Scheduler::measure
+
+\summary:  measure the clock step and the sleep overshoot of the platform and
+           report them with the wakeup lateness observed by the scheduler
+
+\args:     samples - number of measurements
+
+\return:   Resolution - measured precision
+************************************************************************//*M-M*/
+Resolution Scheduler::measure(int samples)
+{
+    Resolution r;
+
+    // smallest nonzero step between consecutive clock reads
+    r.tick = std::chrono::nanoseconds::max();
+    for (int i = 0; i < samples; ++i)
+    {
+        auto const start = clock::now();
+        auto stop = clock::now();
+        while (stop == start)
+            stop = clock::now();
+        r.tick = std::min(r.tick, std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start));
+    }
+
+    // oversleep of a short sleep
+    std::chrono::nanoseconds const request = std::chrono::microseconds(100);
+    std::chrono::nanoseconds overshoot{0};
+    for (int i = 0; i < samples; ++i)
+    {
+        auto const start = clock::now();
+        std::this_thread::sleep_for(request);
+        overshoot += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start) - request;
+    }
+    r.overshoot = overshoot / std::max(samples, 1);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        r.lateness = m_wakeups ? m_late / static_cast<std::int64_t>(m_wakeups) : std::chrono::nanoseconds(0);
+        r.worst = m_worst;
+    }
+
+    my_log::out("Timer resolution: clock ", r.tick.count(), " ns, sleep overshoot ", r.overshoot.count(),
+                " ns, wakeup lateness ", r.lateness.count(), " ns (worst ", r.worst.count(), " ns)");
+    return r;
+}
+
+/*M+M***********************************************************************//*!
+\method:   Scheduler::run
+
+\summary:  scheduler thread, waits for the earliest deadline, executes or
+           dispatches the due entry and reschedules periodic entries
+
+\modifies: [m_queue, m_late, m_worst, m_wakeups]
+************************************************************************//*M-M*/
+void Scheduler::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_quit)
+    {
+        if (m_queue.empty())
+        {
+            m_wake.wait(lock);
+            continue;
+        }
+
+        // cancelled entries are discarded without waiting for their deadline
+        if (!m_queue.top().control->alive.load())
+        {
+            m_queue.pop();
+            continue;
+        }
+
+        clock::time_point const deadline = m_queue.top().deadline;
+        clock::time_point now = clock::now();
+        if (now + m_spin < deadline)
+        {
+            // an earlier entry or shutdown wakes the thread before the deadline
+            m_wake.wait_until(lock, deadline - m_spin);
+            continue;
+        }
+        if (now < deadline)
+        {
+            lock.unlock();
+            while (clock::now() < deadline)
+                std::this_thread::yield();
+            lock.lock();
+            continue; // the queue may have changed while spinning
+        }
+
+        Entry entry = m_queue.top();
+        m_queue.pop();
+
+        std::chrono::nanoseconds const late = std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline);
+        m_late += late;
+        m_worst = std::max(m_worst, late);
+        ++m_wakeups;
+
+        Dispatch dispatch = entry.dispatch ? m_dispatch : Dispatch();
+        lock.unlock();
+        bool started;
+        {
+            // a task stopped since the pop is skipped, otherwise Task::wait sees the execution
+            std::lock_guard<std::mutex> guard(entry.control->mutex);
+            started = entry.control->alive.load();
+            if (started)
+                ++entry.control->running;
+        }
+        if (started)
+        {
+            auto execute = [control = entry.control, function = entry.function] {
+                Control const *previous = executing;
+                executing = control.get();
+                function();
+                executing = previous;
+
+                std::lock_guard<std::mutex> guard(control->mutex);
+                --control->running;
+                control->idle.notify_all();
+            };
+            if (dispatch)
+                dispatch(execute);
+            else
+                execute();
+        }
+        lock.lock();
+
+        if (!started || !entry.period || !entry.control->alive.load())
+        {
+            entry.control->alive.store(false);
+            continue;
+        }
+
+        // reschedule, a fixed interval skips periods it fell behind on instead of bursting
+        std::chrono::nanoseconds const period = std::max(entry.period(), std::chrono::nanoseconds(1));
+        now = clock::now();
+        if (entry.fixed)
+        {
+            entry.deadline += period;
+            if (entry.deadline <= now)
+                entry.deadline += ((now - entry.deadline) / period + 1) * period;
+        }
+        else
+            entry.deadline = now + period;
+        m_queue.push(std::move(entry));
+    }
+}
+
+} // namespace timer
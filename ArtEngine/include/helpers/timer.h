@@ -1,12 +1,22 @@
 /*+*************************************************************************//*!
 \file:      timer.h
 
-\summary:   benchmark / measure execution time or provide intervals
+\summary:   benchmark / measure execution time or provide intervals, every
+            timer shares a single deadline-ordered scheduler thread
 
 \struct:    measure
-\classes:   Timer
+            Resolution
+\classes:   Task
+            Scheduler
+            Timer
 
 \functions: benchmark\n
+            scheduler\n
+            Task::cancel\n
+            Scheduler::schedule\n
+            Scheduler::dispatcher\n
+            Scheduler::hybrid\n
+            Scheduler::measure\n
             Timer::set_timeout\n
             Timer::set_interval\n
             Timer::set_const_interval\n
@@ -42,7 +52,7 @@ float benchmark(F function, Args &&...args, bool output = true)
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<D>(stop - start);
     if (output)
-        std::cout << "Execution Time: " << duration.count() << std::endl;
+        my_log::out("Execution Time: ", duration.count());
     return static_cast<float>(duration.count());
 }
 
@@ -81,7 +91,7 @@ struct measure
     {
         stop = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<D>(stop - start);
-        std::cout << "Execution Time: " << duration.count() << std::endl;
+        my_log::out("Execution Time: ", duration.count());
     }
 
     std::chrono::time_point<std::chrono::high_resolution_clock> start; //!< start measuring execution time
@@ -89,20 +99,149 @@ struct measure
 
 }; // struct measure
 
+////////////////////////////////////////////////////////////////////////////////
+//// SCHEDULER
+////////////////////////////////////////////////////////////////////////////////
+
+using clock = std::chrono::steady_clock;
+
+// measured timing precision of the platform
+struct Resolution
+{
+    std::chrono::nanoseconds tick{0};      //!< smallest observable clock step
+    std::chrono::nanoseconds overshoot{0}; //!< mean oversleep of a short sleep_for
+    std::chrono::nanoseconds lateness{0};  //!< mean wakeup lateness of the scheduler
+    std::chrono::nanoseconds worst{0};     //!< worst wakeup lateness of the scheduler
+};
+
+// shared state of a scheduled function, the scheduler counts its executions in progress
+struct Control
+{
+    std::atomic<bool> alive{true}; //!< cleared by Task::cancel
+    std::mutex mutex;              //!< guards running and the alive check before an execution
+    std::condition_variable idle;  //!< signaled when an execution returns
+    int running = 0;               //!< executions in progress, dispatched ones included
+};
+
+/*C+C***********************************************************************//*!
+\class:    Task
+
+\summary:  cancellation handle of a scheduled function, copies share the task
+
+\methods:  cancel - stop future executions, a running execution completes\n
+        :  wait - block until no execution is in progress\n
+        :  active - the task will still execute\n
+************************************************************************//*C-C*/
+class Task
+{
+  public:
+    Task() = default;
+    explicit Task(std::shared_ptr<Control> control)
+        : m_control(std::move(control))
+    {
+    }
+
+    void cancel()
+    {
+        if (m_control)
+            m_control->alive.store(false);
+    }
+
+    void wait();
+
+    [[nodiscard]] bool active() const
+    {
+        return m_control && m_control->alive.load();
+    }
+
+  private:
+    std::shared_ptr<Control> m_control; //!< shared with the scheduler entry
+
+}; // class Task
+
+/*C+C***********************************************************************//*!
+\class:    Scheduler
+
+\summary:  single thread executing functions at deadlines kept in a min-heap,
+           the thread sleeps on a condition variable until the earliest
+           deadline and optionally spins the last stretch for precision
+
+\methods:  schedule - execute a function once or periodically\n
+        :  dispatcher - run due functions on a worker pool instead\n
+        :  hybrid - enable sleeping followed by spinning up to the deadline\n
+        :  measure - measure and report the timer resolution\n
+************************************************************************//*C-C*/
+class Scheduler
+{
+  public:
+    using Period = std::function<std::chrono::nanoseconds()>;
+    using Dispatch = std::function<void(std::function<void()>)>;
+
+    ~Scheduler();
+
+    Task schedule(clock::time_point deadline, Period period, bool fixed, std::function<void()> function,
+                  bool dispatch = false);
+
+    void dispatcher(Dispatch dispatch);
+    void hybrid(bool spin);
+    Resolution measure(int samples = 100);
+
+  private:
+    // scheduled function
+    struct Entry
+    {
+        clock::time_point deadline;       //!< next execution
+        Period period;                    //!< interval, empty for a single execution
+        bool fixed;                       //!< advance the deadline by the period (no drift)
+        bool dispatch;                    //!< run on the dispatcher when one is set
+        std::function<void()> function;   //!< scheduled function
+        std::shared_ptr<Control> control; //!< cancellation and executions in progress
+
+        bool operator>(Entry const &other) const
+        {
+            return deadline > other.deadline;
+        }
+    };
+
+    void run();
+
+    std::mutex m_mutex;             //!< guards the queue and settings
+    std::condition_variable m_wake; //!< wakes the thread for an earlier deadline
+    // entries ordered by deadline, earliest on top
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> m_queue;
+    std::thread m_thread;                //!< scheduler thread, started on first use
+    bool m_quit = false;                 //!< stop the thread
+    Dispatch m_dispatch;                 //!< optional worker pool dispatch
+    std::chrono::nanoseconds m_spin{0};  //!< spin this long before a deadline
+    std::chrono::nanoseconds m_late{0};  //!< summed wakeup lateness
+    std::chrono::nanoseconds m_worst{0}; //!< worst wakeup lateness
+    size_t m_wakeups = 0;                //!< executed entries
+
+}; // class Scheduler
+
+Scheduler &scheduler();
+
 /*C+C***********************************************************************//*!
 \class:    Timer
 
-\summary:  execute function after a duration or on intervals in another thread
+\summary:  execute function after a duration or on intervals on the shared
+           scheduler thread
 
 \methods:  set_timeout - execute a function with a timeout\n
         :  set_interval - execute a function on an interval\n
         :  set_const_interval - execute a function on a constant interval\n
+        :  dispatch - execute on the scheduler's worker pool dispatch\n
         :  stop - stop the timer
 ************************************************************************//*C-C*/
 template <typename D>
 class Timer
 {
   public:
+    ~Timer()
+    {
+        stop();
+    }
+
     /*M+M*******************************************************************//*!
     \method:   Timer::set_timeout
 
@@ -111,97 +250,86 @@ class Timer
     \args:     duration - time before executing the function
     \args:     function - function to execute
 
-    \modifies: [active, thread].
+    \modifies: [task].
     ********************************************************************//*M-M*/
     template <typename F>
     void set_timeout(D duration, F function)
     {
-        active = true;
-        thread = std::thread([=]() {
-            std::this_thread::sleep_for(duration);
-            // thread terminated before function execution
-            if (!active)
-                return;
-            function();
-            return;
-        });
-        thread.detach();
+        stop();
+        task = scheduler().schedule(clock::now() + duration, {}, false, function, dispatched);
     }
 
     /*M+M*******************************************************************//*!
     \method:   Timer::set_interval
 
-    \summary:  execute a function on a set interval
+    \summary:  execute a function on a set interval, the interval starts after
+               every execution
 
     \args:     duration - pointer to time before executing the function
     \args:     function - function to execute
     \args:     args - specified function arguments
 
-    \modifies: [active, thread].
+    \modifies: [task].
     ********************************************************************//*M-M*/
     template <typename F, typename... Args>
     void set_interval(D *duration, F function, Args &&...args)
     {
-        active = true;
-        thread = std::thread([=]() {
-            while (active)
-            {
-                std::this_thread::sleep_for(*duration);
-                function(args...);
-            }
-            return;
-        });
-        thread.detach();
+        stop();
+        task = scheduler().schedule(
+            clock::now() + *duration, [duration] { return std::chrono::nanoseconds(*duration); }, false,
+            [=]() { function(args...); }, dispatched);
     }
 
     /*M+M*******************************************************************//*!
     \method:   Timer::set_const_interval
 
-    \summary:  execute a function on a set constant interval
+    \summary:  execute a function on a set constant interval, deadlines advance
+               by the interval regardless of the execution time
 
     \args:     duration - pointer to time before executing the function
     \args:     function - function to execute
     \args:     args - specified function arguments
 
-    \modifies: [active, thread, delay_time].
+    \modifies: [task].
     ********************************************************************//*M-M*/
     template <typename F, typename... Args>
     void set_const_interval(D *duration, F function, Args &&...args)
     {
-        active = true;
-        thread = std::thread([=]() {
-            while (active)
-            {
-                std::this_thread::sleep_for(*duration - delay_time);
-                curr_time = std::chrono::high_resolution_clock::now();
-                function(args...);
-                delay_time = std::chrono::duration_cast<D>(std::chrono::high_resolution_clock::now() - curr_time);
-            }
-            return;
-        });
-        thread.detach();
+        stop();
+        task = scheduler().schedule(
+            clock::now() + *duration, [duration] { return std::chrono::nanoseconds(*duration); }, true,
+            [=]() { function(args...); }, dispatched);
+    }
+
+    // execute the following timers on the scheduler's dispatcher
+    void dispatch(bool use_dispatcher)
+    {
+        dispatched = use_dispatcher;
     }
 
     /*M+M*******************************************************************//*!
     \method:   Timer::stop
 
-    \summary:  stop the process
+    \summary:  stop the process and wait for an execution in progress, so the
+               timer and the state its function captured outlive it, from
+               within the function itself it only cancels
 
-    \modifies: [active, thread]]
+    \modifies: [task]
     ********************************************************************//*M-M*/
     void stop()
     {
-        // stop the process and join the thread
-        active = false;
-        if (thread.joinable())
-            thread.join();
+        task.cancel();
+        task.wait();
+    }
+
+    [[nodiscard]] bool active() const
+    {
+        return task.active();
     }
 
   private:
-    std::atomic<bool> active = false;                                      //!< finish the timer
-    std::chrono::time_point<std::chrono::high_resolution_clock> curr_time; //!< track execution time
-    D delay_time = D(0);                                                   //!< delay time for a constant interval
-    std::thread thread;                                                    //!< thread for the timer
+    Task task;               //!< cancellation handle of the scheduled function
+    bool dispatched = false; //!< execute on the scheduler's dispatcher
 
 }; // class Timer
 
@@ -0,0 +1,358 @@
+#include "../pch.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace watch
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//// INTERNAL STATE
+////////////////////////////////////////////////////////////////////////////////
+
+// registered asset, snapshot of everything the watcher needs to rebuild it
+struct Asset
+{
+    size_t serial = 0;                     // registration, guards against reused addresses
+    ShaderBase *shader = nullptr;          // shader to rebuild, or
+    Model *model = nullptr;                // model to re-parse
+    std::vector<ShaderBase::Stage> stages; // stages of the shader
+    Defines defines;                       // permutation of the shader
+    std::string name;                      // obj path of the model without extension
+    glm::vec3 color{0.0f};                 // color of the model until a material is selected
+    Handle reloaded;                       // called after the model was swapped
+    std::unordered_set<std::string> files; // files the asset is built from
+};
+
+static std::mutex mutex;                               // guards the registry and the watches
+static std::unordered_map<void const *, Asset> assets; // registered assets
+static std::atomic<bool> registered = false;           // an asset was ever registered
+static size_t next = 0;                                // serial of the next registration
+static std::atomic<bool> active = false;               // watcher keeps running
+static std::thread watcher;                            // background watcher
+#ifdef __linux__
+static int descriptor = -1;                              // inotify instance
+static std::unordered_map<int, std::string> directories; // watched directories by watch descriptor
+static std::unordered_set<std::string> watched;          // watched directories
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// normalized path, the same key the shader preprocessor uses
+static std::string normal(std::filesystem::path const &path)
+{
+    return path.lexically_normal().string();
+}
+
+// files a shader is built from, its stages and everything they include
+static void shader_files(Asset &asset)
+{
+    asset.files.clear();
+    for (auto const &stage : asset.stages)
+        for (auto const &file : stage.files)
+            asset.files.insert(file);
+}
+
+// watch the directories of the asset files, editors replace files by renaming so
+// the directories are watched instead of the files, called with the registry locked
+static void watch_directories(Asset const &asset)
+{
+#ifdef __linux__
+    for (auto const &file : asset.files)
+    {
+        std::string const directory = std::filesystem::path(file).parent_path().string();
+        if (!watched.insert(directory).second)
+            continue;
+
+        int const wd = inotify_add_watch(descriptor, directory.empty() ? "." : directory.c_str(),
+                                         IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+            my_log::error("Unable to watch directory \"", directory, "\".");
+        else
+            directories[wd] = directory;
+    }
+#endif
+}
+
+// add an asset to the registry, starts the watcher with the first asset
+static void add(void const *key, Asset &&asset)
+{
+    start();
+    if (!running())
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    asset.serial = next++;
+    watch_directories(asset);
+    assets[key] = std::move(asset);
+    registered.store(true, std::memory_order_relaxed);
+}
+
+// registered asset by key, null if it was forgotten or replaced since the serial was taken
+static Asset *lookup(void const *key, size_t serial)
+{
+    auto it = assets.find(key);
+    return it != assets.end() && it->second.serial == serial ? &it->second : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// RELOADING
+////////////////////////////////////////////////////////////////////////////////
+
+// expand the shader sources on the watcher, compile and swap on the main thread
+static void rebuild(void const *key, Asset const &asset)
+{
+    std::vector<ShaderBase::Stage> stages = asset.stages;
+    for (auto &stage : stages)
+    {
+        ShaderBase::Source source = ShaderBase::preprocess(stage.file, asset.defines);
+        if (source.text.empty())
+        {
+            my_log::error("Reload of \"", stage.file, "\" failed, keeping the previous program.");
+            return;
+        }
+        stage.source = std::move(source.text);
+        stage.files = std::move(source.files);
+    }
+
+    job::on_main([key, serial = asset.serial, stages = std::move(stages)] {
+        ShaderBase *shader;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Asset const *current = lookup(key, serial);
+            if (!current)
+                return;
+            shader = current->shader;
+        }
+
+        if (!shader->reload(stages))
+        {
+            my_log::error("Reload of \"", stages[0].file, "\" failed, keeping the previous program.");
+            return;
+        }
+        my_log::out("Reloaded \"", stages[0].file, "\".");
+
+        // includes may have changed, watch the files of the new program
+        std::lock_guard<std::mutex> lock(mutex);
+        if (Asset *current = lookup(key, serial))
+        {
+            current->stages = shader->stages();
+            shader_files(*current);
+            watch_directories(*current);
+        }
+    });
+}
+
+// parse and simplify the obj on the watcher, upload and swap on the main thread
+static void reparse(void const *key, Asset const &asset)
+{
+    auto mesh = std::make_shared<object::Mesh>();
+    if (!object::prepare(asset.name, *mesh, asset.color))
+    {
+        my_log::error("Reload of \"", asset.name, ".obj\" failed, keeping the previous model.");
+        return;
+    }
+
+    job::on_main([key, serial = asset.serial, mesh] {
+        Model *model;
+        Handle reloaded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Asset const *current = lookup(key, serial);
+            if (!current)
+                return;
+            model = current->model;
+            reloaded = current->reloaded;
+        }
+
+        object::replace(model, *mesh);
+        my_log::out("Reloaded \"", mesh->name, ".obj\".");
+
+        // batches, culling and anything else built from the model copied the old geometry
+        if (reloaded)
+            reloaded();
+    });
+}
+
+// rebuild every asset built from one of the changed files
+static void reload(std::unordered_set<std::string> const &changed)
+{
+    // snapshot the affected assets, they are rebuilt without holding the lock
+    std::vector<std::pair<void const *, Asset>> affected;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto const &[key, asset] : assets)
+        {
+            auto const built = [&asset](std::string const &file) { return asset.files.contains(file); };
+            if (std::any_of(changed.begin(), changed.end(), built))
+                affected.emplace_back(key, asset);
+        }
+    }
+
+    for (auto const &[key, asset] : affected)
+    {
+        if (asset.shader)
+            rebuild(key, asset);
+        else
+            reparse(key, asset);
+    }
+}
+
+#ifdef __linux__
+// wait for changes and reload once the files were quiet for a moment, editors
+// save in several steps and a single rebuild should see the final content
+static void run()
+{
+    profiler::name("asset watcher");
+
+    std::unordered_set<std::string> changed;
+    alignas(inotify_event) char buffer[4096];
+    while (active.load(std::memory_order_acquire))
+    {
+        pollfd request{descriptor, POLLIN, 0};
+        if (poll(&request, 1, 50) <= 0) // quiet or interrupted
+        {
+            if (!changed.empty())
+                reload(changed);
+            changed.clear();
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(descriptor, buffer, sizeof(buffer))) > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (char *at = buffer; at < buffer + length;)
+            {
+                auto const *event = reinterpret_cast<inotify_event const *>(at);
+                at += sizeof(inotify_event) + event->len;
+
+                auto it = directories.find(event->wd);
+                if (event->len && it != directories.end())
+                    changed.insert(normal(std::filesystem::path(it->second) / event->name));
+            }
+        }
+    }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//// REGISTRATION
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: shader
+
+\summary:  reload a shader when one of its stages or included files changes,
+           the shader has to be forgotten or destroyed before it is released
+
+\args:     shader - shader to watch
+************************************************************************//*F-F*/
+void shader(ShaderBase *shader)
+{
+    Asset asset;
+    asset.shader = shader;
+    asset.stages = shader->stages();
+    asset.defines = shader->defines();
+    shader_files(asset);
+    add(shader, std::move(asset));
+}
+
+/*F+F***********************************************************************//*!
+\function: model
+
+\summary:  reload an obj model when its obj or mtl file changes, the geometry
+           is swapped in place so references to the model stay valid, data
+           copied from the model (a Batch, its Cull, trees over the vertices)
+           is stale afterwards and has to be rebuilt by the reloaded hook
+
+\args:     model - model loaded by object::load or object::load_all
+\args:     color - color used until a material is selected
+\args:     reloaded - called on the main thread after the model was swapped
+************************************************************************//*F-F*/
+void model(Model *model, glm::vec3 color, Handle reloaded)
+{
+    Asset asset;
+    asset.model = model;
+    asset.name = model->name;
+    asset.color = color;
+    asset.reloaded = std::move(reloaded);
+    asset.files = {normal(model->name + ".obj"), normal(model->name + ".mtl")};
+    add(model, std::move(asset));
+}
+
+// stop watching an asset, called by the shader and model destructors
+void forget(void const *asset)
+{
+    if (!registered.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    assets.erase(asset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// WATCHER
+////////////////////////////////////////////////////////////////////////////////
+
+/*F+F***********************************************************************//*!
+\function: start
+
+\summary:  start the watcher thread, called implicitly by the first asset
+************************************************************************//*F-F*/
+void start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active.load(std::memory_order_acquire))
+        return;
+
+#ifdef __linux__
+    descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (descriptor < 0)
+    {
+        my_log::error("Unable to initialize inotify, assets are not reloaded.");
+        return;
+    }
+    active.store(true, std::memory_order_release);
+    watcher = std::thread(run);
+#else
+    static bool reported = false;
+    if (!reported)
+        my_log::error("Asset reloading requires inotify and is only available on linux.");
+    reported = true;
+#endif
+}
+
+/*F+F***********************************************************************//*!
+\function: stop
+
+\summary:  join the watcher and forget every asset, pending swaps queued for
+           the main thread are discarded when they run
+************************************************************************//*F-F*/
+void stop()
+{
+    if (!active.exchange(false))
+        return;
+    watcher.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    assets.clear();
+#ifdef __linux__
+    close(descriptor);
+    descriptor = -1;
+    directories.clear();
+    watched.clear();
+#endif
+}
+
+// the watcher thread is running
+bool running()
+{
+    return active.load(std::memory_order_acquire);
+}
+
+} // namespace watch
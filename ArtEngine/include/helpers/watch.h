@@ -0,0 +1,38 @@
+/*+*************************************************************************//*!
+\file:      watch.h
+
+\summary:   asset hot-reload, a background thread waits on inotify for changes
+            to the files of registered shaders and obj models, re-expands or
+            re-parses only the changed assets and queues the swap for the main
+            thread, which applies it between frames, a failed build keeps the
+            previous version, linux only
+
+\functions: shader\n
+            model\n
+            forget\n
+            start\n
+            stop\n
+            running\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_WATCH_H
+#define ARTENGINE_WATCH_H
+
+namespace watch
+{
+
+void shader(ShaderBase *shader);
+void model(Model *model, glm::vec3 color = color::magenta, Handle reloaded = nullptr);
+void forget(void const *asset);
+
+void start();
+void stop();
+[[nodiscard]] bool running();
+
+} // namespace watch
+
+#endif // ARTENGINE_WATCH_H
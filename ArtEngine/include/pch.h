@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <bitset>
 #include <cassert>
 #include <chrono>
 #include <cmath>
@@ -23,6 +24,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <deque>
 #include <exception>
@@ -41,10 +43,12 @@
 #include <memory>
 #include <mutex>
 #include <numbers>
+#include <numeric>
 #include <queue>
 #include <random>
 #include <regex>
 #include <set>
+#include <span>
 #include <stack>
 #include <stdexcept>
 #include <sstream>
@@ -67,6 +71,7 @@
 #include <SDL2/SDL_mixer.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 // file / console IO
@@ -85,6 +90,9 @@
 
 using Handle = std::function<void()>;
 
+// logging, used by every engine file
+#include "helpers/log.h"
+
 // engine files
 #include "view.h"
 #include "event.h"
@@ -94,19 +102,29 @@ using Handle = std::function<void()>;
 
 // utility
 #include "utility/buffer.h"
+#include "utility/vertex.h"
 #include "utility/model.h"
 #include "utility/instance.h"
+#include "utility/batch.h"
 #include "utility/shader.h"
+#include "utility/cull.h"
 #include "utility/texture.h"
 #include "utility/target.h"
+#include "utility/readback.h"
+#include "utility/capture.h"
 
 // helpers
 #include "helpers/camera.h"
 #include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/pacing.h"
+#include "helpers/job.h"
+#include "helpers/snapshot.h"
 #include "helpers/color.h"
 #include "helpers/object.h"
+#include "helpers/lod.h"
+#include "helpers/watch.h"
 #include "helpers/parse.h"
-#include "helpers/log.h"
 #include "helpers/image.h"
 
 #endif // ARTENGINE_PCH_H
\ No newline at end of file
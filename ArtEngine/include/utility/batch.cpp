@@ -0,0 +1,332 @@
+#include "../pch.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// query the vertex buffer binding state of a model's vertex array
+static GLint binding_query(Model const *model, GLenum name, GLuint index)
+{
+    GLint value = 0;
+    glBindVertexArray(model->vao);
+    glGetIntegeri_v(name, index, &value);
+    return value;
+}
+
+// query the vertex attribute state of a model's vertex array
+static GLint attribute_query(Model const *model, GLenum name, GLuint index)
+{
+    GLint value = 0;
+    glBindVertexArray(model->vao);
+    glGetVertexAttribiv(index, name, &value);
+    return value;
+}
+
+// vertex buffer an attribute of a model reads from
+static GLuint attribute_buffer(Model const *model, GLuint location)
+{
+    GLint const binding = attribute_query(model, GL_VERTEX_ATTRIB_BINDING, location);
+    return static_cast<GLuint>(binding_query(model, GL_VERTEX_BINDING_BUFFER, binding));
+}
+
+// size of a buffer object in bytes
+static size_t buffer_bytes(GLuint buffer)
+{
+    GLint bytes = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return static_cast<size_t>(bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// BATCH
+////////////////////////////////////////////////////////////////////////////////
+
+/*M+M***********************************************************************//*!
+ \method:   Batch::Batch
+
+ \summary:  create an empty batch for models using the given attribute layout
+
+ \args:     binding - ordered attribute names, matching the shader inputs
+ \args:     transforms - name of the ssbo holding the per-draw model matrices
+************************************************************************//*M-M*/
+Batch::Batch(std::vector<std::string> binding, std::string transforms)
+    : m_binding(binding)
+    , m_formats(binding.size())
+    , m_transforms_name(transforms)
+{
+    glGenVertexArrays(1, &m_vao);
+    for (size_t i = 0; i < m_binding.size(); ++i)
+        m_vertices.push_back(new Buffer());
+    ShaderBase::ssbo(m_transforms_name); // ensure the binding points exist
+    ShaderBase::ssbo("quantization");
+}
+
+Batch::~Batch()
+{
+    glDeleteVertexArrays(1, &m_vao);
+    for (auto const *b : m_vertices)
+        delete b;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Batch::add
+
+ \summary:  queue a model for batching, the model must provide every attribute
+            of the batch with the same format as the models already queued
+
+ \args:     model - model to batch
+
+ \modifies: [m_models, m_formats]
+
+ \return:   True, if the model is compatible and was queued
+ \return:   False, otherwise
+************************************************************************//*M-M*/
+bool Batch::add(Model *model)
+{
+    std::vector<AttributeFormat> formats(m_binding.size());
+
+    for (size_t i = 0; i < m_binding.size(); ++i)
+    {
+        auto binding = model->bindings.find(m_binding[i]);
+        if (binding == model->bindings.end())
+        {
+            my_log::error("Model ", model->name, " has no attribute ", m_binding[i], ".");
+            glBindVertexArray(0);
+            return false;
+        }
+        GLuint const location = binding->second;
+        AttributeFormat &format = formats[i];
+        format.stride =
+            binding_query(model, GL_VERTEX_BINDING_STRIDE, attribute_query(model, GL_VERTEX_ATTRIB_BINDING, location));
+        format.components = attribute_query(model, GL_VERTEX_ATTRIB_ARRAY_SIZE, location);
+        format.type = attribute_query(model, GL_VERTEX_ATTRIB_ARRAY_TYPE, location);
+        format.normalized = attribute_query(model, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, location);
+        format.offset = attribute_query(model, GL_VERTEX_ATTRIB_RELATIVE_OFFSET, location);
+        format.integer = attribute_query(model, GL_VERTEX_ATTRIB_ARRAY_INTEGER, location);
+    }
+    glBindVertexArray(0);
+
+    // the first model defines the layout of the batch
+    if (m_models.empty())
+        m_formats = formats;
+    else if (formats != m_formats)
+    {
+        my_log::error("Model ", model->name, " does not match the batch layout.");
+        return false;
+    }
+
+    m_models.push_back(model);
+    return true;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Batch::build
+
+ \summary:  copy the vertices and indices of the queued models into the
+            megabuffers on the gpu and record one indirect command per model
+
+ \modifies: [m_vertices, m_indices, m_draw_ids, m_arrays, m_elements,
+            m_array_draws, m_element_draws, m_first, m_vertex_count,
+            m_index_count]
+************************************************************************//*M-M*/
+void Batch::build()
+{
+    m_array_draws.clear();
+    m_element_draws.clear();
+    m_first.clear();
+    m_vertex_count = 0;
+    m_index_count = 0;
+
+    if (m_models.empty())
+        return;
+
+    // record a draw command per model and measure the megabuffers
+    std::vector<size_t> vertices(m_models.size());
+    std::vector<size_t> indices(m_models.size(), 0);
+    for (size_t i = 0; i < m_models.size(); ++i)
+    {
+        Model const *model = m_models[i];
+        vertices[i] = model->vertices(); // every detail level, the command draws the full detail one
+
+        if (model->indexed)
+        {
+            // size counts indices, the vertex count comes from the first attribute
+            GLuint position = attribute_buffer(model, model->bindings.at(m_binding[0]));
+            vertices[i] = buffer_bytes(position) / m_formats[0].stride;
+            indices[i] = std::min(model->size, buffer_bytes(model->idx) / sizeof(GLuint));
+
+            m_element_draws.push_back({static_cast<GLuint>(indices[i]), 1, static_cast<GLuint>(m_index_count),
+                                       static_cast<GLint>(m_vertex_count), static_cast<GLuint>(i)});
+        }
+        else
+            m_array_draws.push_back(
+                {static_cast<GLuint>(model->size), 1, static_cast<GLuint>(m_vertex_count), static_cast<GLuint>(i)});
+
+        m_first.push_back(static_cast<GLuint>(m_vertex_count));
+        m_vertex_count += vertices[i];
+        m_index_count += indices[i];
+    }
+
+    // copy every attribute into its megabuffer without a round trip to the cpu, interleaved
+    // attributes copy the whole vertex and keep their offset
+    for (size_t b = 0; b < m_binding.size(); ++b)
+    {
+        GLsizeiptr const stride = m_formats[b].stride;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertices[b]->index);
+        glBufferData(GL_COPY_WRITE_BUFFER, m_vertex_count * stride, nullptr, GL_STATIC_DRAW);
+        m_vertices[b]->size = m_vertex_count;
+
+        GLintptr offset = 0;
+        for (size_t i = 0; i < m_models.size(); ++i)
+        {
+            Model const *model = m_models[i];
+            GLuint source = attribute_buffer(model, model->bindings.at(m_binding[b]));
+            glBindBuffer(GL_COPY_READ_BUFFER, source);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, vertices[i] * stride);
+            offset += vertices[i] * stride;
+        }
+    }
+
+    // copy the indices of the indexed models
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_indices.index);
+    glBufferData(GL_COPY_WRITE_BUFFER, m_index_count * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    m_indices.size = m_index_count;
+    GLintptr offset = 0;
+    for (size_t i = 0; i < m_models.size(); ++i)
+    {
+        if (!indices[i])
+            continue;
+        glBindBuffer(GL_COPY_READ_BUFFER, m_models[i]->idx);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, indices[i] * sizeof(GLuint));
+        offset += indices[i] * sizeof(GLuint);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // upload the indirect commands and the draw ids
+    std::vector<GLuint> draw_ids(m_models.size());
+    std::iota(draw_ids.begin(), draw_ids.end(), 0);
+    m_draw_ids.fill(draw_ids);
+    if (!m_array_draws.empty())
+        m_arrays.fill(m_array_draws);
+    if (!m_element_draws.empty())
+        m_elements.fill(m_element_draws);
+
+    // describe the megabuffers, attributes keep the binding order of the batch
+    glBindVertexArray(m_vao);
+    for (GLuint b = 0; b < m_binding.size(); ++b)
+    {
+        glEnableVertexAttribArray(b);
+        AttributeFormat const &format = m_formats[b];
+        glBindVertexBuffer(b, m_vertices[b]->index, 0, format.stride);
+        if (format.integer)
+            glVertexAttribIFormat(b, format.components, format.type, format.offset);
+        else
+            glVertexAttribFormat(b, format.components, format.type, format.normalized, format.offset);
+        glVertexAttribBinding(b, b);
+    }
+
+    // the draw id follows the attributes and advances once per draw (base instance)
+    GLuint const id = static_cast<GLuint>(m_binding.size());
+    glEnableVertexAttribArray(id);
+    glBindVertexBuffer(id, m_draw_ids.index, 0, sizeof(GLuint));
+    glVertexAttribIFormat(id, 1, GL_UNSIGNED_INT, 0);
+    glVertexAttribBinding(id, id);
+    glVertexBindingDivisor(id, 1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices.index);
+    glBindVertexArray(0);
+
+    update();
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Batch::update
+
+ \summary:  upload the model matrix of every batched model to the transform
+            buffer and the dequantization box of every model, call after
+            moving models
+
+ \modifies: [m_transforms, m_quantization]
+************************************************************************//*M-M*/
+void Batch::update()
+{
+    if (m_models.empty())
+        return;
+
+    std::vector<glm::mat4> transforms;
+    std::vector<glm::vec4> boxes;
+    transforms.reserve(m_models.size());
+    boxes.reserve(m_models.size() * 2);
+    for (auto const *model : m_models)
+    {
+        transforms.push_back(model->model);
+        boxes.push_back(glm::vec4(model->origin, 0.0f));
+        boxes.push_back(glm::vec4(model->extent, 0.0f));
+    }
+    m_transforms.fill(transforms);
+    m_quantization.fill(boxes);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Batch::detail
+
+ \summary:  point the command of every non-indexed model at the vertex range
+            of its selected level (see lod::select), the commands are only
+            uploaded when a level changed and culling picks them up as well
+
+ \modifies: [m_array_draws, m_arrays]
+************************************************************************//*M-M*/
+void Batch::detail()
+{
+    bool changed = false;
+    for (auto &draw : m_array_draws)
+    {
+        Model const *model = m_models[draw.base_instance];
+        if (model->levels.empty())
+            continue;
+
+        Model::Level const &level = model->levels[model->level];
+        GLuint const first = m_first[draw.base_instance] + level.first;
+        changed |= draw.first != first || draw.count != level.count;
+        draw.first = first;
+        draw.count = level.count;
+    }
+
+    if (changed)
+        m_arrays.fill(m_array_draws);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Batch::render
+
+ \summary:  draw every batched model, one multi-draw call for the non-indexed
+            models and one for the indexed models
+
+ \args:     mode - primitive type used to draw the models
+************************************************************************//*M-M*/
+void Batch::render(GLenum mode)
+{
+    if (m_models.empty())
+        return;
+
+    glBindVertexArray(m_vao);
+    ShaderBase::bind<glm::mat4>(m_transforms_name, &m_transforms);
+    ShaderBase::bind<glm::vec4>("quantization", &m_quantization);
+
+    if (!m_array_draws.empty())
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_arrays.index);
+        glMultiDrawArraysIndirect(mode, nullptr, static_cast<GLsizei>(m_array_draws.size()), 0);
+    }
+
+    if (!m_element_draws.empty())
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_elements.index);
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(m_element_draws.size()), 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
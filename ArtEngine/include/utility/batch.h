@@ -0,0 +1,79 @@
+#ifndef ARTENGINE_BATCH_H
+#define ARTENGINE_BATCH_H
+
+// command layouts consumed by glMultiDraw*Indirect (must match the OpenGL spec)
+struct DrawArraysCommand
+{
+    GLuint count;          //!< number of vertices
+    GLuint instance_count; //!< number of instances
+    GLuint first;          //!< first vertex in the vertex megabuffers
+    GLuint base_instance;  //!< draw id of the command
+};
+
+struct DrawElementsCommand
+{
+    GLuint count;          //!< number of indices
+    GLuint instance_count; //!< number of instances
+    GLuint first_index;    //!< first index in the index megabuffer
+    GLint base_vertex;     //!< first vertex in the vertex megabuffers
+    GLuint base_instance;  //!< draw id of the command
+};
+
+// vertex format of a batched attribute, every model of a batch has to match
+struct AttributeFormat
+{
+    GLint stride = 0;            //!< bytes per vertex
+    GLint components = 0;        //!< component count
+    GLint type = GL_FLOAT;       //!< component type
+    GLint normalized = GL_FALSE; //!< fixed point mapped to [0, 1] or [-1, 1]
+    GLint offset = 0;            //!< byte offset within an interleaved vertex
+    GLint integer = GL_FALSE;    //!< read as integers by the shader
+
+    bool operator==(AttributeFormat const &) const = default;
+};
+
+/*C+C***********************************************************************//*!
+ \class:    Batch
+
+ \summary:  merge static models sharing an attribute layout into vertex and
+            index megabuffers and render them with multi-draw indirect
+
+ \methods:  add - queue a compatible model for batching\n
+         :  build - copy the queued models into the megabuffers\n
+         :  update - upload the model matrices to the transform buffer\n
+         :  detail - draw the selected detail level of every model\n
+         :  render - draw every batched model in at most two draw calls\n
+************************************************************************//*C-C*/
+class Batch
+{
+  public:
+    Batch(std::vector<std::string> binding, std::string transforms = "transforms");
+    ~Batch();
+
+    bool add(Model *model);
+    void build();
+    void update();
+    void detail();
+    void render(GLenum mode = GL_TRIANGLES);
+
+    GLuint m_vao;                                     //!< vertex array of the megabuffers
+    std::vector<std::string> m_binding;               //!< ordered attribute names
+    std::vector<AttributeFormat> m_formats;           //!< vertex format of each attribute
+    std::vector<Buffer *> m_vertices;                 //!< vertex megabuffer of each attribute
+    Buffer m_indices;                                 //!< index megabuffer
+    Buffer m_draw_ids;                                //!< per-draw id (instanced attribute)
+    Buffer m_transforms;                              //!< per-draw model matrices (ssbo)
+    Buffer m_quantization;                            //!< per-draw origin and extent of quantized models (ssbo)
+    Buffer m_arrays;                                  //!< indirect commands of non-indexed models
+    Buffer m_elements;                                //!< indirect commands of indexed models
+    std::string m_transforms_name;                    //!< ssbo name of the transform buffer
+    std::vector<Model *> m_models;                    //!< batched models, indexed by draw id
+    std::vector<DrawArraysCommand> m_array_draws;     //!< commands of non-indexed models
+    std::vector<DrawElementsCommand> m_element_draws; //!< commands of indexed models
+    std::vector<GLuint> m_first;                      //!< first vertex of every model in the megabuffers
+    size_t m_vertex_count = 0;                        //!< vertices in the megabuffers
+    size_t m_index_count = 0;                         //!< indices in the index megabuffer
+
+}; // class Batch
+
+#endif // ARTENGINE_BATCH_H
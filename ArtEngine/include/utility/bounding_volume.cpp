@@ -176,9 +176,7 @@ void AABB::compute(bb_type t)
     type = t;
 
     // get the vertex information
-    std::vector<glm::vec3> points;
-    points.resize(model->size);
-    model->buffers["in_Position"]->retrieve(points);
+    std::vector<glm::vec3> points = model->positions();
 
     // reset rotation matrix
     T = identity;
@@ -186,7 +184,7 @@ void AABB::compute(bb_type t)
     switch (type)
     {
     default:
-        std::cout << "Error: Bounding Box type not recognized, defaulting to AABB." << std::endl;
+        my_log::error("Bounding Box type not recognized, defaulting to AABB.");
         // fallthrough
     case bb_type::aabb:
         aabb(points);
@@ -365,14 +363,12 @@ void Sphere::compute(sphere_type t)
     type = t;
 
     // get the vertex information
-    std::vector<glm::vec3> points;
-    points.resize(model->size);
-    model->buffers["in_Position"]->retrieve(points);
+    std::vector<glm::vec3> points = model->positions();
 
     switch (type)
     {
     default:
-        std::cout << "Error: Sphere type not recognized, using centroid method." << std::endl;
+        my_log::error("Sphere type not recognized, using centroid method.");
         // fallthrough
     case sphere_type::centroid:
         centroid(points);
@@ -521,35 +517,34 @@ void Sphere::larsson(const std::vector<glm::vec3> &v)
     for (size_t i = 0; i < v.size(); i += 3)
         k_points.push_back(v[i]);
 
-    // compute extreme points (min, max) for each epos
-    std::vector<std::pair<glm::vec3, glm::vec3>> extremes;
+    // gather the directions of the epos
+    std::vector<glm::vec3> directions;
     switch (type)
     {
     default:
-        std::cout << "Error: EPOS value not recognized, using EPOS-98" << std::endl;
+        my_log::error("EPOS value not recognized, using EPOS-98");
         // fallthrough
     case sphere_type::larsson98:
-        for (auto const &dir : epos24_1)
-            extremes.emplace_back(extreme_points_along_direction(dir, k_points));
-        for (auto const &dir : epos24_2)
-            extremes.emplace_back(extreme_points_along_direction(dir, k_points));
-        for (auto const &dir : epos24_3)
-            extremes.emplace_back(extreme_points_along_direction(dir, k_points));
+        directions.insert(directions.end(), epos24_1.begin(), epos24_1.end());
+        directions.insert(directions.end(), epos24_2.begin(), epos24_2.end());
+        directions.insert(directions.end(), epos24_3.begin(), epos24_3.end());
         // fallthrough
     case sphere_type::larsson26:
-        for (auto const &dir : epos12)
-            extremes.emplace_back(extreme_points_along_direction(dir, k_points));
+        directions.insert(directions.end(), epos12.begin(), epos12.end());
         // fallthrough
     case sphere_type::larsson14:
-        for (auto const &dir : epos8)
-            extremes.emplace_back(extreme_points_along_direction(dir, k_points));
+        directions.insert(directions.end(), epos8.begin(), epos8.end());
         // fallthrough
     case sphere_type::larsson6:
-        for (auto const &dir : epos6)
-            extremes.emplace_back(extreme_points_along_direction(dir, k_points));
+        directions.insert(directions.end(), epos6.begin(), epos6.end());
         break;
     }
 
+    // compute extreme points (min, max) for each direction, every direction is an independent pass over the points
+    std::vector<std::pair<glm::vec3, glm::vec3>> extremes(directions.size());
+    job::parallel_for(directions.size(),
+                      [&](size_t i) { extremes[i] = extreme_points_along_direction(directions[i], k_points); });
+
     // find the pair of points the furthest apart
     float dist = f_min;
     std::pair<glm::vec3, glm::vec3> furthest_pair;
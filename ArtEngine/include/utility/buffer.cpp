@@ -7,5 +7,61 @@ Buffer::Buffer()
 
 Buffer::~Buffer()
 {
-    glDeleteBuffers(1, &index);
-}
\ No newline at end of file
+    for (auto &fence : fences)
+        if (fence)
+            glDeleteSync(fence);
+    glDeleteBuffers(1, &index); // also releases a persistent mapping
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Buffer::alignment
+
+ \summary:  offset alignment of a ring region, regions are bound as storage
+            or uniform blocks with glBindBufferRange, queried once
+
+ \return:   size_t - alignment in bytes, at least 4
+************************************************************************//*M-M*/
+size_t Buffer::alignment()
+{
+    static size_t const align = [] {
+        GLint storage = 0;
+        GLint uniform = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage);
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform);
+        return std::max<size_t>({4, static_cast<size_t>(storage), static_cast<size_t>(uniform)});
+    }();
+    return align;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Buffer::next_region
+
+ \summary:  fence the commands reading the current region and move to the next
+            region, waiting only if the gpu still reads it
+
+ \modifies: [fences, frame, offset]
+
+ \return:   unsigned char* - mapped memory of the new current region
+************************************************************************//*M-M*/
+unsigned char *Buffer::next_region()
+{
+    // commands issued since the last fill read the current region
+    if (fences[frame])
+        glDeleteSync(fences[frame]);
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    frame = (frame + 1) % frames;
+    offset = static_cast<GLintptr>(frame * capacity);
+
+    GLsync &fence = fences[frame];
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    return mapped + offset;
+}
@@ -6,23 +6,37 @@ struct Buffer
     GLuint index;
     size_t size;
 
+    // streaming mode
+    GLintptr offset = 0;             //!< byte offset of the current data
+    size_t capacity = 0;             //!< bytes of a ring region, a multiple of the binding alignment
+    size_t frames = 0;               //!< ring regions, zero when not streaming
+    size_t frame = 0;                //!< ring region holding the current data
+    unsigned char *mapped = nullptr; //!< persistent mapping of every region
+    std::vector<GLsync> fences;      //!< fence of the commands reading each region
+
     Buffer();
     ~Buffer();
 
     template <typename T>
-    Buffer(std::vector<T> buffer);
+    Buffer(std::vector<T> const &buffer);
 
     template <typename T>
     Buffer(std::initializer_list<T> buffer);
 
     template <typename T>
-    Buffer(size_t size, T *data);
+    Buffer(size_t size, T const *data);
+
+    template <typename T>
+    void stream(size_t n, size_t regions = 3);
+
+    template <typename T>
+    void fill(size_t n, T const *data);
 
     template <typename T>
-    void fill(size_t n, T *data);
+    void fill(std::vector<T> const &buffer);
 
     template <typename T>
-    void fill(std::vector<T> buffer);
+    void fill(std::span<T const> buffer);
 
     template <typename T>
     void fill(T value);
@@ -36,10 +50,14 @@ struct Buffer
     template <typename T>
     void retrieve(T &value);
 
+  private:
+    unsigned char *next_region();
+    static size_t alignment();
+
 }; // struct buffer
 
 template <typename T>
-Buffer::Buffer(std::vector<T> buffer)
+Buffer::Buffer(std::vector<T> const &buffer)
     : Buffer()
 {
     fill(buffer);
@@ -49,29 +67,86 @@ template <typename T>
 Buffer::Buffer(std::initializer_list<T> buffer)
     : Buffer()
 {
-    fill<T>(buffer);
+    fill(buffer.size(), buffer.begin());
 }
 
 template <typename T>
-Buffer::Buffer(size_t size, T *data)
+Buffer::Buffer(size_t size, T const *data)
     : Buffer()
 {
     fill(size, data);
 }
 
+/*M+M***********************************************************************//*!
+ \method:   Buffer::stream
+
+ \summary:  switch the buffer to streaming mode, immutable storage split into
+            ring regions that stay persistently mapped, every fill writes the
+            next region after its fence signals instead of reallocating, the
+            regions start at offsets valid for glBindBufferRange
+
+ \args:     n - maximum number of elements of a fill
+ \args:     regions - number of ring regions (frames in flight)
+
+ \modifies: [capacity, frames, frame, offset, mapped, fences, size]
+************************************************************************//*M-M*/
 template <typename T>
-void Buffer::fill(size_t n, T *data)
+void Buffer::stream(size_t n, size_t regions)
 {
+    static GLbitfield constexpr flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    // immutable storage requires a new buffer object
+    glDeleteBuffers(1, &index);
+    glGenBuffers(1, &index);
+
+    size_t const align = alignment();
+    capacity = (n * sizeof(T) + align - 1) / align * align;
+    frames = regions;
+    frame = 0;
+    offset = 0;
+    size = 0;
+    fences.assign(frames, nullptr);
+
     glBindBuffer(GL_ARRAY_BUFFER, index);
-    glBufferData(GL_ARRAY_BUFFER, n * sizeof(T), data, GL_DYNAMIC_DRAW);
+    glBufferStorage(GL_ARRAY_BUFFER, frames * capacity, nullptr, flags);
+    mapped = static_cast<unsigned char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, frames * capacity, flags));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+template <typename T>
+void Buffer::fill(size_t n, T const *data)
+{
+    if (!frames)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, index);
+        glBufferData(GL_ARRAY_BUFFER, n * sizeof(T), data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        size = n;
+        return;
+    }
+
+    if (n * sizeof(T) > capacity)
+    {
+        my_log::error("Streaming buffer capacity exceeded, data truncated.");
+        n = capacity / sizeof(T);
+    }
+
+    unsigned char *region = next_region();
+    if (data)
+        std::memcpy(region, data, n * sizeof(T));
     size = n;
 }
 
 template <typename T>
-void Buffer::fill(std::vector<T> buffer)
+void Buffer::fill(std::vector<T> const &buffer)
+{
+    fill(buffer.size(), buffer.data());
+}
+
+template <typename T>
+void Buffer::fill(std::span<T const> buffer)
 {
-    fill(buffer.size(), &buffer[0]);
+    fill(buffer.size(), buffer.data());
 }
 
 template <typename T>
@@ -84,7 +159,7 @@ template <typename T>
 void Buffer::retrieve(size_t n, T *data)
 {
     glBindBuffer(GL_ARRAY_BUFFER, index);
-    glGetBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(T), data);
+    glGetBufferSubData(GL_ARRAY_BUFFER, offset, n * sizeof(T), data);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
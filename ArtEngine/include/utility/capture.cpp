@@ -0,0 +1,275 @@
+#include "../pch.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//// CAPTURE
+////////////////////////////////////////////////////////////////////////////////
+
+Capture::Capture(std::string path, Settings settings)
+    : m_path(path)
+    , m_settings(settings)
+{
+    m_settings.readbacks = std::max<size_t>(1, m_settings.readbacks);
+    m_settings.queue = std::max<size_t>(1, m_settings.queue);
+    for (size_t i = 0; i < m_settings.readbacks; ++i)
+        m_readbacks.push_back(std::make_unique<Readback>());
+
+    if (m_settings.format == Format::y4m)
+    {
+        m_video.open(m_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!m_video.is_open())
+            my_log::error("Unable to open video file ", m_path, ".");
+    }
+
+    for (int i = 0; i < std::max(1, m_settings.encoders); ++i)
+        m_encoders.emplace_back(&Capture::encode, this);
+}
+
+Capture::~Capture()
+{
+    stop();
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Capture::frame
+
+ \summary:  collect the readbacks that completed and issue the readback of the
+            current frame, with every pack buffer in flight the frame is
+            skipped (drop) or the oldest readback is waited for (block)
+
+ \args:     fbo - framebuffer object, 0 for the window
+ \args:     size - dimensions of the frame
+ \args:     attach - read buffer (GL_COLOR_ATTACHMENTi, GL_BACK for the window)
+
+ \modifies: [m_readbacks, m_issued, m_retrieved, m_dropped]
+************************************************************************//*M-M*/
+void Capture::frame(GLuint fbo, glm::ivec2 size, GLenum attach)
+{
+    if (m_stopping)
+        return;
+
+    collect(false);
+    if (m_issued - m_retrieved == m_readbacks.size())
+    {
+        if (m_settings.policy == Policy::drop)
+        {
+            ++m_dropped;
+            return;
+        }
+        collect(true);
+    }
+
+    m_readbacks[m_issued % m_readbacks.size()]->read(fbo, glm::ivec2(0), size, attach);
+    ++m_issued;
+}
+
+void Capture::frame(Target *target)
+{
+    frame(target->m_fbo, glm::ivec2(target->m_width, target->m_height));
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Capture::stop
+
+ \summary:  retrieve every readback in flight, let the encoders finish the
+            queue and join them, called by the destructor
+
+ \modifies: [m_stopping, m_encoders, m_video]
+************************************************************************//*M-M*/
+void Capture::stop()
+{
+    if (m_stopping)
+        return;
+
+    while (m_retrieved < m_issued)
+        collect(true);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_available.notify_all();
+    for (auto &encoder : m_encoders)
+        encoder.join();
+    m_encoders.clear();
+
+    if (m_video.is_open())
+        m_video.close();
+}
+
+size_t Capture::captured() const
+{
+    return m_captured;
+}
+
+size_t Capture::dropped() const
+{
+    return m_dropped;
+}
+
+size_t Capture::encoded() const
+{
+    return m_encoded;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Capture::collect
+
+ \summary:  retrieve completed readbacks in issue order and queue their frames
+
+ \args:     block - wait for the oldest readback and queue its frame even if
+                    the queue is full, otherwise only take completed ones
+
+ \modifies: [m_readbacks, m_retrieved]
+************************************************************************//*M-M*/
+void Capture::collect(bool block)
+{
+    while (m_retrieved < m_issued)
+    {
+        Readback &readback = *m_readbacks[m_retrieved % m_readbacks.size()];
+        if (!block && !readback.ready())
+            return;
+
+        Frame frame{0, readback.m_size, std::vector<unsigned char>(readback.m_bytes)};
+        readback.retrieve(frame.pixels);
+        ++m_retrieved;
+        push(std::move(frame), block || m_settings.policy == Policy::block);
+        if (block)
+            return;
+    }
+}
+
+// hand a frame to the encoders, returns false if it was dropped on a full queue
+bool Capture::push(Frame &&frame, bool block)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_queue.size() >= m_settings.queue)
+        {
+            if (!block)
+            {
+                ++m_dropped;
+                return false;
+            }
+            m_space.wait(lock, [this] { return m_queue.size() < m_settings.queue; });
+        }
+
+        // frames are numbered when admitted, dropped frames leave no gap
+        frame.index = m_captured++;
+        m_queue.push_back(std::move(frame));
+    }
+    m_available.notify_one();
+    return true;
+}
+
+// encoder thread, writes queued frames until stopped and the queue is empty
+void Capture::encode()
+{
+    profiler::name("capture encoder");
+
+    while (true)
+    {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_available.wait(lock, [this] { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty())
+                return;
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_space.notify_one();
+
+        if (m_settings.format == Format::png)
+            write_png(frame);
+        else
+            write_y4m(frame);
+        ++m_encoded;
+    }
+}
+
+// numbered png, rows flipped to run top to bottom
+void Capture::write_png(Frame const &frame)
+{
+    SDL_Surface *surface = image::surface(frame.size.x, frame.size.y);
+    if (!surface)
+        return;
+
+    {
+        image::Pixels pixels(surface);
+        size_t const bytes = static_cast<size_t>(frame.size.x) * 4;
+        for (int y = 0; y < frame.size.y; ++y)
+            std::memcpy(pixels.row<unsigned char>(y).data(), &frame.pixels[(frame.size.y - 1 - y) * bytes], bytes);
+    }
+
+    std::ostringstream name;
+    name << m_path << "_" << std::setw(6) << std::setfill('0') << frame.index << ".png";
+    if (IMG_SavePNG(surface, name.str().c_str()) != 0)
+        my_log::error("Unable to save frame ", name.str(), ": ", IMG_GetError());
+    SDL_FreeSurface(surface);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Capture::write_y4m
+
+ \summary:  convert a frame to full range YUV 4:2:0 (bt.601, chroma averaged
+            over 2x2 pixels) and append it to the video, encoders convert in
+            parallel and take turns writing in frame order
+
+ \args:     frame - retrieved frame
+
+ \modifies: [m_video, m_video_next, m_video_size]
+************************************************************************//*M-M*/
+void Capture::write_y4m(Frame const &frame)
+{
+    int const width = frame.size.x;
+    int const height = frame.size.y;
+    int const chroma_width = (width + 1) / 2;
+    int const chroma_height = (height + 1) / 2;
+    std::vector<unsigned char> planes(static_cast<size_t>(width) * height +
+                                      2 * static_cast<size_t>(chroma_width) * chroma_height);
+    unsigned char *luma = planes.data();
+    unsigned char *u = luma + static_cast<size_t>(width) * height;
+    unsigned char *v = u + static_cast<size_t>(chroma_width) * chroma_height;
+
+    // source rows run bottom to top
+    auto const rgb = [&](int x, int y) {
+        unsigned char const *p = &frame.pixels[(static_cast<size_t>(height - 1 - y) * width + x) * 4];
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+    auto const byte = [](float value) { return static_cast<unsigned char>(std::clamp(value + 0.5f, 0.0f, 255.0f)); };
+
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            luma[static_cast<size_t>(y) * width + x] = byte(glm::dot(rgb(x, y), glm::vec3(0.299f, 0.587f, 0.114f)));
+
+    for (int y = 0; y < chroma_height; ++y)
+        for (int x = 0; x < chroma_width; ++x)
+        {
+            int const x1 = std::min(2 * x + 1, width - 1);
+            int const y1 = std::min(2 * y + 1, height - 1);
+            glm::vec3 const c = 0.25f * (rgb(2 * x, 2 * y) + rgb(x1, 2 * y) + rgb(2 * x, y1) + rgb(x1, y1));
+            size_t const i = static_cast<size_t>(y) * chroma_width + x;
+            u[i] = byte(glm::dot(c, glm::vec3(-0.168736f, -0.331264f, 0.5f)) + 128.0f);
+            v[i] = byte(glm::dot(c, glm::vec3(0.5f, -0.418688f, -0.081312f)) + 128.0f);
+        }
+
+    std::unique_lock<std::mutex> lock(m_video_mutex);
+    m_video_turn.wait(lock, [&] { return m_video_next == frame.index; });
+
+    if (m_video_next == 0)
+    {
+        m_video_size = frame.size;
+        m_video << "YUV4MPEG2 W" << width << " H" << height << " F" << m_settings.fps << ":1 Ip A1:1 C420jpeg\n";
+    }
+    if (frame.size == m_video_size)
+    {
+        m_video << "FRAME\n";
+        m_video.write(reinterpret_cast<char const *>(planes.data()), static_cast<std::streamsize>(planes.size()));
+    }
+    else
+        my_log::error("Video frame ", frame.index, " does not match the size of the first frame, skipped.");
+
+    ++m_video_next;
+    lock.unlock();
+    m_video_turn.notify_all();
+}
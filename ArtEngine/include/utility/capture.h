@@ -0,0 +1,97 @@
+#ifndef ARTENGINE_CAPTURE_H
+#define ARTENGINE_CAPTURE_H
+
+/*C+C***********************************************************************//*!
+ \class:    Capture
+
+ \summary:  streaming frame capture, frames are read back asynchronously into
+            a ring of pack buffers, retrieved once their fence signalled and
+            handed through a bounded queue to background encoders writing
+            numbered png files or a single raw y4m video
+
+ \methods:  Capture - Constructor, starts the encoders\n
+         :  ~Capture - Destructor, finishes the queued frames\n
+         :  frame - issue the readback of a frame and collect finished ones\n
+         :  stop - finish every frame in flight and join the encoders\n
+         :  captured - frames handed to the encoders\n
+         :  dropped - frames lost to the drop policy\n
+         :  encoded - frames written\n
+************************************************************************//*C-C*/
+class Capture
+{
+  public:
+    enum class Format
+    {
+        png, //!< numbered png files, path is the file prefix
+        y4m  //!< raw YUV 4:2:0 video, path is the file name
+    };
+
+    enum class Policy
+    {
+        drop, //!< skip frames while the pipeline is saturated
+        block //!< stall the render loop until the pipeline has room
+    };
+
+    // settings of a capture
+    struct Settings
+    {
+        Format format = Format::png;  //!< output format
+        Policy policy = Policy::drop; //!< behaviour when saturated
+        int fps = 60;                 //!< frame rate stored in the y4m header
+        int encoders = 2;             //!< background encoder threads
+        size_t queue = 8;             //!< retrieved frames waiting for an encoder
+        size_t readbacks = 3;         //!< pack buffers in flight
+    };
+
+    explicit Capture(std::string path, Settings settings = Settings());
+    ~Capture();
+
+    Capture(Capture const &) = delete;
+    Capture &operator=(Capture const &) = delete;
+
+    void frame(GLuint fbo, glm::ivec2 size, GLenum attach = GL_COLOR_ATTACHMENT0);
+    void frame(Target *target);
+    void stop();
+
+    [[nodiscard]] size_t captured() const;
+    [[nodiscard]] size_t dropped() const;
+    [[nodiscard]] size_t encoded() const;
+
+  private:
+    // retrieved frame, rows bottom to top as read from gl
+    struct Frame
+    {
+        size_t index;                      //!< position in the output sequence
+        glm::ivec2 size;                   //!< pixel dimensions
+        std::vector<unsigned char> pixels; //!< RGBA8 pixels
+    };
+
+    void collect(bool block);
+    bool push(Frame &&frame, bool block);
+    void encode();
+    void write_png(Frame const &frame);
+    void write_y4m(Frame const &frame);
+
+    std::string m_path;                                 //!< output prefix or file
+    Settings m_settings;                                //!< capture settings
+    std::vector<std::unique_ptr<Readback>> m_readbacks; //!< pack buffer ring
+    size_t m_issued = 0;                                //!< readbacks issued
+    size_t m_retrieved = 0;                             //!< readbacks retrieved, oldest pending one
+    std::deque<Frame> m_queue;                          //!< frames waiting for an encoder
+    std::mutex m_mutex;                                 //!< guards the queue
+    std::condition_variable m_available;                //!< signalled for queued frames
+    std::condition_variable m_space;                    //!< signalled when the queue has room
+    std::vector<std::thread> m_encoders;                //!< encoder threads
+    bool m_stopping = false;                            //!< encoders exit once the queue is empty
+    std::ofstream m_video;                              //!< y4m output
+    std::mutex m_video_mutex;                           //!< orders the y4m frames
+    std::condition_variable m_video_turn;               //!< signalled after every y4m frame
+    size_t m_video_next = 0;                            //!< next y4m frame to write
+    glm::ivec2 m_video_size{0};                         //!< dimensions fixed by the first frame
+    std::atomic<size_t> m_captured = 0;                 //!< frames queued
+    std::atomic<size_t> m_dropped = 0;                  //!< frames skipped
+    std::atomic<size_t> m_encoded = 0;                  //!< frames written
+
+}; // class Capture
+
+#endif // ARTENGINE_CAPTURE_H
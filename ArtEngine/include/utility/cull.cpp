@@ -0,0 +1,159 @@
+#include "../pch.h"
+
+/*M+M***********************************************************************//*!
+ \method:   Cull::Cull
+
+ \summary:  create the culling stage of a built batch
+
+ \args:     batch - batch to cull, must be built before culling
+ \args:     shader - path to the culling compute shader
+************************************************************************//*M-M*/
+Cull::Cull(Batch *batch, std::string shader)
+    : m_batch(batch)
+    , m_compute(shader, {"bounds", batch->m_transforms_name, "commands", "culled", "draw_count"})
+    , m_indirect_count(GLEW_ARB_indirect_parameters)
+{
+    m_compute.interface({"bounds", batch->m_transforms_name, "commands", "culled", "draw_count"});
+    m_count.fill(2, static_cast<GLuint *>(nullptr));
+
+    update();
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Cull::update
+
+ \summary:  upload the model space bounding volumes of the batched models and
+            size the output commands, call after a bounding volume changes
+            or the batch was rebuilt
+
+ \modifies: [m_bounds, m_arrays, m_elements]
+************************************************************************//*M-M*/
+void Cull::update()
+{
+    // output commands mirror the commands of the batch
+    m_arrays.fill(m_batch->m_array_draws.size() * 4, static_cast<GLuint *>(nullptr));
+    m_elements.fill(m_batch->m_element_draws.size() * 5, static_cast<GLuint *>(nullptr));
+
+    if (m_batch->m_models.empty())
+        return;
+
+    std::vector<Bounds> bounds;
+    bounds.reserve(m_batch->m_models.size());
+    for (auto const *model : m_batch->m_models)
+        bounds.push_back({glm::vec4(model->sphere.center, model->sphere.radius), //
+                          glm::vec4(model->aabb.min, 1.0f),                      //
+                          glm::vec4(model->aabb.max, 1.0f)});
+    m_bounds.fill(bounds);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Cull::dispatch
+
+ \summary:  cull every draw of the batch against the view frustum and compact
+            the visible draws, the results stay on the gpu
+
+ \args:     view_projection - world space to clip space matrix
+************************************************************************//*M-M*/
+void Cull::dispatch(glm::mat4 const &view_projection)
+{
+    ART_PROFILE_GPU("Cull Dispatch");
+
+    // reset the counters, cleared commands draw nothing when the count is not read by the gpu
+    GLuint const zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_count.index);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    if (!m_indirect_count)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_arrays.index);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_elements.index);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    m_compute.use();
+    m_compute.uniform("planes", planes(view_projection));
+    m_compute.bind<Bounds>("bounds", &m_bounds);
+    m_compute.bind<glm::mat4>(m_batch->m_transforms_name, &m_batch->m_transforms);
+    m_compute.bind<GLuint>("draw_count", &m_count);
+
+    // cull each command list, the stride is the number of fields of a command
+    auto cull = [&](Buffer *commands, Buffer *culled, size_t draws, int stride, int slot) {
+        if (!draws)
+            return;
+        m_compute.uniform("draws", static_cast<int>(draws));
+        m_compute.uniform("stride", stride);
+        m_compute.uniform("slot", slot);
+        m_compute.bind<GLuint>("commands", commands);
+        m_compute.bind<GLuint>("culled", culled);
+        m_compute.dispatch(static_cast<int>(draws + m_local_size - 1) / m_local_size, 1, 1, false);
+    };
+    cull(&m_batch->m_arrays, &m_arrays, m_batch->m_array_draws.size(), 4, 0);
+    cull(&m_batch->m_elements, &m_elements, m_batch->m_element_draws.size(), 5, 1);
+
+    // make the commands and counts visible to the indirect draws
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Cull::render
+
+ \summary:  draw the visible models of the batch, the cpu cost does not depend
+            on the number of models
+
+ \args:     mode - primitive type used to draw the models
+************************************************************************//*M-M*/
+void Cull::render(GLenum mode)
+{
+    glBindVertexArray(m_batch->m_vao);
+    ShaderBase::bind<glm::mat4>(m_batch->m_transforms_name, &m_batch->m_transforms);
+    ShaderBase::bind<glm::vec4>("quantization", &m_batch->m_quantization);
+
+    GLsizei const arrays = static_cast<GLsizei>(m_batch->m_array_draws.size());
+    GLsizei const elements = static_cast<GLsizei>(m_batch->m_element_draws.size());
+
+    if (m_indirect_count)
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, m_count.index);
+
+    if (arrays)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_arrays.index);
+        if (m_indirect_count)
+            glMultiDrawArraysIndirectCountARB(mode, nullptr, 0, arrays, 0);
+        else
+            glMultiDrawArraysIndirect(mode, nullptr, arrays, 0);
+    }
+
+    if (elements)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_elements.index);
+        if (m_indirect_count)
+            glMultiDrawElementsIndirectCountARB(mode, GL_UNSIGNED_INT, nullptr, sizeof(GLuint), elements, 0);
+        else
+            glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, nullptr, elements, 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if (m_indirect_count)
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Cull::planes
+
+ \summary:  extract the normalized frustum planes of a view projection matrix
+            (left, right, bottom, top, near, far)
+
+ \args:     view_projection - world space to clip space matrix
+
+ \return:   std::vector<glm::vec4> - planes as (normal, distance)
+************************************************************************//*M-M*/
+std::vector<glm::vec4> Cull::planes(glm::mat4 const &view_projection)
+{
+    glm::mat4 const m = glm::transpose(view_projection); // rows of the matrix
+
+    std::vector<glm::vec4> p = {m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+    for (auto &plane : p)
+        plane /= glm::length(glm::vec3(plane));
+    return p;
+}
@@ -0,0 +1,45 @@
+#ifndef ARTENGINE_CULL_H
+#define ARTENGINE_CULL_H
+
+// bounding volumes of a batched model in model space (std430 layout)
+struct Bounds
+{
+    glm::vec4 sphere; //!< sphere center (xyz) and radius (w)
+    glm::vec4 min;    //!< aabb min point (xyz)
+    glm::vec4 max;    //!< aabb max point (xyz)
+};
+
+/*C+C***********************************************************************//*!
+ \class:    Cull
+
+ \summary:  gpu frustum culling of a batch, a compute pass compacts the visible
+            draws into indirect command buffers consumed without cpu readback
+
+ \methods:  update - upload the bounding volumes of the batched models\n
+         :  dispatch - cull the batch against a view projection matrix\n
+         :  render - draw the visible models of the batch\n
+         :  planes - extract the frustum planes of a view projection matrix\n
+************************************************************************//*C-C*/
+class Cull
+{
+  public:
+    Cull(Batch *batch, std::string shader = "shader/cull.cs");
+
+    void update();
+    void dispatch(glm::mat4 const &view_projection);
+    void render(GLenum mode = GL_TRIANGLES);
+
+    static std::vector<glm::vec4> planes(glm::mat4 const &view_projection);
+
+    Batch *m_batch;        //!< culled batch
+    Compute m_compute;     //!< culling compute shader
+    Buffer m_bounds;       //!< bounding volume of every draw (ssbo)
+    Buffer m_arrays;       //!< visible non-indexed commands
+    Buffer m_elements;     //!< visible indexed commands
+    Buffer m_count;        //!< visible command counts [arrays, elements]
+    bool m_indirect_count; //!< draw count is read by the gpu (ARB_indirect_parameters)
+    int m_local_size = 64; //!< local_size_x of the compute shader
+
+}; // class Cull
+
+#endif // ARTENGINE_CULL_H
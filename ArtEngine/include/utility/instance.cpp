@@ -2,22 +2,94 @@
 
 Instance::Instance(Model *model)
     : m_model(model)
+    , m_location(static_cast<GLuint>(model->bindings.size()))
 {
 }
 
+Instance::~Instance()
+{
+    for (auto &[name, s] : m_streams)
+        release(s);
+    for (auto &fence : m_fences)
+        if (fence)
+            glDeleteSync(fence);
+}
+
+// unmap and delete the buffer of a stream, draws still reading it complete first
+void Instance::release(Stream &stream)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, stream.index);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &stream.index);
+    stream.mapped = nullptr;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Instance::advance
+
+ \summary:  fence the draws of this frame and move the streams to the next ring
+            region, waiting only if the gpu still reads that region
+
+ \modifies: [m_fences, m_frame]
+************************************************************************//*M-M*/
+void Instance::advance()
+{
+    if (m_streams.empty())
+        return;
+
+    m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_frame = (m_frame + 1) % frames;
+
+    // the region was last drawn frames - 1 frames ago
+    GLsync &fence = m_fences[m_frame];
+    if (!fence)
+        return;
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    while (result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Instance::flush
+
+ \summary:  bring the region of this frame up to date with ranges written while
+            other regions were current
+
+ \modifies: [m_streams]
+************************************************************************//*M-M*/
+void Instance::flush()
+{
+    for (auto &[name, s] : m_streams)
+    {
+        unsigned char *region = s.mapped + m_frame * s.capacity * s.stride;
+        for (auto const &[first, bytes] : s.pending[m_frame])
+            std::memcpy(region + first, s.shadow.data() + first, bytes);
+        s.pending[m_frame].clear();
+    }
+}
+
 void Instance::render(GLenum mode, int size)
 {
+    flush();
+
     glBindVertexArray(m_model->vao);
+    // point the streams at the region of this frame
+    for (auto const &[name, s] : m_streams)
+        glBindVertexBuffer(s.location, s.index, m_frame * s.capacity * s.stride, s.stride);
+
     if (m_model->indexed)
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_model->idx);
         glDrawElementsInstanced(mode, m_model->size, GL_UNSIGNED_INT, 0, size);
     }
     else
-        glDrawArraysInstanced(mode, 0, m_model->size, m_size);
+        glDrawArraysInstanced(mode, 0, m_model->size, size);
 }
 
 void Instance::render(GLenum mode)
 {
     render(mode, m_size);
-}
\ No newline at end of file
+}
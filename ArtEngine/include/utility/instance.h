@@ -1,53 +1,221 @@
 #ifndef ARTENGINE_INSTANCE_H
 #define ARTENGINE_INSTANCE_H
 
+/*C+C***********************************************************************//*!
+ \class:    Instance
+
+ \summary:  instanced rendering of a model with static per-instance buffers or
+            dynamic per-instance streams
+
+ \methods:  bind - feed a per-instance attribute from a static buffer\n
+         :  stream - create a ring buffered, persistently mapped attribute\n
+         :  update - write a range of instances of a stream\n
+         :  advance - fence the frame and move every stream to the next ring
+                      region, call once per frame after the instanced draws\n
+         :  flush - copy the ranges written in other frames into the region
+                    of this frame\n
+         :  render - draw the instances\n
+************************************************************************//*C-C*/
 class Instance
 {
   public:
     Instance(Model *model);
+    ~Instance();
 
     template <typename T>
     void bind(std::string name, Buffer *buffer);
     template <typename T>
-    void configure(Buffer *buffer);
+    void stream(std::string name, size_t capacity);
+    template <typename T>
+    void update(std::string name, size_t offset, size_t n, T const *data);
+    template <typename T>
+    void update(std::string name, std::vector<T> const &data, size_t offset = 0);
+    template <typename T>
+    void configure(GLuint location);
 
+    void advance();
+    void flush();
     void render(GLenum mode = GL_TRIANGLE_STRIP);
     void render(GLenum mode, int size);
 
-    Model *m_model;                                   //!< model pointer
-    std::unordered_map<std::string, int> m_instances; //!< binding points of attributes
-    size_t m_size;                                    //!< number of instances
+    static size_t constexpr frames = 3; //!< ring regions of a stream (frames in flight)
+
+    // persistently mapped per-instance attribute, one region per frame in flight
+    struct Stream
+    {
+        GLuint index;                      //!< buffer object
+        GLuint location;                   //!< first attribute location (and vertex binding)
+        size_t stride;                     //!< bytes per instance
+        size_t capacity;                   //!< instances per region
+        unsigned char *mapped;             //!< persistent mapping of every region
+        std::vector<unsigned char> shadow; //!< latest data of every instance
+
+        // byte ranges (offset, size) of each region older than the shadow
+        std::array<std::vector<std::pair<size_t, size_t>>, frames> pending;
+    };
+
+    static void release(Stream &stream);
+
+    Model *m_model;                                    //!< model pointer
+    std::unordered_map<std::string, int> m_instances;  //!< binding points of attributes
+    std::unordered_map<std::string, Stream> m_streams; //!< dynamic per-instance attributes
+    std::array<GLsync, frames> m_fences{};             //!< fence of the draws reading each region
+    size_t m_frame = 0;                                //!< ring region written and drawn this frame
+    GLuint m_location;                                 //!< next free attribute location
+    size_t m_size = 0;                                 //!< number of instances
 
 }; // class Instance
 
 template <typename T>
 void Instance::bind(std::string name, Buffer *buffer)
 {
-    m_size = buffer->size;
+    // the instance count is limited by the smallest attribute buffer
+    m_size = m_instances.empty() ? buffer->size : std::min(m_size, buffer->size);
+    GLuint const location = m_location;
     glBindVertexArray(m_model->vao);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer->index);
-    configure<T>(buffer);
-    m_instances[name] = buffer->index;
+    configure<T>(location);
+    glBindVertexBuffer(location, buffer->index, 0, sizeof(T));
+    m_instances[name] = location;
 }
 
+/*M+M***********************************************************************//*!
+ \method:   Instance::stream
+
+ \summary:  create a per-instance attribute streamed through a persistently
+            mapped buffer split into one region per frame in flight, an
+            existing stream of the name is released and its location reused
+
+ \args:     name - attribute name
+ \args:     capacity - maximum number of instances
+
+ \modifies: [m_streams, m_instances, m_location]
+************************************************************************//*M-M*/
 template <typename T>
-void Instance::configure(Buffer *buffer)
+void Instance::stream(std::string name, size_t capacity)
 {
-    glEnableVertexAttribArray(m_model->bindings.size() + m_instances.size());
-    glVertexAttribPointer(m_model->bindings.size() + m_instances.size(), sizeof(T) / sizeof(GLfloat), GL_FLOAT,
-                          GL_FALSE, 0, (void *)0);
-    glVertexAttribDivisor(m_model->bindings.size() + m_instances.size(), 1);
+    static GLbitfield constexpr flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    // a stream replacing one of the same name keeps its attribute location
+    GLuint const location = m_location;
+    auto const existing = m_streams.find(name);
+    Stream s;
+    s.location = location;
+    if (existing != m_streams.end())
+    {
+        s.location = existing->second.location;
+        release(existing->second);
+        m_streams.erase(existing);
+    }
+    s.stride = sizeof(T);
+    s.capacity = capacity;
+    s.shadow.resize(capacity * sizeof(T));
+
+    // immutable storage mapped once for the lifetime of the stream
+    glGenBuffers(1, &s.index);
+    glBindBuffer(GL_ARRAY_BUFFER, s.index);
+    glBufferStorage(GL_ARRAY_BUFFER, frames * capacity * sizeof(T), nullptr, flags);
+    s.mapped =
+        static_cast<unsigned char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, frames * capacity * sizeof(T), flags));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(m_model->vao);
+    configure<T>(s.location);
+    glBindVertexBuffer(s.location, s.index, m_frame * capacity * sizeof(T), sizeof(T));
+    if (s.location != location)
+        m_location = location;
+
+    m_size = m_instances.empty() ? capacity : std::min(m_size, capacity);
+    m_instances[name] = s.location;
+    m_streams[name] = std::move(s);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Instance::update
+
+ \summary:  write a range of instances of a stream, the range is visible to the
+            draws of this frame and copied to the other regions when they come
+            back around the ring
+
+ \args:     name - attribute name
+ \args:     offset - first instance to write
+ \args:     n - number of instances to write
+ \args:     data - instance data
+************************************************************************//*M-M*/
+template <typename T>
+void Instance::update(std::string name, size_t offset, size_t n, T const *data)
+{
+    auto it = m_streams.find(name);
+    if (it == m_streams.end() || sizeof(T) != it->second.stride || offset + n > it->second.capacity)
+    {
+        my_log::error("Stream ", name, " can not be updated with this range.");
+        return;
+    }
+
+    Stream &s = it->second;
+    size_t const first = offset * s.stride;
+    size_t const bytes = n * s.stride;
+    std::memcpy(s.shadow.data() + first, data, bytes);
+    std::memcpy(s.mapped + m_frame * s.capacity * s.stride + first, data, bytes);
+
+    // stale ranges of this region covered by the write no longer need a copy
+    std::erase_if(s.pending[m_frame], [&](std::pair<size_t, size_t> const &range) {
+        return range.first >= first && range.first + range.second <= first + bytes;
+    });
+
+    // the other regions still hold the previous data of this range
+    for (size_t f = 0; f < frames; ++f)
+        if (f != m_frame)
+            s.pending[f].emplace_back(first, bytes);
+}
+
+template <typename T>
+void Instance::update(std::string name, std::vector<T> const &data, size_t offset)
+{
+    update(name, offset, data.size(), data.data());
+}
+
+template <typename T>
+void Instance::configure(GLuint location)
+{
+    glEnableVertexAttribArray(location);
+    glVertexAttribFormat(location, sizeof(T) / sizeof(GLfloat), GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(location, location);
+    glVertexBindingDivisor(location, 1);
+    m_location = location + 1;
 }
 
 template <>
-inline void Instance::configure<glm::mat4>(Buffer *buffer)
+inline void Instance::configure<glm::mat4>(GLuint location)
 {
-    for (int i = 0; i < 4; ++i)
+    // a matrix occupies four consecutive locations reading one vertex binding
+    for (GLuint i = 0; i < 4; ++i)
     {
-        glEnableVertexAttribArray(m_model->bindings.size() + m_instances.size() + i);
-        glVertexAttribPointer(m_model->bindings.size() + m_instances.size() + i, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(glm::vec4), (void*)(i * sizeof(glm::vec4)));
-        glVertexAttribDivisor(m_model->bindings.size() + m_instances.size() + i, 1);
+        glEnableVertexAttribArray(location + i);
+        glVertexAttribFormat(location + i, 4, GL_FLOAT, GL_FALSE, i * sizeof(glm::vec4));
+        glVertexAttribBinding(location + i, location);
     }
+    glVertexBindingDivisor(location, 1);
+    m_location = location + 4;
+}
+
+template <>
+inline void Instance::configure<GLuint>(GLuint location)
+{
+    glEnableVertexAttribArray(location);
+    glVertexAttribIFormat(location, 1, GL_UNSIGNED_INT, 0);
+    glVertexAttribBinding(location, location);
+    glVertexBindingDivisor(location, 1);
+    m_location = location + 1;
+}
+
+template <>
+inline void Instance::configure<GLint>(GLuint location)
+{
+    glEnableVertexAttribArray(location);
+    glVertexAttribIFormat(location, 1, GL_INT, 0);
+    glVertexAttribBinding(location, location);
+    glVertexBindingDivisor(location, 1);
+    m_location = location + 1;
 }
 
 #endif // ARTENGINE_INSTANCE_H
@@ -8,6 +8,7 @@ Model::Model()
 
 Model::~Model()
 {
+    watch::forget(this);
     glDisableVertexAttribArray(vao);
     glDeleteVertexArrays(1, &vao);
     // delete owned buffers
@@ -45,6 +46,38 @@ void Model::index(Buffer *buffer, bool owned)
         buffers["index"] = buffer;
 }
 
+/*M+M***********************************************************************//*!
+ \method:   Model::positions
+
+ \summary:  read the vertex positions back from the gpu, quantized positions
+            are reconstructed within the aabb
+
+ \return:   std::vector<glm::vec3> - model space position of every vertex
+************************************************************************//*M-M*/
+std::vector<glm::vec3> Model::positions()
+{
+    std::vector<glm::vec3> points(size);
+    if (!quantized)
+    {
+        buffers["in_Position"]->retrieve(points);
+        return points;
+    }
+
+    std::vector<glm::vec<4, std::uint16_t>> offsets(size); // Unorm16<3>, padded to four shorts
+    buffers["in_Position"]->retrieve(offsets);
+    for (size_t i = 0; i < size; ++i)
+        points[i] = origin + glm::vec3(offsets[i]) / 65535.0f * extent;
+    return points;
+}
+
+// vertices stored in the buffers, every detail level of a non-indexed model
+size_t Model::vertices() const
+{
+    if (levels.empty())
+        return size;
+    return levels.back().first + levels.back().count;
+}
+
 void Model::render(GLenum mode)
 {
     glBindVertexArray(vao);
@@ -53,6 +86,8 @@ void Model::render(GLenum mode)
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, idx);
         glDrawElements(mode, size, GL_UNSIGNED_INT, 0);
     }
+    else if (!levels.empty())
+        glDrawArrays(mode, levels[level].first, levels[level].count);
     else
         glDrawArrays(mode, 0, size);
 }
@@ -174,216 +209,127 @@ Gizmo::Gizmo()
 //// ICOSPHERE
 ////////////////////////////////////////////////////////////////////////////////
 
+/*M+M***********************************************************************//*!
+ \method:   Icosphere::Icosphere
+
+ \summary:  sphere approximated by a subdivided icosahedron, the buffers of a
+            subdivision level are shared with every other instance of it
+
+ \args:     radius - circumscribed radius, set as the scale of the model matrix
+ \args:     subdivisions - number of times every triangle is split in four
+
+ \modifies: [model, shared]
+************************************************************************//*M-M*/
 Icosphere::Icosphere(float radius, int subdivisions)
     : Model({"in_Position"}, "icosphere")
     , radius(radius)
     , subdivision(subdivisions)
+    , shared(geometry(subdivisions))
 {
-    build();
-    subdivide();
+    bind<glm::vec3>("in_Position", &shared->vertices);
+    index(&shared->indices);
+    model = glm::scale(glm::mat4(1.0f), glm::vec3(radius));
+}
 
-    bind<glm::vec3>("in_Position", new Buffer(vertices), true);
-    index(new Buffer(std::vector<glm::uvec3>(indices.begin(), indices.end())));
-    size = indices.size() * 3;
+// buffers of a subdivision level, built on first use and released with the last instance
+std::shared_ptr<Icosphere::Geometry> Icosphere::geometry(int subdivisions)
+{
+    static std::unordered_map<int, std::weak_ptr<Geometry>> cache; // gl context thread only
+
+    std::shared_ptr<Geometry> geometry = cache[subdivisions].lock();
+    if (geometry)
+        return geometry;
+
+    std::vector<glm::vec3> vertices = icosahedron();
+    std::vector<GLuint> indices = {
+        0, 1,  2,  0, 2,  3,  0, 3,  4, 0, 4,  5,  0,  5,  1, // 1st row (5 triangles)
+        1, 6,  2,  2, 6,  7,  2, 7,  3, 3, 7,  8,  3,  8,  4, // 2nd row (10 triangles)
+        4, 8,  9,  4, 9,  5,  5, 9, 10, 5, 10, 1,  1, 10,  6, //
+        6, 11, 7,  7, 11, 8,  8, 11, 9, 9, 11, 10, 10, 11, 6  // 3rd row (5 triangles)
+    };
+    for (int i = 0; i < subdivisions; ++i)
+        subdivide(vertices, indices);
+
+    geometry = std::make_shared<Geometry>();
+    geometry->vertices.fill(vertices);
+    geometry->indices.fill(indices);
+    cache[subdivisions] = geometry;
+    return geometry;
 }
 
-std::vector<float> Icosphere::compute_vertices() const
+// the 12 vertices of a unit icosahedron, the poles and two rows of five
+// flat example of the icosahedron vertices and triangles
+//   00  00  00  00  00
+//   /\  /\  /\  /\  /\
+//  /  \/  \/  \/  \/  \
+// 01--02--03--04--05--01
+//  \  /\  /\  /\  /\  /\
+//   \/  \/  \/  \/  \/  \
+//   06--07--08--09--10--06
+//    \  /\  /\  /\  /\  /
+//     \/  \/  \/  \/  \/
+//     11  11  11  11  11
+std::vector<glm::vec3> Icosphere::icosahedron()
 {
     static float constexpr pi = std::numbers::pi_v<float>;
     static float constexpr h_angle = pi / 180 * 72; // 72 degree = 360 / 5;
     static float const v_angle = atanf(1.0f / 2);   // elevation = 26.565 degree
 
-    // compute once and reuse inside the loop
-    static float const cos_v_angle = cosf(v_angle);
-    static float const sin_v_angle = sinf(v_angle);
+    float const z = sinf(v_angle);  // elevation of the rows
+    float const xy = cosf(v_angle); // distance of the rows from the axis
 
-    std::vector<float> v(12 * 3);            // space for 12 vertices (x, y, z)
-    int row_2, row_3;                        // indices
-    float z, xy;                             // coords
+    std::vector<glm::vec3> v(12);
     float h_angle_1 = -pi / 2 - h_angle / 2; // start from -126 degree at 2nd row
     float h_angle_2 = -pi / 2;               // start from -90 degree at 3rd row
 
-    // top vertex (0, 0, r)
-    v[0] = 0;
-    v[1] = 0;
-    v[2] = radius;
-
-    // 10 vertices between 2nd and 3rd row
+    v[0] = glm::vec3(0.0f, 0.0f, 1.0f); // top vertex
     for (int i = 1; i <= 5; ++i)
     {
-        row_2 = i * 3;
-        row_3 = (i + 5) * 3;
-
-        // elevation
-        z = radius * sin_v_angle;
-        xy = radius * cos_v_angle;
-
-        // 2nd row
-        v[row_2] = xy * cosf(h_angle_1);     // xy
-        v[row_2 + 1] = xy * sinf(h_angle_1); // xy
-        v[row_2 + 2] = z;                    // z
-        // 3rd row
-        v[row_3] = xy * cosf(h_angle_2);     // xy
-        v[row_3 + 1] = xy * sinf(h_angle_2); // xy
-        v[row_3 + 2] = -z;                   // z
-
-        // next horizontal angles
+        v[i] = glm::vec3(xy * cosf(h_angle_1), xy * sinf(h_angle_1), z);      // 2nd row
+        v[i + 5] = glm::vec3(xy * cosf(h_angle_2), xy * sinf(h_angle_2), -z); // 3rd row
         h_angle_1 += h_angle;
         h_angle_2 += h_angle;
     }
-
-    // bottom vertex (0, 0, -r)
-    int i = 11 * 3;
-    v[i] = 0;
-    v[i + 1] = 0;
-    v[i + 2] = -radius;
+    v[11] = glm::vec3(0.0f, 0.0f, -1.0f); // bottom vertex
 
     return v;
 }
 
-void Icosphere::add_vertex(float x, float y, float z)
+// split every triangle in four, the midpoint of an edge is created once and shared by
+// both triangles on the edge, linear in the number of triangles
+void Icosphere::subdivide(std::vector<glm::vec3> &vertices, std::vector<GLuint> &indices)
 {
-    vertices.push_back(x);
-    vertices.push_back(y);
-    vertices.push_back(z);
-}
-
-void Icosphere::add_vertices(float const v1[3], float const v2[3], float const v3[3])
-{
-    add_vertex(v1[0], v1[1], v1[2]);
-    add_vertex(v2[0], v2[1], v2[2]);
-    add_vertex(v3[0], v3[1], v3[2]);
-}
-
-void Icosphere::add_indices(unsigned i1, unsigned i2, unsigned i3)
-{
-    indices.push_back(i1);
-    indices.push_back(i2);
-    indices.push_back(i3);
-}
-
-float Icosphere::compute_scale_for_length(const float v[3], float length)
-{
-    // and normalize the vector then re-scale to new radius
-    return length / sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
-}
-
-void Icosphere::compute_half_vertex(float const v1[3], float const v2[3], float length, float new_v[3])
-{
-    new_v[0] = v1[0] + v2[0];
-    new_v[1] = v1[1] + v2[1];
-    new_v[2] = v1[2] + v2[2];
-    float scale = compute_scale_for_length(new_v, length);
-    new_v[0] *= scale;
-    new_v[1] *= scale;
-    new_v[2] *= scale;
-}
-
-void Icosphere::build()
-{
-    // compute the 12 vertices of an icosahedron
-    vertices = compute_vertices();
-
-    // create 20 triangles from the vertices
-    // flat example of the icosahedron vertices and triangles
-    //   00  00  00  00  00
-    //   /\  /\  /\  /\  /\
-    //  /  \/  \/  \/  \/  \
-    // 01--02--03--04--05--01
-    //  \  /\  /\  /\  /\  /\
-    //   \/  \/  \/  \/  \/  \
-    //   06--07--08--09--10--06
-    //    \  /\  /\  /\  /\  /
-    //     \/  \/  \/  \/  \/
-    //     11  11  11  11  11
-
-    // track the vertices for splitting
-    // 1st row (5 triangles)
-    add_indices(0, 1, 2);
-    add_indices(0, 2, 3);
-    add_indices(0, 3, 4);
-    add_indices(0, 4, 5);
-    add_indices(0, 5, 1);
-    // 2nd row (10 triangles)
-    add_indices(1, 6, 2);
-    add_indices(2, 6, 7);
-    add_indices(2, 7, 3);
-    add_indices(3, 7, 8);
-    add_indices(3, 8, 4);
-    add_indices(4, 8, 9);
-    add_indices(4, 9, 5);
-    add_indices(5, 9, 10);
-    add_indices(5, 10, 1);
-    add_indices(1, 10, 6);
-    // 3rd row (5 triangles)
-    add_indices(6, 11, 7);
-    add_indices(7, 11, 8);
-    add_indices(8, 11, 9);
-    add_indices(9, 11, 10);
-    add_indices(10, 11, 6);
-}
-
-void Icosphere::subdivide()
-{
-    std::vector<float> temp_vertices;
-    std::vector<unsigned> temp_indices;
-    int index_count;
-
-    float const *v1, *v2, *v3;             // pointer to original vertices of a triangle
-    float new_v1[3], new_v2[3], new_v3[3]; // new vertex positions
-    unsigned index;                        // new index value
-
-    for (int i = 1; i <= subdivision; ++i)
+    std::unordered_map<std::uint64_t, GLuint> midpoints;
+    midpoints.reserve(indices.size() / 2); // every edge is shared by two triangles
+
+    // index of the vertex halfway between two vertices, projected onto the unit sphere
+    auto const midpoint = [&](GLuint a, GLuint b) {
+        std::uint64_t const key = std::uint64_t(std::min(a, b)) << 32 | std::max(a, b);
+        auto [it, inserted] = midpoints.try_emplace(key, static_cast<GLuint>(vertices.size()));
+        if (inserted)
+            vertices.push_back(glm::normalize(vertices[a] + vertices[b]));
+        return it->second;
+    };
+
+    std::vector<GLuint> split;
+    split.reserve(indices.size() * 4);
+    vertices.reserve(vertices.size() + indices.size() / 2);
+    for (size_t i = 0; i < indices.size(); i += 3)
     {
-        // copy previous information
-        temp_vertices = vertices;
-        temp_indices = indices;
-
-        // clear previous information
-        vertices.clear();
-        indices.clear();
-
-        index = 0;
-        index_count = static_cast<int>(temp_indices.size());
-
-        for (int j = 0; j < index_count; j += 3)
-        {
-            // get 3 vertices and texture coordinates of a triangle
-            v1 = &temp_vertices[temp_indices[j] * 3];
-            v2 = &temp_vertices[temp_indices[j + 1] * 3];
-            v3 = &temp_vertices[temp_indices[j + 2] * 3];
-
-            // compute 3 new vertices by splitting half on each edge
-            //           v1
-            //          / \
-            //   newV1 *---* newV3
-            //        / \ / \
-            //      v2---*---v3
-            //         newV2
-
-            // split each edge in half and get 3 new vertices
-            compute_half_vertex(v1, v2, radius, new_v1);
-            compute_half_vertex(v2, v3, radius, new_v2);
-            compute_half_vertex(v1, v3, radius, new_v3);
-
-            // add new vertices
-            add_vertices(v1, new_v1, new_v3);
-            add_vertices(v2, new_v2, v3);
-
-            //          0
-            //         / \
-            //        1---2
-            //       / \ / \
-            //      3---4---5
-
-            // add 4 new triangles
-            add_indices(index + 0, index + 1, index + 2);
-            add_indices(index + 1, index + 3, index + 4);
-            add_indices(index + 1, index + 4, index + 2);
-            add_indices(index + 4, index + 5, index + 2);
-
-            // next index
-            index += 6;
-        }
+        //           v1
+        //          / \
+        //      m1 *---* m3
+        //        / \ / \
+        //      v2---*---v3
+        //           m2
+        GLuint const v1 = indices[i];
+        GLuint const v2 = indices[i + 1];
+        GLuint const v3 = indices[i + 2];
+        GLuint const m1 = midpoint(v1, v2);
+        GLuint const m2 = midpoint(v2, v3);
+        GLuint const m3 = midpoint(v1, v3);
+
+        split.insert(split.end(), {v1, m1, m3, m1, v2, m2, m1, m2, m3, m3, m2, v3});
     }
-}
\ No newline at end of file
+    indices = std::move(split);
+}
@@ -3,14 +3,28 @@
 
 struct Model
 {
+    // vertex range of a detail level within the model buffers
+    struct Level
+    {
+        GLuint first = 0;   //!< first vertex
+        GLuint count = 0;   //!< number of vertices
+        float error = 0.0f; //!< geometric error of the simplification in model units
+    };
+
     Model();
     ~Model();
     Model(std::vector<std::string> binding, std::string name = "none");
 
     template <typename T>
     void bind(std::string binding, Buffer *buffer, bool owned = false);
+    template <typename T>
+    void bind(GLuint location, Buffer *buffer);
+    template <typename L>
+    void interleave(std::array<std::string, L::count> const &binding, Buffer *buffer, bool owned = false);
     void index(Buffer *buffer, bool owned = false);
     void render(GLenum mode = GL_TRIANGLE_STRIP);
+    [[nodiscard]] std::vector<glm::vec3> positions();
+    [[nodiscard]] size_t vertices() const;
 
     GLuint vao; //!< vertex array
     GLuint idx;
@@ -21,6 +35,15 @@ struct Model
     std::unordered_map<std::string, Buffer *> buffers; //!< owned buffers
     std::string name;                                  //!< model name
 
+    // quantized positions, the shader reconstructs origin + in_Position * extent
+    bool quantized = false; //!< positions are 16 bit offsets within the aabb
+    glm::vec3 origin{0.0f}; //!< position of a zero offset
+    glm::vec3 extent{1.0f}; //!< position range covered by the offsets
+
+    // detail levels, render draws the selected range, size counts the full detail level
+    std::vector<Level> levels; //!< full detail first, empty without lod
+    size_t level = 0;          //!< level drawn by render
+
     std::vector<glm::vec4> color; //!< USED ONLY FOR BSP
 
     // boundary information
@@ -29,15 +52,66 @@ struct Model
 
 }; // struct Model
 
+/*M+M***********************************************************************//*!
+ \method:   Model::bind
+
+ \summary:  feed a named attribute from a buffer, T is a vertex format or a
+            float vector type (see vertex::format_t), the name is looked up
+            once, per frame binds should keep the location and use the
+            location overload
+
+ \args:     binding - attribute name
+ \args:     buffer - vertex buffer, one element of T per vertex
+ \args:     owned - delete the buffer with the model or when it is replaced
+
+ \modifies: [buffers]
+************************************************************************//*M-M*/
 template <typename T>
 void Model::bind(std::string binding, Buffer *buffer, bool owned)
 {
+    bind<T>(static_cast<GLuint>(bindings[binding]), buffer);
+    if (!owned)
+        return;
+
+    Buffer *&slot = buffers[binding];
+    if (slot != buffer)
+        delete slot; // the replaced buffer was owned as well
+    slot = buffer;
+}
+
+template <typename T>
+void Model::bind(GLuint location, Buffer *buffer)
+{
+    using Format = vertex::format_t<T>;
+    glBindVertexArray(vao);
+    glBindVertexBuffer(location, buffer->index, buffer->offset, Format::bytes); // offset of a streamed region
+    vertex::format<Format>(location, location);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Model::interleave
+
+ \summary:  feed several named attributes from one interleaved buffer laid
+            out by L, the buffer uses the binding point of the first attribute
+
+ \args:     binding - attribute names in the order of the layout formats
+ \args:     buffer - vertex buffer, L::stride bytes per vertex
+ \args:     owned - delete the buffer with the model
+
+ \modifies: [buffers]
+************************************************************************//*M-M*/
+template <typename L>
+void Model::interleave(std::array<std::string, L::count> const &binding, Buffer *buffer, bool owned)
+{
+    std::array<GLuint, L::count> locations;
+    for (size_t i = 0; i < L::count; ++i)
+        locations[i] = static_cast<GLuint>(bindings[binding[i]]);
+
     glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer->index);
-    glBindVertexBuffer(bindings[binding], buffer->index, 0, sizeof(T));
-    glVertexAttribFormat(bindings[binding], sizeof(T) / sizeof(GL_FLOAT), GL_FLOAT, GL_FALSE, 0);
+    glBindVertexBuffer(locations[0], buffer->index, buffer->offset, L::stride);
+    L::setup(locations, locations[0]);
     if (owned)
-        buffers[binding] = buffer;
+        buffers[binding[0]] = buffer;
 }
 
 struct Point : public Model
@@ -95,27 +169,28 @@ struct Gizmo : public Model
 
 // Icosphere inspired by Song Ho
 // source: https://www.songho.ca/opengl/gl_sphere.html
+// faces share their vertices through an edge midpoint map, the indexed unit sphere of
+// a subdivision level is built once and shared by every instance, the radius is a scale
 struct Icosphere : public Model
 {
     Icosphere(float radius, int subdivisions);
 
-  private:
-    std::vector<float> compute_vertices() const;
-    void add_vertex(float x, float y, float z);
-    void add_vertices(float const v1[3], float const v2[3], float const v3[3]);
-    void add_indices(unsigned i1, unsigned i2, unsigned i3);
-
-    static float compute_scale_for_length(float const v[3], float length);
-    static void compute_half_vertex(float const v1[3], float const v2[3], float length, float new_v[3]);
-
-    void build();
-    void subdivide();
-
-    float radius;    //!< circumscribed radius
+    float radius;    //!< circumscribed radius, applied through the model matrix
     int subdivision; //!< number of subdivisions
 
-    std::vector<float> vertices;
-    std::vector<unsigned> indices;
+  private:
+    // indexed unit sphere of one subdivision level
+    struct Geometry
+    {
+        Buffer vertices; //!< unit positions
+        Buffer indices;  //!< three indices per triangle
+    };
+
+    static std::shared_ptr<Geometry> geometry(int subdivisions);
+    static std::vector<glm::vec3> icosahedron();
+    static void subdivide(std::vector<glm::vec3> &vertices, std::vector<GLuint> &indices);
+
+    std::shared_ptr<Geometry> shared; //!< buffers of the subdivision level
 };
 
 #endif // ARTENGINE_MODEL_H
@@ -0,0 +1,236 @@
+#include "../pch.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////
+
+// number of components of a pixel format
+static size_t format_components(GLenum format)
+{
+    switch (format)
+    {
+    case GL_RGBA:
+    case GL_BGRA:
+    case GL_RGBA_INTEGER:
+        return 4;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+        return 3;
+    case GL_RG:
+    case GL_RG_INTEGER:
+        return 2;
+    default: // single channel, depth and stencil formats
+        return 1;
+    }
+}
+
+// bytes of a pixel component type
+static size_t type_bytes(GLenum type)
+{
+    switch (type)
+    {
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+        return 2;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+        return 4;
+    default: // GL_UNSIGNED_BYTE, GL_BYTE
+        return 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// READBACK
+////////////////////////////////////////////////////////////////////////////////
+
+Readback::Readback()
+{
+    glGenBuffers(1, &m_pbo);
+}
+
+Readback::~Readback()
+{
+    if (m_fence)
+        glDeleteSync(m_fence);
+    glDeleteBuffers(1, &m_pbo);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Readback::read
+
+ \summary:  issue the copy of a framebuffer region into the pack buffer, the
+            call returns immediately and the pixels arrive a few frames later
+
+ \args:     fbo - framebuffer object, 0 for the window
+ \args:     p - lower left corner of the region
+ \args:     d - dimensions of the region
+ \args:     attach - read buffer (GL_COLOR_ATTACHMENTi, GL_BACK for the window)
+ \args:     format - pixel format
+ \args:     type - pixel component type
+
+ \modifies: [m_pbo, m_fence, m_bytes, m_size, m_pending]
+************************************************************************//*M-M*/
+void Readback::read(GLuint fbo, glm::ivec2 p, glm::ivec2 d, GLenum attach, GLenum format, GLenum type)
+{
+    if (d.x <= 0 || d.y <= 0)
+        return;
+
+    m_size = d;
+    reserve(d.x * d.y * format_components(format) * type_bytes(type));
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glReadBuffer(attach);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); // tightly packed rows
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+    glReadPixels(p.x, p.y, d.x, d.y, format, type, nullptr); // offset into the pack buffer
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    fence();
+}
+
+void Readback::read(Target *target, glm::ivec2 p, glm::ivec2 d, GLenum attach, GLenum format, GLenum type)
+{
+    // bounds check
+    if (p.x < 0 || p.y < 0 || p.x + d.x > static_cast<int>(target->m_width) ||
+        p.y + d.y > static_cast<int>(target->m_height))
+        return;
+    read(target->m_fbo, p, d, attach, format, type);
+}
+
+void Readback::read(Target *target)
+{
+    read(target, glm::ivec2(0), glm::ivec2(target->m_width, target->m_height));
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Readback::read
+
+ \summary:  issue the copy of a buffer range into the pack buffer, e.g. the
+            results of a compute shader
+
+ \args:     buffer - buffer to read
+ \args:     bytes - bytes to read
+ \args:     offset - byte offset of the range, relative to the current region
+                     of a streamed buffer
+
+ \modifies: [m_pbo, m_fence, m_bytes, m_pending]
+************************************************************************//*M-M*/
+void Readback::read(Buffer *buffer, size_t bytes, GLintptr offset)
+{
+    m_size = glm::ivec2(0);
+    reserve(bytes);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer->index);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_pbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, buffer->offset + offset, 0, bytes);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    fence();
+}
+
+void Readback::read(Buffer *buffer)
+{
+    GLint bytes = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer->index);
+    glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    // a streamed buffer exposes a single region
+    if (buffer->frames)
+        bytes = static_cast<GLint>(buffer->capacity);
+    read(buffer, static_cast<size_t>(bytes));
+}
+
+/*M+M***********************************************************************//*!
+ \method:   Readback::ready
+
+ \summary:  poll the fence of the last copy without blocking
+
+ \return:   True, if the copy has completed (or nothing is pending)
+ \return:   False, otherwise
+************************************************************************//*M-M*/
+bool Readback::ready()
+{
+    if (!m_fence)
+        return true;
+
+    // flush once so the fence is guaranteed to signal eventually
+    GLenum const result = glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+        return false;
+
+    glDeleteSync(m_fence);
+    m_fence = nullptr;
+    return true;
+}
+
+void Readback::wait()
+{
+    if (!m_fence)
+        return;
+
+    GLenum result = glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    while (result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    glDeleteSync(m_fence);
+    m_fence = nullptr;
+}
+
+bool Readback::pending() const
+{
+    return m_pending;
+}
+
+// grow the pack buffer to hold the next copy
+void Readback::reserve(size_t bytes)
+{
+    // a new read replaces a copy that was never retrieved
+    if (m_fence)
+    {
+        glDeleteSync(m_fence);
+        m_fence = nullptr;
+    }
+
+    m_bytes = bytes;
+    if (bytes <= m_capacity)
+        return;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_capacity = bytes;
+}
+
+void Readback::fence()
+{
+    m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_pending = true;
+}
+
+// map the completed copy and move it to client memory
+void Readback::copy(size_t bytes, void *data)
+{
+    if (!m_pending)
+    {
+        my_log::error("No readback pending.");
+        return;
+    }
+    wait();
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+    void const *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (mapped)
+    {
+        std::memcpy(data, mapped, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_pending = false;
+}
@@ -0,0 +1,77 @@
+#ifndef ARTENGINE_READBACK_H
+#define ARTENGINE_READBACK_H
+
+/*C+C***********************************************************************//*!
+ \class:    Readback
+
+ \summary:  asynchronous gpu readback, pixels or buffer contents are copied
+            into a pack buffer behind a fence and retrieved frames later
+            without stalling the pipeline
+
+ \methods:  read - issue the copy of a framebuffer region or a buffer\n
+         :  ready - poll the fence without blocking\n
+         :  wait - block until the copy has completed\n
+         :  retrieve - copy the result to client memory, waits if not ready\n
+         :  pending - a copy was issued and not yet retrieved\n
+************************************************************************//*C-C*/
+class Readback
+{
+  public:
+    Readback();
+    ~Readback();
+
+    Readback(Readback const &) = delete;
+    Readback &operator=(Readback const &) = delete;
+
+    void read(GLuint fbo, glm::ivec2 p, glm::ivec2 d, GLenum attach = GL_COLOR_ATTACHMENT0, GLenum format = GL_RGBA,
+              GLenum type = GL_UNSIGNED_BYTE);
+    void read(Target *target, glm::ivec2 p, glm::ivec2 d, GLenum attach = GL_COLOR_ATTACHMENT0,
+              GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+    void read(Target *target);
+    void read(Buffer *buffer, size_t bytes, GLintptr offset = 0);
+    void read(Buffer *buffer);
+
+    [[nodiscard]] bool ready();
+    void wait();
+    [[nodiscard]] bool pending() const;
+
+    template <typename T>
+    void retrieve(size_t n, T *data);
+    template <typename T>
+    void retrieve(std::vector<T> &buffer);
+    template <typename T>
+    void retrieve(T &value);
+
+    GLuint m_pbo;             //!< pack buffer receiving the copy
+    GLsync m_fence = nullptr; //!< signals completion of the copy
+    size_t m_bytes = 0;       //!< bytes of the copy
+    size_t m_capacity = 0;    //!< allocated bytes of the pack buffer
+    glm::ivec2 m_size{0};     //!< pixel dimensions of a framebuffer read
+    bool m_pending = false;   //!< a copy awaits retrieval
+
+  private:
+    void reserve(size_t bytes);
+    void fence();
+    void copy(size_t bytes, void *data);
+
+}; // class Readback
+
+template <typename T>
+void Readback::retrieve(size_t n, T *data)
+{
+    copy(std::min(n * sizeof(T), m_bytes), data);
+}
+
+template <typename T>
+void Readback::retrieve(std::vector<T> &buffer)
+{
+    retrieve(buffer.size(), buffer.data());
+}
+
+template <typename T>
+void Readback::retrieve(T &value)
+{
+    retrieve(1, &value);
+}
+
+#endif // ARTENGINE_READBACK_H
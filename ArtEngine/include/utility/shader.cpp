@@ -1,53 +1,243 @@
 #include "../pch.h"
 
 ////////////////////////////////////////////////////////////////////////////////
-//// SHADER BASE
+//// HELPER FUNCTIONS
 ////////////////////////////////////////////////////////////////////////////////
 
-std::unordered_map<std::string, GLuint> ShaderBase::sbpi; //!< shader binding point index
+// header of a cached program binary
+struct BinaryHeader
+{
+    char magic[4]; // "ARTB"
+    GLenum format; // driver specific binary format
+    GLint length;  // bytes following the header
+};
 
-ShaderBase::ShaderBase()
+// 64 bit fnv-1a hash
+static std::uint64_t fnv1a(std::string_view data, std::uint64_t hash = 14695981039346656037ull)
 {
-    m_program = glCreateProgram(); // generate shader
+    for (unsigned char const c : data)
+        hash = (hash ^ c) * 1099511628211ull;
+    return hash;
 }
 
-ShaderBase::~ShaderBase()
+// text of a gl string, empty if unavailable
+static std::string_view gl_string(GLenum name)
 {
-    glDeleteProgram(m_program);
+    char const *text = reinterpret_cast<char const *>(glGetString(name));
+    return text ? text : "";
 }
 
-std::string ShaderBase::read_glsl_file(std::string filename, int32_t &size)
+// let the driver compile and link on its own threads once per context
+static void parallel_compile()
+{
+    static bool requested = false;
+    if (requested)
+        return;
+    requested = true;
+#ifdef GL_KHR_parallel_shader_compile
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// GLSL FILE CACHE
+////////////////////////////////////////////////////////////////////////////////
+
+// include directive, removed from the file text
+struct GlslInclude
 {
+    size_t offset;    // position in the text where the included file is expanded
+    int line;         // line following the directive
+    std::string path; // normalized path of the included file
+};
 
-    std::ifstream stream(filename);
+// glsl file split at its includes, read once and kept until it changes on disk
+struct GlslFile
+{
+    std::filesystem::file_time_type time; // modification time when read
+    std::string text;                     // content without include directives
+    std::vector<GlslInclude> includes;    // includes in order of appearance
+    size_t version = 0;                   // end of the #version line, 0 if none
+    int version_line = 0;                 // line number of the #version line
+};
+
+static std::unordered_map<std::string, std::shared_ptr<GlslFile const>> glsl_files; // parsed files by path
+static std::mutex glsl_mutex;                                                       // guards the file cache
+
+// skip spaces and tabs
+static size_t skip_blank(std::string_view line, size_t at = 0)
+{
+    while (at < line.size() && (line[at] == ' ' || line[at] == '\t'))
+        ++at;
+    return at;
+}
+
+// read a glsl file and locate its includes and #version line
+static std::shared_ptr<GlslFile const> parse_glsl(std::string const &path, std::filesystem::file_time_type time)
+{
+    std::ifstream stream(path, std::ios::binary);
     if (!stream.is_open())
+        return nullptr;
+    std::string const content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    auto file = std::make_shared<GlslFile>();
+    file->time = time;
+    file->text.reserve(content.size() + 1);
+    std::filesystem::path const directory = std::filesystem::path(path).parent_path();
+
+    int number = 0;
+    for (size_t begin = 0; begin < content.size();)
     {
-        std::cout << "Error: File opening \"" << filename << "\" failed." << std::endl;
-        return "";
+        size_t end = content.find('\n', begin);
+        end = end == std::string::npos ? content.size() : end + 1;
+        std::string_view line(content.data() + begin, end - begin);
+        begin = end;
+        ++number;
+
+        size_t const at = skip_blank(line);
+        if (line.substr(at).starts_with("#include"))
+        {
+            // #include "file", <file> or a bare file name relative to the including file
+            std::string_view name = line.substr(skip_blank(line, at + 8));
+            while (!name.empty() && std::isspace(static_cast<unsigned char>(name.back())))
+                name.remove_suffix(1);
+            if (name.size() >= 2 && (name.front() == '"' || name.front() == '<'))
+                name = name.substr(1, name.size() - 2);
+            std::string const included = (directory / std::string(name)).lexically_normal().string();
+            file->includes.push_back({file->text.size(), number + 1, included});
+            continue;
+        }
+        if (line.substr(at).starts_with("#pragma once"))
+        {
+            file->text += "\n"; // every include is expanded once, keep the line count
+            continue;
+        }
+
+        file->text.append(line);
+        if (line.back() != '\n')
+            file->text += "\n";
+        if (!file->version && line.substr(at).starts_with("#version"))
+        {
+            file->version = file->text.size();
+            file->version_line = number;
+        }
     }
 
-    boost::filesystem::path local_dir = boost::filesystem::path(filename).parent_path();
-    std::stringstream buffer;
-    std::string line;
-    std::string curr_line;
+    return file;
+}
 
-    while (std::getline(stream, curr_line))
+// cached file, read again when its modification time changed
+static std::shared_ptr<GlslFile const> load_glsl(std::string const &path)
+{
+    std::error_code code;
+    auto const time = std::filesystem::last_write_time(path, code);
+    if (code)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(glsl_mutex);
+    auto it = glsl_files.find(path);
+    if (it != glsl_files.end() && it->second->time == time)
+        return it->second;
+
+    auto file = parse_glsl(path, time);
+    if (file)
+        glsl_files[path] = file;
+    return file;
+}
+
+// append a file and, once each, the files it includes
+static bool expand_glsl(std::string const &path, ShaderBase::Source &source, std::unordered_set<std::string> &included,
+                        Defines const *defines)
+{
+    auto const file = load_glsl(path);
+    if (!file)
     {
-        line = curr_line;
-        if (line.substr(0, 9) == "#include ")
+        my_log::error("File opening \"", path, "\" failed.");
+        return false;
+    }
+
+    std::string const index = std::to_string(source.files.size());
+    source.files.push_back(path);
+
+    size_t at = 0;
+    if (defines && !defines->empty())
+    {
+        // definitions follow #version, which has to stay the first directive
+        source.text.append(file->text, 0, file->version);
+        for (auto const &define : *defines)
+            source.text += "#define " + define.name + " " + define.value + "\n";
+        source.text += "#line " + std::to_string(file->version_line + 1) + " " + index + "\n";
+        at = file->version;
+    }
+
+    bool success = true;
+    for (auto const &include : file->includes)
+    {
+        source.text.append(file->text, at, include.offset - at);
+        at = include.offset;
+        if (!included.insert(include.path).second)
         {
-            int include_size = 0;
-            buffer << read_glsl_file((local_dir / line.substr(9)).string(), include_size);
+            source.text += "\n"; // already expanded, keep the line count
+            continue;
         }
-        else
-            buffer << line << "\n"; // line contains no newline characters, so add one here
+
+        source.text += "#line 1 " + std::to_string(source.files.size()) + "\n";
+        success &= expand_glsl(include.path, source, included, nullptr);
+        source.text += "#line " + std::to_string(include.line) + " " + index + "\n";
     }
-    std::string file_content(buffer.str());
+    source.text.append(file->text, at);
+
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// SHADER BASE
+////////////////////////////////////////////////////////////////////////////////
+
+std::unordered_map<std::string, GLuint> ShaderBase::sbpi; //!< shader binding point index
+std::string ShaderBase::cache = "shader_cache";           //!< program binary directory, empty disables caching
+
+ShaderBase::ShaderBase()
+{
+    m_program = glCreateProgram(); // generate shader
+}
+
+ShaderBase::~ShaderBase()
+{
+    watch::forget(this);
+    glDeleteProgram(m_program);
+}
+
+std::string ShaderBase::read_glsl_file(std::string filename, int32_t &size)
+{
+    Source source = preprocess(filename);
+    size = static_cast<int32_t>(source.text.length()); // set size
+    return std::move(source.text);
+}
+
+/*M+M***********************************************************************//*!
+ \method:   ShaderBase::preprocess
+
+ \summary:  expand the includes of a glsl file, files are parsed once and kept
+            in memory until their modification time changes, every file is
+            included at most once, the definitions are injected after #version
+            and #line directives keep compiler messages pointing at the files
 
-    stream.close();
+ \args:     filename - glsl file
+ \args:     defines - definitions selecting a permutation
 
-    size = file_content.length(); // set size
-    return file_content;
+ \return:   Source - expanded source and the files of its #line directives,
+                     empty text if a file could not be read
+************************************************************************//*M-M*/
+ShaderBase::Source ShaderBase::preprocess(std::string const &filename, Defines const &defines)
+{
+    Source source;
+    std::string const path = std::filesystem::path(filename).lexically_normal().string();
+    std::unordered_set<std::string> included{path};
+    if (!expand_glsl(path, source, included, &defines))
+        source.text.clear();
+    return source;
 }
 
 int ShaderBase::add_program(std::string filename, GLenum shader_type)
@@ -83,8 +273,256 @@ void ShaderBase::link(std::string filename)
         error(m_program, false, filename);
 }
 
+/*M+M***********************************************************************//*!
+ \method:   ShaderBase::build
+
+ \summary:  load the program from the binary cache, or issue compiling and
+            linking of every stage without waiting for the result, the status
+            is checked by finish once the program is first needed so many
+            programs compile concurrently on the driver
+
+ \args:     stages - files and types of the stages, receive source and shader
+ \args:     in - attribute names bound to consecutive locations
+ \args:     defines - definitions selecting a permutation
+
+ \modifies: [m_program, m_key, m_pending, m_stages, m_sources, m_in, m_defines]
+************************************************************************//*M-M*/
+void ShaderBase::build(std::vector<Stage> &stages, std::vector<std::string> const &in, Defines const &defines)
+{
+    // the key covers the expanded sources, the attribute locations and the driver
+    std::uint64_t hash = fnv1a(gl_string(GL_VENDOR));
+    hash = fnv1a(gl_string(GL_RENDERER), hash);
+    hash = fnv1a(gl_string(GL_VERSION), hash);
+    for (auto &stage : stages)
+    {
+        if (stage.source.empty()) // a reload passes sources expanded off the main thread
+        {
+            Source source = preprocess(stage.file, defines);
+            stage.source = std::move(source.text);
+            stage.files = std::move(source.files);
+        }
+        hash = fnv1a(std::to_string(stage.type), hash);
+        hash = fnv1a(stage.source, hash);
+    }
+    for (auto const &name : in)
+        hash = fnv1a(name + ";", hash);
+
+    m_sources = stages;
+    for (auto &stage : m_sources)
+        stage.source.clear();
+    m_in = in;
+    m_defines = defines;
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    m_key = key.str();
+
+    if (load_binary(m_key))
+        return;
+
+    parallel_compile();
+    for (auto &stage : stages)
+    {
+        char const *source = stage.source.c_str();
+        GLint const length = static_cast<GLint>(stage.source.length());
+        stage.shader = glCreateShader(stage.type);
+        glShaderSource(stage.shader, 1, &source, &length);
+        glCompileShader(stage.shader);
+        glAttachShader(m_program, stage.shader);
+    }
+    for (size_t i = 0; i < in.size(); ++i)
+        glBindAttribLocation(m_program, static_cast<GLuint>(i), in[i].c_str());
+
+    glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(m_program);
+
+    m_pending = true;
+    m_stages = stages;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   ShaderBase::ready
+
+ \summary:  poll a pending link without blocking when the driver supports
+            KHR_parallel_shader_compile, finishes the program once done
+
+ \return:   True, if the program can be used without stalling
+ \return:   False, otherwise
+************************************************************************//*M-M*/
+bool ShaderBase::ready()
+{
+    if (!m_pending)
+        return true;
+#ifdef GL_KHR_parallel_shader_compile
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        GLint done = GL_FALSE;
+        glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done)
+            return false;
+    }
+#endif
+    finish();
+    return true;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   ShaderBase::finish
+
+ \summary:  check the compile and link status of a pending program, report
+            errors and store the binary of a successful link in the cache
+
+ \modifies: [m_pending, m_stages]
+
+ \return:   True, if the program is usable
+ \return:   False, otherwise
+************************************************************************//*M-M*/
+bool ShaderBase::finish()
+{
+    if (!m_pending)
+        return true;
+    m_pending = false;
+
+    bool success = true;
+    for (auto const &stage : m_stages)
+    {
+        int compiled;
+        glGetShaderiv(stage.shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled)
+        {
+            error(stage.shader, true, stage.file);
+            for (size_t i = 0; i < stage.files.size(); ++i) // source string numbers of the messages
+                my_log::error("  ", i, ": ", stage.files[i]);
+            success = false;
+        }
+    }
+
+    int linked;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+    if (!linked && success)
+    {
+        error(m_program, false, m_stages.empty() ? "" : m_stages[0].file);
+        success = false;
+    }
+
+    if (success)
+        save_binary(m_key);
+    m_stages.clear();
+    return success;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   ShaderBase::reload
+
+ \summary:  build the stages into a new program and replace the current one,
+            the previous program is kept if compiling or linking fails
+
+ \args:     stages - stages of the program, expanded sources are used as given
+
+ \modifies: [m_program]
+
+ \return:   True, if the program was replaced
+ \return:   False, otherwise
+************************************************************************//*M-M*/
+bool ShaderBase::reload(std::vector<Stage> stages)
+{
+    finish();
+    GLuint const previous = m_program;
+    std::vector<Stage> const sources = m_sources;
+
+    m_program = glCreateProgram();
+    build(stages, std::vector<std::string>(m_in), Defines(m_defines));
+    bool const success = finish();
+    for (auto const &stage : stages)
+        glDeleteShader(stage.shader); // flagged for deletion, released with the program
+
+    if (!success)
+    {
+        glDeleteProgram(m_program);
+        m_program = previous;
+        m_sources = sources;
+        return false;
+    }
+
+    glDeleteProgram(previous);
+    for (auto const &name : m_interfaces)
+        glShaderStorageBlockBinding(m_program,
+                                    glGetProgramResourceIndex(m_program, GL_SHADER_STORAGE_BLOCK, name.c_str()),
+                                    sbpi[name]);
+    return true;
+}
+
+// files and types of the stages with the files they include, sources are not kept
+std::vector<ShaderBase::Stage> ShaderBase::stages() const
+{
+    return m_sources;
+}
+
+// definitions of the permutation
+Defines const &ShaderBase::defines() const
+{
+    return m_defines;
+}
+
+// link a program from a cached binary, false if missing, stale or rejected by the driver
+bool ShaderBase::load_binary(std::string const &key)
+{
+    if (cache.empty())
+        return false;
+
+    std::ifstream in(cache + "/" + key + ".bin", std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    BinaryHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::string_view(header.magic, 4) != "ARTB" || header.length <= 0)
+        return false;
+    std::vector<char> binary(header.length);
+    in.read(binary.data(), header.length);
+    if (!in)
+        return false;
+
+    glProgramBinary(m_program, header.format, binary.data(), header.length);
+    int linked;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+    return linked; // a driver update invalidates binaries, the program is rebuilt and the entry replaced
+}
+
+// store the binary of a linked program, skipped when the driver offers no binary format
+void ShaderBase::save_binary(std::string const &key)
+{
+    if (cache.empty())
+        return;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    GLint length = 0;
+    glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (formats <= 0 || length <= 0)
+        return;
+
+    BinaryHeader header{{'A', 'R', 'T', 'B'}, 0, 0};
+    std::vector<char> binary(length);
+    glGetProgramBinary(m_program, length, &header.length, &header.format, binary.data());
+    if (header.length <= 0)
+        return;
+
+    std::error_code code;
+    std::filesystem::create_directories(cache, code);
+    std::ofstream out(cache + "/" + key + ".bin", std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        my_log::error("Unable to write program binary to ", cache, ".");
+        return;
+    }
+    out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    out.write(binary.data(), header.length);
+}
+
 void ShaderBase::use()
 {
+    finish(); // first use waits for a pending link
     m_bound_textures = 0;
     glUseProgram(m_program);
 }
@@ -103,7 +541,7 @@ void ShaderBase::error(GLuint shader, bool is_compile, std::string filename)
     else
         glGetProgramInfoLog(shader, n, &n, info);
 
-    std::cout << "Error: Linker Error (" << filename << "): " << info << std::endl;
+    my_log::error("Linker Error (", filename, "): ", info);
     delete[] info;
 }
 
@@ -123,7 +561,10 @@ void ShaderBase::ssbo(std::vector<std::string> names)
 
 void ShaderBase::interface(std::string name)
 {
+    finish();   // block bindings require the linked program
     ssbo(name); // ensure the binding point exists
+    if (std::find(m_interfaces.begin(), m_interfaces.end(), name) == m_interfaces.end())
+        m_interfaces.push_back(name);
     glShaderStorageBlockBinding(m_program, glGetProgramResourceIndex(m_program, GL_SHADER_STORAGE_BLOCK, name.c_str()),
                                 sbpi[name]);
 }
@@ -141,19 +582,13 @@ void ShaderBase::interface(std::vector<std::string> names)
 Shader::Shader(std::vector<std::string> shaders)
     : ShaderBase()
 {
-    setup(shaders);   // add individual shaders
-    link(shaders[0]); // link the shader program
+    setup(shaders); // compile and link, or load the cached binary
 }
 
 Shader::Shader(std::vector<std::string> shaders, std::vector<std::string> in)
     : ShaderBase()
 {
-    // add individual shaders
-    setup(shaders);
-    for (int i = 0; i < in.size(); ++i)
-        glBindAttribLocation(m_program, i, in[i].c_str());
-    // link the shader program
-    link(shaders[0]);
+    setup(shaders, in); // compile and link, or load the cached binary
 }
 
 Shader::Shader(std::vector<std::string> shaders, std::vector<std::string> in, std::vector<std::string> buffer)
@@ -162,6 +597,12 @@ Shader::Shader(std::vector<std::string> shaders, std::vector<std::string> in, st
     ssbo(buffer);
 }
 
+Shader::Shader(std::vector<std::string> shaders, std::vector<std::string> in, Permutation, Defines const &defines)
+    : ShaderBase()
+{
+    setup(shaders, in, defines); // compile and link the permutation, or load the cached binary
+}
+
 Shader::~Shader()
 {
     glDeleteShader(m_fragment_shader);
@@ -169,23 +610,28 @@ Shader::~Shader()
     glDeleteShader(m_vertex_shader);
 }
 
-void Shader::setup(std::vector<std::string> shaders)
+void Shader::setup(std::vector<std::string> shaders, std::vector<std::string> const &in, Defines const &defines)
 {
     std::vector<std::string> s = shaders;
 
     if (s.size() < 2 || s.size() > 3)
     {
-        std::cout << "Error: Number of shaders not recognized." << std::endl;
+        my_log::error("Number of shaders not recognized.");
         return;
     }
 
-    int index = 0;
-    m_vertex_shader = add_program(s[index++], GL_VERTEX_SHADER);
-
+    std::vector<Stage> stages;
+    stages.push_back({s[0], GL_VERTEX_SHADER});
     if (s.size() == 3) // optional geometry shader
-        m_geometry_shader = add_program(s[index++], GL_GEOMETRY_SHADER);
+        stages.push_back({s[1], GL_GEOMETRY_SHADER});
+    stages.push_back({s.back(), GL_FRAGMENT_SHADER});
+
+    build(stages, in, defines);
 
-    m_fragment_shader = add_program(s[index], GL_FRAGMENT_SHADER);
+    m_vertex_shader = stages.front().shader;
+    if (s.size() == 3)
+        m_geometry_shader = stages[1].shader;
+    m_fragment_shader = stages.back().shader;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -194,9 +640,10 @@ void Shader::setup(std::vector<std::string> shaders)
 
 Compute::Compute(std::string shader)
     : ShaderBase()
-    , m_compute_shader(add_program(shader, GL_COMPUTE_SHADER))
 {
-    link(shader);
+    std::vector<Stage> stages{{shader, GL_COMPUTE_SHADER}};
+    build(stages); // compile and link, or load the cached binary
+    m_compute_shader = stages[0].shader;
 }
 
 Compute::Compute(std::string shader, std::vector<std::string> buffer)
@@ -205,6 +652,14 @@ Compute::Compute(std::string shader, std::vector<std::string> buffer)
     ssbo(buffer);
 }
 
+Compute::Compute(std::string shader, Permutation, Defines const &defines)
+    : ShaderBase()
+{
+    std::vector<Stage> stages{{shader, GL_COMPUTE_SHADER}};
+    build(stages, {}, defines); // compile and link the permutation, or load the cached binary
+    m_compute_shader = stages[0].shader;
+}
+
 Compute::~Compute()
 {
     glDeleteShader(m_compute_shader);
@@ -225,14 +680,14 @@ void Compute::limits()
         return i;
     };
 
-    std::cout << "Max SSBO: " << get_int(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS) << std::endl;
-    std::cout << "Max SSBO Block-Size: " << get_int(GL_MAX_SHADER_STORAGE_BLOCK_SIZE) << std::endl;
-    std::cout << "Max Compute Shader Storage Blocks: " << get_int(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS) << std::endl;
-    std::cout << "Max Shared Storage Size: " << get_int(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE) << std::endl;
+    my_log::out("Max SSBO: ", get_int(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS));
+    my_log::out("Max SSBO Block-Size: ", get_int(GL_MAX_SHADER_STORAGE_BLOCK_SIZE));
+    my_log::out("Max Compute Shader Storage Blocks: ", get_int(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS));
+    my_log::out("Max Shared Storage Size: ", get_int(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE));
 
     int n;
     glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &n);
-    std::cout << "Max Work Groups: " << n << std::endl;
+    my_log::out("Max Work Groups: ", n);
     glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &n);
-    std::cout << "Max Local Size: " << n << std::endl;
+    my_log::out("Max Local Size: ", n);
 }
\ No newline at end of file
@@ -5,16 +5,56 @@
 //// SHADER BASE
 ////////////////////////////////////////////////////////////////////////////////
 
+// preprocessor definition injected after #version, e.g. {"SHADOWS", "1"}
+struct Define
+{
+    std::string name;  //!< macro name
+    std::string value; //!< replacement, may be empty
+};
+
+using Defines = std::vector<Define>;
+
+// tag of the permutation constructors, a braced list of two names could otherwise convert to Defines
+struct Permutation
+{
+};
+
+inline constexpr Permutation permutation{};
+
 class ShaderBase
 {
   public:
+    // expanded glsl source, #line directives refer to the files by index
+    struct Source
+    {
+        std::string text;               //!< expanded source
+        std::vector<std::string> files; //!< source string numbers of the #line directives
+    };
+
+    // shader stage of a program, the source is fully expanded before compiling
+    struct Stage
+    {
+        std::string file;               //!< glsl file
+        GLenum type;                    //!< shader type
+        std::string source;             //!< expanded source
+        GLuint shader = 0;              //!< shader object, 0 when loaded from the binary cache
+        std::vector<std::string> files; //!< files of the expanded source, for error messages
+    };
+
     ShaderBase();
     ~ShaderBase();
 
     static std::string read_glsl_file(std::string filename, int32_t &size);
+    static Source preprocess(std::string const &filename, Defines const &defines = {});
     int add_program(std::string filename, GLenum shader_type);
     void compile(GLuint shader, std::string filename);
     void link(std::string filename);
+    void build(std::vector<Stage> &stages, std::vector<std::string> const &in = {}, Defines const &defines = {});
+    [[nodiscard]] bool ready();
+    bool finish();
+    bool reload(std::vector<Stage> stages);
+    [[nodiscard]] std::vector<Stage> stages() const;
+    [[nodiscard]] Defines const &defines() const;
     void use();
     static void error(GLuint shader, bool is_compile, std::string filename);
 
@@ -34,10 +74,21 @@ class ShaderBase
     void texture(std::string name, const T &t);
 
     static std::unordered_map<std::string, GLuint> sbpi; //!< shader binding point index
+    static std::string cache;                            //!< program binary directory, empty disables caching
 
   protected:
-    GLuint m_program;     //!< shader program id
-    int m_bound_textures; //!< texture indexing
+    bool load_binary(std::string const &key);
+    void save_binary(std::string const &key);
+
+    GLuint m_program;                      //!< shader program id
+    int m_bound_textures;                  //!< texture indexing
+    bool m_pending = false;                //!< link issued, status not yet checked
+    std::string m_key;                     //!< binary cache key of the program
+    std::vector<Stage> m_stages;           //!< stages of a pending link, checked by finish
+    std::vector<Stage> m_sources;          //!< stage files and types without source, kept for reloading
+    std::vector<std::string> m_in;         //!< attribute names bound to consecutive locations
+    Defines m_defines;                     //!< definitions of the permutation
+    std::vector<std::string> m_interfaces; //!< storage blocks bound by interface, restored after a reload
 
 }; // class ShaderBase
 
@@ -45,20 +96,24 @@ template <typename T>
 void ShaderBase::bind(std::string name, Buffer *buffer)
 {
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->index);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sbpi[name], buffer->index);
+    if (buffer->frames) // streamed buffers expose only their current region
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, sbpi[name], buffer->index, buffer->offset,
+                          buffer->size * sizeof(T));
+    else
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sbpi[name], buffer->index);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
 template <typename T>
 void ShaderBase::uniform(std::string name, const T u)
 {
-    std::cout << "Error: Data type not recognized for uniform " << name << "." << std::endl;
+    my_log::error("Data type not recognized for uniform ", name, ".");
 }
 
 template <typename T, size_t N>
 void ShaderBase::uniform(std::string name, const T (&u)[N])
 {
-    std::cout << "Error: Data type not recognized for uniform " << name << "." << std::endl;
+    my_log::error("Data type not recognized for uniform ", name, ".");
 }
 
 template <>
@@ -133,6 +188,12 @@ inline void ShaderBase::uniform(std::string name, const glm::mat4 u)
     glUniformMatrix4fv(glGetUniformLocation(m_program, name.c_str()), 1, GL_FALSE, &u[0][0]);
 }
 
+template <>
+inline void ShaderBase::uniform(std::string name, const std::vector<glm::vec4> u)
+{
+    glUniform4fv(glGetUniformLocation(m_program, name.c_str()), u.size(), &u[0][0]);
+}
+
 template <>
 inline void ShaderBase::uniform(std::string name, const std::vector<glm::mat4> u)
 {
@@ -159,14 +220,16 @@ class Shader : public ShaderBase
     Shader(std::vector<std::string> shaders);
     Shader(std::vector<std::string> shaders, std::vector<std::string> in);
     Shader(std::vector<std::string> shaders, std::vector<std::string> in, std::vector<std::string> buffer);
+    Shader(std::vector<std::string> shaders, std::vector<std::string> in, Permutation, Defines const &defines);
     ~Shader();
 
-    void setup(std::vector<std::string> shaders);
+    void setup(std::vector<std::string> shaders, std::vector<std::string> const &in = {},
+               Defines const &defines = {});
 
   private:
-    GLuint m_vertex_shader;
-    GLuint m_geometry_shader;
-    GLuint m_fragment_shader;
+    GLuint m_vertex_shader = 0;
+    GLuint m_geometry_shader = 0;
+    GLuint m_fragment_shader = 0;
 
 }; // class Shader
 
@@ -174,12 +237,7 @@ template <typename... Args>
 Shader::Shader(std::vector<std::string> shaders, std::vector<std::string> in)
     : ShaderBase()
 {
-    // add individual shaders
-    setup(shaders);
-    for (int i = 0; i < in.size(); ++i)
-        glBindAttribLocation(m_program, i, in[i].c_str());
-    // link the shader program
-    link(shaders[0]);
+    setup(shaders, in); // compile and link, or load the cached binary
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -191,13 +249,14 @@ class Compute : public ShaderBase
   public:
     Compute(std::string shader);
     Compute(std::string shader, std::vector<std::string> buffer);
+    Compute(std::string shader, Permutation, Defines const &defines);
     ~Compute();
 
     void dispatch(int x = 1, int y = 1, int z = 1, bool block = true);
     static void limits();
 
   private:
-    GLuint m_compute_shader;
+    GLuint m_compute_shader = 0;
 
 }; // class Compute
 
@@ -52,7 +52,7 @@ void Target::setup(T &color, T &depth)
     }
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Error: Framebuffer Incomplete." << std::endl;
+        my_log::error("Framebuffer Incomplete.");
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
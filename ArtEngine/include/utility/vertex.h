@@ -0,0 +1,288 @@
+/*+*************************************************************************//*!
+\file:      vertex.h
+
+\summary:   compile-time vertex formats, every attribute format knows its gl
+            type, component count and packed size, a layout places formats
+            interleaved in a single buffer with offsets computed at compile
+            time, so setting up a vertex array is an unrolled sequence of gl
+            calls and compact formats (half floats, normalized bytes, packed
+            10_10_10_2 normals) need no per-model description at runtime
+
+\structs:   Float
+            Half
+            Unorm8
+            Unorm16
+            Snorm10
+            Octahedral
+            Uint16
+            Layout
+
+\functions: format\n
+            pack\n
+
+\origin:    ArtEngine
+
+Copyright (c) 2023 Kenneth Onulak Jr.
+MIT License
+**************************************************************************//*+*/
+#ifndef ARTENGINE_VERTEX_H
+#define ARTENGINE_VERTEX_H
+
+namespace vertex
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//// ATTRIBUTE FORMATS
+////////////////////////////////////////////////////////////////////////////////
+
+// N 32 bit floats, 4 * N bytes
+template <int N>
+struct Float
+{
+    using Value = glm::vec<N, float>;
+
+    static GLint constexpr components = N;             //!< components read by the shader
+    static GLenum constexpr type = GL_FLOAT;           //!< component type
+    static GLboolean constexpr normalized = GL_FALSE;  //!< fixed point mapped to [0, 1] or [-1, 1]
+    static size_t constexpr bytes = N * sizeof(float); //!< bytes per vertex
+    static bool constexpr integer = false;             //!< read as integers by the shader
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        std::memcpy(out, &value, bytes);
+    }
+};
+
+// N 16 bit floats, padded to 4 byte alignment, for colors, uvs and small offsets
+template <int N>
+struct Half
+{
+    using Value = glm::vec<N, float>;
+
+    static GLint constexpr components = N;
+    static GLenum constexpr type = GL_HALF_FLOAT;
+    static GLboolean constexpr normalized = GL_FALSE;
+    static size_t constexpr bytes = (N * sizeof(std::uint16_t) + 3) & ~size_t(3);
+    static bool constexpr integer = false;
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        glm::vec<N, std::uint16_t> const packed = glm::packHalf(value);
+        std::memset(out, 0, bytes);
+        std::memcpy(out, &packed, N * sizeof(std::uint16_t));
+    }
+};
+
+// N unsigned bytes mapped to [0, 1], padded to 4 byte alignment, for colors
+template <int N>
+struct Unorm8
+{
+    using Value = glm::vec<N, float>;
+
+    static GLint constexpr components = N;
+    static GLenum constexpr type = GL_UNSIGNED_BYTE;
+    static GLboolean constexpr normalized = GL_TRUE;
+    static size_t constexpr bytes = (N + 3) & ~size_t(3);
+    static bool constexpr integer = false;
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        glm::vec<N, std::uint8_t> const packed = glm::packUnorm<std::uint8_t>(value);
+        std::memset(out, 0, bytes);
+        std::memcpy(out, &packed, N);
+    }
+};
+
+// N unsigned shorts mapped to [0, 1], padded to 4 byte alignment, for positions quantized within a box
+template <int N>
+struct Unorm16
+{
+    using Value = glm::vec<N, float>;
+
+    static GLint constexpr components = N;
+    static GLenum constexpr type = GL_UNSIGNED_SHORT;
+    static GLboolean constexpr normalized = GL_TRUE;
+    static size_t constexpr bytes = (N * sizeof(std::uint16_t) + 3) & ~size_t(3);
+    static bool constexpr integer = false;
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        glm::vec<N, std::uint16_t> const packed = glm::packUnorm<std::uint16_t>(value);
+        std::memset(out, 0, bytes);
+        std::memcpy(out, &packed, N * sizeof(std::uint16_t));
+    }
+};
+
+// xyz in signed 10 bit mapped to [-1, 1] and w in 2 bits, one word, for normals and tangents
+struct Snorm10
+{
+    using Value = glm::vec3;
+
+    static GLint constexpr components = 4;
+    static GLenum constexpr type = GL_INT_2_10_10_10_REV;
+    static GLboolean constexpr normalized = GL_TRUE;
+    static size_t constexpr bytes = sizeof(std::uint32_t);
+    static bool constexpr integer = false;
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        std::uint32_t const packed = glm::packSnorm3x10_1x2(glm::vec4(value, 0.0f));
+        std::memcpy(out, &packed, bytes);
+    }
+};
+
+// unit vector projected onto an octahedron and unfolded into two signed shorts, for normals,
+// the shader reconstructs z from the folded xy
+struct Octahedral
+{
+    using Value = glm::vec3;
+
+    static GLint constexpr components = 2;
+    static GLenum constexpr type = GL_SHORT;
+    static GLboolean constexpr normalized = GL_TRUE;
+    static size_t constexpr bytes = 2 * sizeof(std::int16_t);
+    static bool constexpr integer = false;
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        glm::vec2 e = glm::vec2(value) / (std::abs(value.x) + std::abs(value.y) + std::abs(value.z));
+        if (value.z < 0.0f) // fold the lower hemisphere over the diagonals
+            e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) *
+                glm::vec2(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+        glm::vec<2, std::int16_t> const packed = glm::packSnorm<std::int16_t>(e);
+        std::memcpy(out, &packed, bytes);
+    }
+};
+
+// N unsigned shorts read as integers, padded to 4 byte alignment, for palette indices
+template <int N>
+struct Uint16
+{
+    using Value = glm::vec<N, std::uint16_t>;
+
+    static GLint constexpr components = N;
+    static GLenum constexpr type = GL_UNSIGNED_SHORT;
+    static GLboolean constexpr normalized = GL_FALSE;
+    static size_t constexpr bytes = (N * sizeof(std::uint16_t) + 3) & ~size_t(3);
+    static bool constexpr integer = true;
+
+    static void encode(Value const &value, unsigned char *out)
+    {
+        std::memset(out, 0, bytes);
+        std::memcpy(out, &value, N * sizeof(std::uint16_t));
+    }
+};
+
+// format of an attribute type, glm vectors and scalars of float map to Float
+template <typename T>
+struct Traits
+{
+    using Format = Float<sizeof(T) / sizeof(float)>;
+};
+
+template <typename T>
+    requires requires { T::bytes; }
+struct Traits<T>
+{
+    using Format = T;
+};
+
+template <typename T>
+using format_t = typename Traits<T>::Format;
+
+/*F+F***********************************************************************//*!
+\function: format
+
+\summary:  describe an attribute of the bound vertex array
+
+\args:     location - attribute location
+\args:     binding - vertex buffer binding point the attribute reads from
+\args:     offset - byte offset of the attribute within a vertex
+************************************************************************//*F-F*/
+template <typename F>
+void format(GLuint location, GLuint binding, GLuint offset = 0)
+{
+    glEnableVertexAttribArray(location);
+    if constexpr (F::integer)
+        glVertexAttribIFormat(location, F::components, F::type, offset);
+    else
+        glVertexAttribFormat(location, F::components, F::type, F::normalized, offset);
+    glVertexAttribBinding(location, binding);
+}
+
+/*F+F***********************************************************************//*!
+\function: pack
+
+\summary:  encode tightly packed components into a format
+
+\args:     values - components of F::Value per vertex, floats unless T is given
+
+\return:   std::vector<unsigned char> - F::bytes per vertex
+************************************************************************//*F-F*/
+template <typename F, typename T = float>
+std::vector<unsigned char> pack(std::type_identity_t<std::span<T const>> values)
+{
+    static size_t constexpr n = sizeof(typename F::Value) / sizeof(T);
+    size_t const count = values.size() / n;
+
+    std::vector<unsigned char> packed(count * F::bytes);
+    for (size_t i = 0; i < count; ++i)
+    {
+        typename F::Value value;
+        std::memcpy(&value, values.data() + i * n, sizeof(value));
+        F::encode(value, packed.data() + i * F::bytes);
+    }
+    return packed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// LAYOUT
+////////////////////////////////////////////////////////////////////////////////
+
+/*S+S***********************************************************************//*!
+\struct:   Layout
+
+\summary:  interleaved vertex of the given formats in declaration order, the
+           offsets and the stride are compile-time constants
+
+\methods:  set - encode an attribute of a vertex\n
+        :  setup - describe every attribute of the bound vertex array\n
+************************************************************************//*S-S*/
+template <typename... Formats>
+struct Layout
+{
+    static size_t constexpr count = sizeof...(Formats); //!< attributes per vertex
+
+    // byte offset of every attribute within a vertex
+    static constexpr std::array<size_t, count> offsets = [] {
+        std::array<size_t, count> result{};
+        size_t offset = 0;
+        size_t i = 0;
+        ((result[i++] = offset, offset += Formats::bytes), ...);
+        return result;
+    }();
+
+    static size_t constexpr stride = (Formats::bytes + ... + 0); //!< bytes per vertex
+
+    template <size_t I>
+    using Format = std::tuple_element_t<I, std::tuple<Formats...>>;
+
+    // encode attribute I of the vertex starting at out
+    template <size_t I>
+    static void set(unsigned char *out, typename Format<I>::Value const &value)
+    {
+        Format<I>::encode(value, out + offsets[I]);
+    }
+
+    // attribute I reads location locations[I], every attribute shares one buffer binding
+    static void setup(std::array<GLuint, count> const &locations, GLuint binding)
+    {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (format<Format<I>>(locations[I], binding, static_cast<GLuint>(offsets[I])), ...);
+        }(std::make_index_sequence<count>());
+    }
+};
+
+} // namespace vertex
+
+#endif // ARTENGINE_VERTEX_H
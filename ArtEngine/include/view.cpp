@@ -20,6 +20,10 @@
              View::window\n
              View::windowed\n
              View::windowed\n
+             View::vsync\n
+             View::adaptive\n
+             View::swap_interval\n
+             View::apply_vsync\n
 
  \origin:    ArtEngine
 
@@ -60,8 +64,7 @@ bool View::init(std::string window_name, int width, int height)
                                 m_height, window_flags);
     if (!m_window)
     {
-        std::cout << "Window could not be created! SDL_Error: ";
-        std::cout << SDL_GetError() << std::endl;
+        my_log::error("Window could not be created! SDL_Error: ", SDL_GetError());
         return false;
     }
     SDL_SetWindowResizable(m_window, SDL_TRUE);
@@ -70,12 +73,11 @@ bool View::init(std::string window_name, int width, int height)
     m_context = SDL_GL_CreateContext(m_window);
     if (!m_context)
     {
-        std::cout << "Context could not be created! SDL_Error: ";
-        std::cout << SDL_GetError() << std::endl;
+        my_log::error("Context could not be created! SDL_Error: ", SDL_GetError());
         return false;
     }
 
-    SDL_GL_SetSwapInterval(m_vsync);
+    apply_vsync();
     // launch GLEW
     glewExperimental = GL_TRUE;
     glewInit();
@@ -107,7 +109,7 @@ bool View::init(std::string window_name, int width, int height)
     glPointSize(m_point_size);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    std::cout << glGetString(GL_VERSION) << std::endl;
+    my_log::out(reinterpret_cast<char const *>(glGetString(GL_VERSION)));
     return true;
 }
 
@@ -124,7 +126,9 @@ void View::quit()
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
 
+    pacing::clear();
     SDL_GL_DeleteContext(m_context);
+    m_context = nullptr;
     SDL_DestroyWindow(m_window);
 }
 
@@ -143,14 +147,19 @@ void View::render()
     if (m_show_interface)
         draw_interface();
 
-    // update the window
-    SDL_GL_SwapWindow(m_window);
+    // update the window, offscreen frames stay in the framebuffer to be read back
+    if (!m_fbo)
+        SDL_GL_SwapWindow(m_window);
+
+    // bounds how far the next frames run ahead of this one
+    pacing::fence();
 }
 
 /*M+M***********************************************************************//*!
  \method:   View::target
 
- \summary:  target main window for drawing
+ \summary:  target main window for drawing, or the offscreen framebuffer in
+            headless mode
 
  \args:     clear_color - rgb color used to clear the window
  \args:     clear_color_bit - toggle to clear color bit, default = true
@@ -158,7 +167,7 @@ void View::render()
 ************************************************************************//*M-M*/
 void View::target(glm::vec3 clear_color, bool clear_color_bit, bool clear_depth_bit)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
     glViewport(0, 0, m_width, m_height);
     glClearColor(clear_color.r, clear_color.g, clear_color.b, 1);
     if (clear_color_bit)
@@ -182,6 +191,13 @@ void View::draw_interface()
     interface();
     // ImGui::ShowDemoWindow(); // Demo-window for examples
 
+    // profiler timeline and flame view while benchmarking
+    if (profiler::enabled)
+        profiler::interface();
+
+    // frame statistics and pacing controls
+    pacing::interface(*this);
+
     ImGui::Render();
     glViewport(0, 0, static_cast<int>(m_io.DisplaySize.x), static_cast<int>(m_io.DisplaySize.y));
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -333,4 +349,40 @@ void View::ccw(bool is_counter_clockwise)
 void View::vsync(bool use_vsync)
 {
     m_vsync = use_vsync;
+    apply_vsync();
+}
+
+void View::adaptive(bool use_adaptive)
+{
+    m_adaptive = use_adaptive;
+    apply_vsync();
+}
+
+int View::swap_interval() const
+{
+    return m_swap_interval;
+}
+
+/*M+M***********************************************************************//*!
+ \method:   View::apply_vsync
+
+ \summary:  set the swap interval of the context, adaptive vsync (-1) needs
+            swap control tear and falls back to regular vsync without it,
+            nothing happens before the context exists
+
+ \modifies: [m_swap_interval]
+************************************************************************//*M-M*/
+void View::apply_vsync()
+{
+    if (!m_context)
+        return;
+
+    int interval = m_vsync ? (m_adaptive ? -1 : 1) : 0;
+    if (SDL_GL_SetSwapInterval(interval) < 0 && interval == -1)
+    {
+        my_log::error("Adaptive vsync unavailable (", SDL_GetError(), "), using vsync.");
+        interval = 1;
+        SDL_GL_SetSwapInterval(interval);
+    }
+    m_swap_interval = SDL_GL_GetSwapInterval();
 }
@@ -22,6 +22,9 @@
              View::window\n
              View::windowed\n
              View::windowed\n
+             View::vsync\n
+             View::adaptive\n
+             View::swap_interval\n
 
  \origin:    ArtEngine
 
@@ -54,6 +57,9 @@
          :  window - accessor to get the window pointer\n
          :  windowed - accessor to get if the window is in windowed mode\n
          :  windowed - accessor to set the windowed mode\n
+         :  vsync - accessor to set if swaps wait for the vertical blank\n
+         :  adaptive - accessor to set if late swaps tear instead of waiting\n
+         :  swap_interval - accessor to get the swap interval in effect\n
 ************************************************************************//*C-C*/
 class View
 {
@@ -91,14 +97,20 @@ class View
 
     void ccw(bool is_counter_clockwise);
     void vsync(bool use_vsync);
+    void adaptive(bool use_adaptive);
+    [[nodiscard]] int swap_interval() const;
+
+  private:
+    void apply_vsync();
 
   public:
     // window
     unsigned int m_width;  //!< window width
     unsigned int m_height; //!< window height
 
-    SDL_Window *m_window;    //!< window pointer
-    SDL_GLContext m_context; //!< render context
+    SDL_Window *m_window;              //!< window pointer
+    SDL_GLContext m_context = nullptr; //!< render context
+    GLuint m_fbo = 0;                  //!< framebuffer targeted by the view, 0 for the window
 
     // interface
     ImGuiIO m_io;                  //!< ImGui inputs/outputs
@@ -109,6 +121,8 @@ class View
     bool m_windowed = false;        //!< is the view windowed
     bool m_fullscreen = false;      //!< is the view fullscreen
     bool m_vsync = true;            //!< monitor synced with gpu
+    bool m_adaptive = false;        //!< late frames tear instead of waiting a refresh (swap interval -1)
+    int m_swap_interval = 0;        //!< swap interval in effect, -1 for adaptive vsync
     bool m_ccw = true;              //!< use counter-clockwise winding
     unsigned int m_anti_alias = 16; //!< antialiasing samples
     float m_line_width = 1.0f;      //!< line width